@@ -1,102 +1,73 @@
 #include "buffer/buffer_pool_manager.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
 #include "glog/logging.h"
 #include "page/bitmap_page.h"
 
-static const char EMPTY_PAGE_DATA[PAGE_SIZE] = {0};
-
-BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager)
+BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, size_t num_instances,
+                                     ReplacerType replacer_type)
     : pool_size_(pool_size), disk_manager_(disk_manager) {
-  pages_ = new Page[pool_size_];
-  replacer_ = new LRUReplacer(pool_size_);
-  for (size_t i = 0; i < pool_size_; i++) {
-    free_list_.emplace_back(i);
+  ASSERT(num_instances > 0 && num_instances <= pool_size, "Invalid number of buffer pool instances.");
+  // 把frame尽量平均地分到每个分片上，多出来的给前面的分片
+  for (size_t i = 0; i < num_instances; i++) {
+    size_t instance_size = pool_size / num_instances + (i < pool_size % num_instances ? 1 : 0);
+    instances_.emplace_back(new BufferPoolManagerInstance(instance_size, disk_manager_, replacer_type));
+  }
+  if (disk_manager_->IsReadOnly()) {
+    mapped_page_count_ = disk_manager_->GetMappedPageCount();
+    mapped_pages_.reset(new atomic<Page *>[mapped_page_count_]);
+    for (size_t i = 0; i < mapped_page_count_; i++) {
+      mapped_pages_[i].store(nullptr, memory_order_relaxed);
+    }
   }
 }
 
+static constexpr uint32_t WARM_UP_FILE_MAGIC = 0x4D535755;  // "MSWU"
+
 BufferPoolManager::~BufferPoolManager() {
-  for (auto page : page_table_) {
-    FlushPage(page.first);
+  warm_up_stopped_ = true;
+  if (warm_up_thread_.joinable()) warm_up_thread_.join();
+  StopPageCleaner();
+  {
+    std::lock_guard<mutex> guard(prefetch_latch_);
+    prefetch_stopped_ = true;
+  }
+  prefetch_wakeup_.notify_all();
+  if (prefetch_thread_.joinable()) prefetch_thread_.join();
+  for (auto instance : instances_) {
+    delete instance;
+  }
+  for (size_t i = 0; i < mapped_page_count_; i++) {
+    delete mapped_pages_[i].load();
   }
-  delete[] pages_;
-  delete replacer_;
 }
 
-/**
- * TODO: Student Implement
- */
-Page *BufferPoolManager::FetchPage(page_id_t page_id) {
-  // 1.     Search the page table for the requested page (P).
-  // 1.1    If P exists, pin it and return it immediately.
-  // 1.2    If P does not exist, find a replacement page (R) from either the free list or the replacer.
-  //        Note that pages are always found from the free list first.
-  // 2.     If R is dirty, write it back to the disk.
-  // 3.     Delete R from the page table and insert P.
-  // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
-
+Page *BufferPoolManager::FetchPage(page_id_t page_id, BufferAccessStrategy *strategy) {
   // page_id 有范围
   if (!(page_id >= 0 && page_id <= MAX_VALID_PAGE_ID)) return nullptr;
-
-  frame_id_t frame_id;  // page_id对应的buffer frame标号
-
-  // 1.1 page_id已在buffer中
-  if (page_table_.find(page_id) != page_table_.end()) {
-    frame_id = page_table_[page_id];
-    replacer_->Pin(frame_id);
-    pages_[frame_id].pin_count_++;
-    return &pages_[frame_id];
-  }
-
-  // 1.2
-  // get frame_id
-  if (!free_list_.empty()) {  // buffer还有空间
-    frame_id = free_list_.front();
-    free_list_.pop_front();
-  } else {                                              // buffer已经没有空间
-    if (!replacer_->Victim(&frame_id)) return nullptr;  // 所有数据页都被固定
-    // dirty处理
-    if (pages_[frame_id].is_dirty_) FlushPage(pages_[frame_id].page_id_);
-    page_table_.erase(pages_[frame_id].page_id_);
-  }
-  page_table_[page_id] = frame_id;                           // page_id与frame_id关联
-  disk_manager_->ReadPage(page_id, pages_[frame_id].data_);  // 从disk加载数据
-  pages_[frame_id].pin_count_ = 1;                           // 第一次加入到buffer，所以pin_count为1
-  pages_[frame_id].is_dirty_ = false;
-  pages_[frame_id].page_id_ = page_id;
-  replacer_->Pin(frame_id);
-
-  return &pages_[frame_id];
+  if (disk_manager_->IsReadOnly()) return FetchMappedPage(page_id);
+  return GetInstance(page_id)->FetchPage(page_id, strategy == nullptr ? nullptr : strategy->GetRing(page_id));
 }
 
 /**
  * 分配一个新的数据页，并将逻辑页号于page_id中返回；
  */
-Page *BufferPoolManager::NewPage(page_id_t &page_id) {
+Page *BufferPoolManager::NewPage(page_id_t &page_id, PageRun *run) {
   // 0.   Make sure you call AllocatePage!
-  // 1.   If all the pages in the buffer pool are pinned, return nullptr.
-  // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
-  // 3.   Update P's metadata, zero out memory and add P to the page table.
-  // 4.   Set the page ID output parameter. Return a pointer to P.
-
-  frame_id_t frame_id;
-  if (!free_list_.empty()) {  // buffer还有空间
-    frame_id = free_list_.front();
-    free_list_.pop_front();
-  } else {                                              // buffer已经没有空间
-    if (!replacer_->Victim(&frame_id)) return nullptr;  // 所有数据页都被固定
-    // dirty处理
-    if (pages_[frame_id].is_dirty_) FlushPage(pages_[frame_id].page_id_);
-    page_table_.erase(pages_[frame_id].page_id_);
-  }
-  // 修改metadata
-  page_id = AllocatePage();
-  pages_[frame_id].page_id_ = page_id;
-  pages_[frame_id].pin_count_ = 1;
-  pages_[frame_id].ResetMemory();
-  pages_[frame_id].is_dirty_ = false;
-  page_table_[page_id] = frame_id;  // 将page_id与frame_id关联
-
-  return &pages_[frame_id];
+  // 1.   Route the new page to the shard it hashes to.
+  // 2.   If that shard is full of pinned pages, give the page id back to the disk manager.
+  page_id = AllocatePage(run);
+  if (page_id == INVALID_PAGE_ID) return nullptr;
+  Page *page = GetInstance(page_id)->NewPage(page_id);
+  if (page == nullptr) {
+    DeallocatePage(page_id);
+    page_id = INVALID_PAGE_ID;
+  }
+  return page;
 }
 
 /**
@@ -104,57 +75,66 @@ Page *BufferPoolManager::NewPage(page_id_t &page_id) {
  */
 bool BufferPoolManager::DeletePage(page_id_t page_id) {
   // 0.   Make sure you call DeallocatePage!
-  // 1.   Search the page table for the requested page (P).
-  // 1.   If P does not exist, return true.
-  // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
-  // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
-  if (page_table_.find(page_id) == page_table_.end()) return true;
-  frame_id_t frame_id = page_table_[page_id];
-  if (pages_[frame_id].pin_count_ > 0) return false;
-  page_table_.erase(page_id);
-  pages_[frame_id].ResetMemory();
-  pages_[frame_id].page_id_ = INVALID_PAGE_ID;
-  pages_[frame_id].is_dirty_ = false;
-  free_list_.push_back(frame_id);
+  // 1.   If P is still pinned in its shard, return false. Someone is using the page.
+  // 2.   Otherwise release it on disk as well.
+  if (disk_manager_->IsReadOnly()) return false;
+  if (!GetInstance(page_id)->DeletePage(page_id)) return false;
   DeallocatePage(page_id);
-
-  return false;
+  return true;
 }
 
-/**
- * TODO: Student Implement
- */
 bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
-  if (page_table_.find(page_id) == page_table_.end())
-    return false;  // 此page_id对应的数据页没有加载到buffer中，unpin无从谈起
-
-  frame_id_t frame_id = page_table_[page_id];
+  // 映射的页不计pin
+  if (disk_manager_->IsReadOnly()) return page_id >= 0 && static_cast<size_t>(page_id) < mapped_page_count_;
+  return GetInstance(page_id)->UnpinPage(page_id, is_dirty);
+}
 
-  if (pages_[frame_id].pin_count_ == 0) return false;  // 按理来说初始不为0
-  pages_[frame_id].pin_count_--;
-  if (pages_[frame_id].pin_count_ == 0) {
-    replacer_->Unpin(frame_id);
+void BufferPoolManager::PrefetchPages(const vector<page_id_t> &page_ids) {
+  if (disk_manager_->IsReadOnly()) return;
+  for (auto page_id : page_ids) {
+    // 已经在buffer中的页不必排队
+    if (page_id >= 0 && page_id <= MAX_VALID_PAGE_ID && GetInstance(page_id)->IsResident(page_id)) continue;
+    EnqueuePrefetch(page_id, 1, nullptr, nullptr);
   }
-  pages_[frame_id].is_dirty_ = is_dirty;
+}
 
-  return true;
+void BufferPoolManager::PrefetchPageChain(page_id_t page_id, size_t count, NextPageFunc next_page,
+                                          shared_ptr<BufferAccessStrategy> strategy) {
+  if (disk_manager_->IsReadOnly()) return;
+  EnqueuePrefetch(page_id, count, std::move(next_page), std::move(strategy));
 }
 
 /**
  * 将page_id对应的buffer中的数据写回disk
  */
 bool BufferPoolManager::FlushPage(page_id_t page_id) {
-  if (page_table_.find(page_id) == page_table_.end()) return false;
-
-  frame_id_t frame_id = page_table_[page_id];
-  disk_manager_->WritePage(page_id, pages_[frame_id].data_);
-  pages_[frame_id].is_dirty_ = false;
+  if (disk_manager_->IsReadOnly()) return false;
+  return GetInstance(page_id)->FlushPage(page_id);
+}
 
-  return true;
+Page *BufferPoolManager::FetchMappedPage(page_id_t page_id) {
+  if (static_cast<size_t>(page_id) >= mapped_page_count_) return nullptr;
+  atomic<Page *> &slot = mapped_pages_[page_id];
+  Page *page = slot.load(memory_order_acquire);
+  if (page != nullptr) return page;
+  char *data = disk_manager_->GetMappedPage(page_id);
+  if (data == nullptr) return nullptr;
+  // 两个线程同时第一次访问时只留下一个描述符；压缩存放的页解压到描述符自己的内存里
+  Page *new_page = new Page();
+  if (!disk_manager_->DecompressPage(page_id, data, new_page->GetData())) {
+    delete new_page;
+    new_page = new Page(data);
+  }
+  new_page->page_id_ = page_id;
+  if (slot.compare_exchange_strong(page, new_page, memory_order_acq_rel)) return new_page;
+  delete new_page;
+  return page;
 }
 
-page_id_t BufferPoolManager::AllocatePage() {
-  int next_page_id = disk_manager_->AllocatePage();
+void BufferPoolManager::ReleasePageRun(PageRun *run) { disk_manager_->ReleasePageRun(run); }
+
+page_id_t BufferPoolManager::AllocatePage(PageRun *run) {
+  int next_page_id = disk_manager_->AllocatePage(run);
   return next_page_id;
 }
 
@@ -167,11 +147,198 @@ bool BufferPoolManager::IsPageFree(page_id_t page_id) { return disk_manager_->Is
 // Only used for debug
 bool BufferPoolManager::CheckAllUnpinned() {
   bool res = true;
-  for (size_t i = 0; i < pool_size_; i++) {
-    if (pages_[i].pin_count_ != 0) {
-      res = false;
-      LOG(ERROR) << "page " << pages_[i].page_id_ << " pin count:" << pages_[i].pin_count_ << endl;
-    }
+  for (auto instance : instances_) {
+    res = instance->CheckAllUnpinned() && res;
   }
   return res;
-}
\ No newline at end of file
+}
+
+void BufferPoolManager::StartPageCleaner(double clean_ratio) {
+  std::lock_guard<mutex> guard(cleaner_latch_);
+  if (cleaner_running_ || disk_manager_->IsReadOnly()) return;
+  clean_ratio_ = clean_ratio;
+  cleaner_running_ = true;
+  cleaner_thread_ = thread(&BufferPoolManager::PageCleanerLoop, this);
+}
+
+void BufferPoolManager::StopPageCleaner() {
+  {
+    std::lock_guard<mutex> guard(cleaner_latch_);
+    if (!cleaner_running_) return;
+    cleaner_running_ = false;
+  }
+  cleaner_wakeup_.notify_all();
+  cleaner_thread_.join();
+}
+
+PageCleanerStats BufferPoolManager::GetPageCleanerStats() {
+  PageCleanerStats stats;
+  for (auto instance : instances_) {
+    instance->CollectCleanerStats(&stats);
+  }
+  return stats;
+}
+
+BufferPoolStats BufferPoolManager::GetStats() {
+  BufferPoolStats stats;
+  for (auto instance : instances_) {
+    instance->CollectStats(&stats);
+  }
+  return stats;
+}
+
+bool BufferPoolManager::SaveWarmUpFile(const string &path) {
+  if (disk_manager_->IsReadOnly()) return false;
+  vector<pair<uint32_t, page_id_t>> pages;
+  for (auto instance : instances_) {
+    instance->CollectResidentPages(&pages);
+  }
+  // 访问次数多的在前，次数相同按page_id排
+  sort(pages.begin(), pages.end(), [](const pair<uint32_t, page_id_t> &a, const pair<uint32_t, page_id_t> &b) {
+    return a.first != b.first ? a.first > b.first : a.second < b.second;
+  });
+  // 先写临时文件再rename，中途失败也不会留下半个文件
+  string tmp_path = path + ".tmp";
+  {
+    ofstream out(tmp_path, ios::binary | ios::trunc);
+    uint32_t header[2] = {WARM_UP_FILE_MAGIC, static_cast<uint32_t>(pages.size())};
+    out.write(reinterpret_cast<const char *>(header), sizeof(header));
+    for (auto &page : pages) {
+      out.write(reinterpret_cast<const char *>(&page.second), sizeof(page_id_t));
+    }
+    if (!out.good()) {
+      out.close();
+      remove(tmp_path.c_str());
+      return false;
+    }
+  }
+  return rename(tmp_path.c_str(), path.c_str()) == 0;
+}
+
+void BufferPoolManager::StartWarmUp(const string &path) {
+  if (warm_up_thread_.joinable()) return;
+  // 页都已经映射在内存里，不需要预热
+  if (disk_manager_->IsReadOnly()) {
+    warm_up_finished_ = true;
+    return;
+  }
+  warm_up_thread_ = thread(&BufferPoolManager::WarmUpLoop, this, path);
+}
+
+WarmUpStats BufferPoolManager::GetWarmUpStats() {
+  WarmUpStats stats;
+  stats.finished_ = warm_up_finished_.load();
+  stats.pages_listed_ = warm_up_listed_.load();
+  stats.pages_restored_ = warm_up_restored_.load();
+  stats.elapsed_ms_ = warm_up_elapsed_us_.load() / 1000.0;
+  return stats;
+}
+
+bool BufferPoolManager::Resize(size_t pool_size) {
+  if (pool_size < instances_.size()) return false;
+  std::lock_guard<mutex> guard(resize_latch_);
+  // 和构造时一样分配到各个分片；某个分片缩不下去时保留原大小，其余分片照常调整
+  bool resized = true;
+  size_t actual_size = 0;
+  for (size_t i = 0; i < instances_.size(); i++) {
+    size_t instance_size = pool_size / instances_.size() + (i < pool_size % instances_.size() ? 1 : 0);
+    if (!instances_[i]->Resize(instance_size)) resized = false;
+    actual_size += instances_[i]->GetPoolSize();
+  }
+  pool_size_ = actual_size;
+  return resized;
+}
+
+void BufferPoolManager::PageCleanerLoop() {
+  std::unique_lock<mutex> lock(cleaner_latch_);
+  while (cleaner_running_) {
+    lock.unlock();
+    bool backlog = false;
+    for (auto instance : instances_) {
+      // 某个分片写满了一个batch，说明还有积压，马上进行下一轮
+      if (instance->CleanPages(clean_ratio_) == static_cast<size_t>(PAGE_CLEANER_BATCH_SIZE)) backlog = true;
+    }
+    lock.lock();
+    if (backlog) continue;
+    cleaner_wakeup_.wait_for(lock, std::chrono::milliseconds(PAGE_CLEANER_INTERVAL_MS));
+  }
+}
+
+void BufferPoolManager::EnqueuePrefetch(page_id_t page_id, size_t count, NextPageFunc next_page,
+                                        shared_ptr<BufferAccessStrategy> strategy) {
+  if (!(page_id >= 0 && page_id <= MAX_VALID_PAGE_ID) || count == 0) return;
+  {
+    std::lock_guard<mutex> guard(prefetch_latch_);
+    if (prefetch_stopped_ || prefetch_queue_.size() >= static_cast<size_t>(PREFETCH_QUEUE_CAPACITY)) return;
+    prefetch_queue_.push_back({page_id, count, std::move(next_page), std::move(strategy)});
+    if (!prefetch_running_) {
+      prefetch_running_ = true;
+      prefetch_thread_ = thread(&BufferPoolManager::PrefetchLoop, this);
+    }
+  }
+  prefetch_wakeup_.notify_one();
+}
+
+void BufferPoolManager::PrefetchLoop() {
+  std::unique_lock<mutex> lock(prefetch_latch_);
+  while (true) {
+    prefetch_wakeup_.wait(lock, [this] { return prefetch_stopped_ || !prefetch_queue_.empty(); });
+    if (prefetch_stopped_) return;
+    PrefetchRequest request = std::move(prefetch_queue_.front());
+    prefetch_queue_.pop_front();
+    lock.unlock();
+    // 每次只读一页，链上的下一页重新排到队尾，多个扫描可以交替前进
+    BufferRing *ring = request.strategy_ == nullptr ? nullptr : request.strategy_->GetRing(request.page_id_);
+    page_id_t next_page_id = GetInstance(request.page_id_)->PrefetchPage(request.page_id_, request.next_page_, ring);
+    lock.lock();
+    if (request.remaining_ > 1 && next_page_id >= 0 && next_page_id <= MAX_VALID_PAGE_ID) {
+      prefetch_queue_.push_back(
+          {next_page_id, request.remaining_ - 1, std::move(request.next_page_), std::move(request.strategy_)});
+    }
+  }
+}
+
+void BufferPoolManager::WarmUpLoop(string path) {
+  auto start = std::chrono::steady_clock::now();
+  vector<page_id_t> listed;
+  {
+    ifstream in(path, ios::binary);
+    uint32_t header[2] = {0, 0};
+    if (in.read(reinterpret_cast<char *>(header), sizeof(header)) && header[0] == WARM_UP_FILE_MAGIC) {
+      page_id_t page_id;
+      while (listed.size() < header[1] && in.read(reinterpret_cast<char *>(&page_id), sizeof(page_id))) {
+        listed.push_back(page_id);
+      }
+    }
+  }
+  warm_up_listed_ = listed.size();
+  // 每个分片只取它放得下的最热的那些页，再按page_id排序，读盘时是顺序扫过去的
+  vector<size_t> room(instances_.size());
+  for (size_t i = 0; i < instances_.size(); i++) {
+    room[i] = instances_[i]->GetPoolSize();
+  }
+  vector<page_id_t> to_load;
+  for (auto page_id : listed) {
+    if (!(page_id >= 0 && page_id <= MAX_VALID_PAGE_ID)) continue;
+    size_t &instance_room = room[static_cast<size_t>(page_id) % instances_.size()];
+    if (instance_room == 0) continue;
+    instance_room--;
+    to_load.push_back(page_id);
+  }
+  sort(to_load.begin(), to_load.end());
+  for (auto page_id : to_load) {
+    if (warm_up_stopped_) break;
+    // 上次关闭之后被释放的页不用再读
+    if (!disk_manager_->IsPageFree(page_id) && GetInstance(page_id)->WarmUpPage(page_id)) warm_up_restored_++;
+    warm_up_elapsed_us_ =
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+  }
+  warm_up_elapsed_us_ =
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+  warm_up_finished_ = true;
+  if (!listed.empty()) {
+    WarmUpStats stats = GetWarmUpStats();
+    LOG(INFO) << "buffer pool warm-up restored " << stats.pages_restored_ << " of " << stats.pages_listed_
+              << " pages (" << stats.RestoredRatio() * 100 << "%) in " << stats.elapsed_ms_ << " ms";
+  }
+}
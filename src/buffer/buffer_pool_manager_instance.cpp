@@ -0,0 +1,530 @@
+#include "buffer/buffer_pool_manager_instance.h"
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <new>
+
+#include "glog/logging.h"
+
+/**
+ * 为frame分配一整块连续内存。mmap保证按4KB对齐且清零，可以直接用于O_DIRECT；
+ * 超过2MB时按2MB对齐并建议内核使用大页，减少TLB miss
+ */
+static char *AllocateFrameArena(size_t size, size_t *mapped_size) {
+  static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+  if (size < HUGE_PAGE_SIZE) {
+    *mapped_size = size;
+    void *arena = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (arena == MAP_FAILED) throw std::bad_alloc();
+    return static_cast<char *>(arena);
+  }
+  // 多映射一个大页，然后把首尾不对齐的部分还给内核
+  *mapped_size = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  size_t reserved = *mapped_size + HUGE_PAGE_SIZE;
+  void *raw = mmap(nullptr, reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (raw == MAP_FAILED) throw std::bad_alloc();
+  auto begin = reinterpret_cast<uintptr_t>(raw);
+  uintptr_t aligned = (begin + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  if (aligned > begin) munmap(raw, aligned - begin);
+  if (begin + reserved > aligned + *mapped_size) {
+    munmap(reinterpret_cast<void *>(aligned + *mapped_size), begin + reserved - aligned - *mapped_size);
+  }
+#ifdef MADV_HUGEPAGE
+  madvise(reinterpret_cast<void *>(aligned), *mapped_size, MADV_HUGEPAGE);
+#endif
+  return reinterpret_cast<char *>(aligned);
+}
+
+BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager,
+                                                     ReplacerType replacer_type)
+    : pool_size_(pool_size),
+      disk_manager_(disk_manager),
+      page_table_(new PageTable(pool_size)),
+      cleaned_(pool_size, false),
+      ref_counts_(pool_size, 0) {
+  // 数据页内容放在对齐的arena中，Page只保存元数据，扫描frame元数据时不会碰到数据页
+  while (chunks_.size() * BUFFER_POOL_CHUNK_SIZE < pool_size_) {
+    AddChunk();
+  }
+  cleaner_buffer_ = new (std::align_val_t(PAGE_SIZE)) char[PAGE_CLEANER_BATCH_SIZE * PAGE_SIZE];
+  switch (replacer_type) {
+    case ReplacerType::kLRUK:
+      replacer_ = new LRUKReplacer(pool_size_);
+      break;
+    case ReplacerType::kClock:
+      replacer_ = new CLOCKReplacer(pool_size_);
+      break;
+    case ReplacerType::kLRU:
+    default:
+      replacer_ = new LRUReplacer(pool_size_);
+      break;
+  }
+  for (size_t i = 0; i < pool_size_; i++) {
+    free_list_.emplace_back(i);
+  }
+}
+
+BufferPoolManagerInstance::~BufferPoolManagerInstance() {
+  FlushAllPages();
+  while (!chunks_.empty()) {
+    RemoveChunk();
+  }
+  delete page_table_.load();
+  operator delete[](cleaner_buffer_, std::align_val_t(PAGE_SIZE));
+  delete replacer_;
+}
+
+Page *BufferPoolManagerInstance::FetchPage(page_id_t page_id, BufferRing *ring) {
+  // 1.     Search the page table for the requested page (P).
+  // 1.1    If P exists, pin it and return it immediately.
+  // 1.2    If P does not exist, find a replacement page (R) from either the free list or the replacer.
+  //        Note that pages are always found from the free list first.
+  // 2.     If R is dirty, write it back to the disk.
+  // 3.     Delete R from the page table and insert P.
+  // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
+  std::lock_guard<mutex> guard(latch_);
+  frame_id_t frame_id;  // page_id对应的buffer frame标号
+
+  // 1.1 page_id已在buffer中
+  if (GetPageTable()->Find(page_id, &frame_id)) {
+    replacer_->Pin(frame_id);
+    if (GetFrame(frame_id).pin_count_++ == 0) pinned_frames_++;
+    ref_counts_[frame_id]++;
+    fetch_hits_++;
+    return &GetFrame(frame_id);
+  }
+
+  // 1.2 所有数据页都被固定
+  if (!(ring == nullptr ? TryToFindFreeFrame(&frame_id) : TryToFindRingFrame(ring, page_id, &frame_id))) {
+    pin_waits_++;
+    return nullptr;
+  }
+  fetch_misses_++;
+  LoadFrame(frame_id, page_id);
+  GetFrame(frame_id).pin_count_ = 1;  // 第一次加入到buffer，所以pin_count为1
+  ref_counts_[frame_id] = 1;
+  pinned_frames_++;
+  replacer_->Pin(frame_id);
+
+  return &GetFrame(frame_id);
+}
+
+Page *BufferPoolManagerInstance::NewPage(page_id_t page_id) {
+  // 1.   If all the pages in the buffer pool are pinned, return nullptr.
+  // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
+  // 3.   Update P's metadata, zero out memory and add P to the page table.
+  std::lock_guard<mutex> guard(latch_);
+  frame_id_t frame_id;
+  if (!TryToFindFreeFrame(&frame_id)) {
+    pin_waits_++;
+    return nullptr;
+  }
+  new_pages_++;
+  pinned_frames_++;
+  // 修改metadata
+  GetFrame(frame_id).page_id_ = page_id;
+  GetFrame(frame_id).pin_count_ = 1;
+  GetFrame(frame_id).ResetMemory();
+  // 磁盘上可能残留着这一页被释放前的旧数据，全零的新页必须写回
+  GetFrame(frame_id).is_dirty_ = true;
+  ref_counts_[frame_id] = 1;
+  GetPageTable()->Insert(page_id, frame_id);  // 将page_id与frame_id关联
+  replacer_->Pin(frame_id);               // 新建也算一次访问
+
+  return &GetFrame(frame_id);
+}
+
+page_id_t BufferPoolManagerInstance::PrefetchPage(page_id_t page_id, const NextPageFunc &next_page,
+                                                  BufferRing *ring) {
+  std::lock_guard<mutex> guard(latch_);
+  frame_id_t frame_id;
+  if (!GetPageTable()->Find(page_id, &frame_id)) {
+    if (!(ring == nullptr ? TryToFindFreeFrame(&frame_id) : TryToFindRingFrame(ring, page_id, &frame_id))) {
+      return INVALID_PAGE_ID;
+    }
+    LoadFrame(frame_id, page_id);
+    GetFrame(frame_id).pin_count_ = 0;
+    ref_counts_[frame_id] = 0;
+    // 预读不算一次访问，直接放进replacer等待真正的FetchPage
+    replacer_->Remove(frame_id);
+    replacer_->Unpin(frame_id);
+  }
+  return next_page ? next_page(&GetFrame(frame_id)) : INVALID_PAGE_ID;
+}
+
+bool BufferPoolManagerInstance::WarmUpPage(page_id_t page_id) {
+  std::lock_guard<mutex> guard(latch_);
+  frame_id_t frame_id;
+  if (GetPageTable()->Find(page_id, &frame_id)) return true;
+  // 预热只用空闲frame，不能把启动后已经被访问的页换出去
+  if (free_list_.empty()) return false;
+  frame_id = free_list_.front();
+  free_list_.pop_front();
+  LoadFrame(frame_id, page_id);
+  GetFrame(frame_id).pin_count_ = 0;
+  ref_counts_[frame_id] = 0;
+  replacer_->Remove(frame_id);
+  replacer_->Unpin(frame_id);
+  return true;
+}
+
+bool BufferPoolManagerInstance::DeletePage(page_id_t page_id) {
+  // 1.   Search the page table for the requested page (P).
+  // 1.   If P does not exist, return true.
+  // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
+  // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
+  std::lock_guard<mutex> guard(latch_);
+  frame_id_t frame_id;
+  if (!GetPageTable()->Find(page_id, &frame_id)) return true;
+  if (GetFrame(frame_id).pin_count_ > 0) return false;
+  GetPageTable()->Erase(page_id);
+  // 从replacer中移除，避免被再次选为victim
+  replacer_->Remove(frame_id);
+  GetFrame(frame_id).ResetMemory();
+  GetFrame(frame_id).page_id_ = INVALID_PAGE_ID;
+  GetFrame(frame_id).is_dirty_ = false;
+  cleaned_[frame_id] = false;
+  free_list_.push_back(frame_id);
+  return true;
+}
+
+bool BufferPoolManagerInstance::UnpinPage(page_id_t page_id, bool is_dirty) {
+  std::lock_guard<mutex> guard(latch_);
+  frame_id_t frame_id;
+  // 此page_id对应的数据页没有加载到buffer中，unpin无从谈起
+  if (!GetPageTable()->Find(page_id, &frame_id)) return false;
+
+  if (GetFrame(frame_id).pin_count_ == 0) return false;  // 按理来说初始不为0
+  GetFrame(frame_id).pin_count_--;
+  if (GetFrame(frame_id).pin_count_ == 0) {
+    replacer_->Unpin(frame_id);
+    pinned_frames_--;
+  }
+  // 其他会话可能已经修改过这一页，不能把dirty标记清掉
+  if (is_dirty) {
+    GetFrame(frame_id).is_dirty_ = true;
+    cleaned_[frame_id] = false;
+  }
+
+  return true;
+}
+
+bool BufferPoolManagerInstance::FlushPage(page_id_t page_id) {
+  std::unique_lock<mutex> lock(latch_);
+  // 先让后台线程的旧副本落盘，否则它可能覆盖掉这次写入的新数据
+  WaitForCleaner(lock, page_id);
+  frame_id_t frame_id;
+  if (!GetPageTable()->Find(page_id, &frame_id)) return false;
+
+  disk_manager_->WritePage(page_id, GetFrame(frame_id).data_);
+  if (GetFrame(frame_id).is_dirty_) dirty_writebacks_++;
+  GetFrame(frame_id).is_dirty_ = false;
+
+  return true;
+}
+
+void BufferPoolManagerInstance::FlushAllPages() {
+  std::unique_lock<mutex> lock(latch_);
+  cleaner_done_.wait(lock, [this] { return cleaning_pages_.empty(); });
+  // 所有脏页一起提交，合并后的写请求同时在途，而不是一页一页地等
+  vector<page_id_t> page_ids;
+  vector<const char *> page_data;
+  vector<frame_id_t> frame_ids;
+  for (size_t i = 0; i < pool_size_; i++) {
+    Page &page = GetFrame(i);
+    if (page.page_id_ == INVALID_PAGE_ID || !page.is_dirty_) continue;
+    page_ids.push_back(page.page_id_);
+    page_data.push_back(page.data_);
+    frame_ids.push_back(i);
+    page.is_dirty_ = false;
+  }
+  if (!disk_manager_->WritePages(page_ids, page_data)) {
+    // 没写下去的页还是脏的，frame仍然被latch_保护着
+    for (auto frame_id : frame_ids) {
+      GetFrame(frame_id).is_dirty_ = true;
+    }
+    return;
+  }
+  dirty_writebacks_ += page_ids.size();
+}
+
+bool BufferPoolManagerInstance::TryToFindFreeFrame(frame_id_t *frame_id) {
+  if (!free_list_.empty()) {  // buffer还有空间
+    *frame_id = free_list_.front();
+    free_list_.pop_front();
+    return true;
+  }
+  // 后台线程正在写旧副本、之后又被改脏的页暂时不能换出，否则两次写盘的顺序无法保证
+  vector<frame_id_t> skipped;
+  bool found = false;
+  while (replacer_->Victim(frame_id)) {
+    Page &victim = GetFrame(*frame_id);
+    if (victim.is_dirty_ && cleaning_pages_.count(victim.page_id_) > 0) {
+      skipped.push_back(*frame_id);
+      continue;
+    }
+    found = true;
+    break;
+  }
+  for (auto skipped_frame : skipped) {
+    replacer_->Unpin(skipped_frame);
+  }
+  if (!found) return false;  // 所有数据页都被固定
+  // dirty处理
+  if (GetFrame(*frame_id).is_dirty_) {
+    sync_writes_++;
+    FlushFrame(*frame_id);
+  } else if (cleaned_[*frame_id]) {
+    stalls_avoided_++;
+  }
+  cleaned_[*frame_id] = false;
+  GetPageTable()->Erase(GetFrame(*frame_id).page_id_);
+  evictions_++;
+  return true;
+}
+
+bool BufferPoolManagerInstance::TryToFindRingFrame(BufferRing *ring, page_id_t page_id, frame_id_t *frame_id) {
+  BufferRing::Slot &slot = ring->slots_[ring->next_];
+  ring->next_ = (ring->next_ + 1) % ring->slots_.size();
+  // 这个frame里还是当初由ring装入的页，并且没有人在用，就直接回收，不去动replacer里别人的页
+  bool reusable = false;
+  // 缩小之后ring里可能还记着已经不存在的frame
+  if (slot.frame_id_ != INVALID_FRAME_ID && static_cast<size_t>(slot.frame_id_) < pool_size_) {
+    Page &page = GetFrame(slot.frame_id_);
+    reusable = page.page_id_ == slot.page_id_ && page.pin_count_ == 0 &&
+               !(page.is_dirty_ && cleaning_pages_.count(page.page_id_) > 0);
+  }
+  if (reusable) {
+    *frame_id = slot.frame_id_;
+    replacer_->Remove(*frame_id);
+    FlushFrame(*frame_id);
+    cleaned_[*frame_id] = false;
+    GetPageTable()->Erase(slot.page_id_);
+    evictions_++;
+  } else if (!TryToFindFreeFrame(frame_id)) {
+    return false;
+  }
+  slot.frame_id_ = *frame_id;
+  slot.page_id_ = page_id;
+  return true;
+}
+
+void BufferPoolManagerInstance::LoadFrame(frame_id_t frame_id, page_id_t page_id) {
+  GetPageTable()->Insert(page_id, frame_id);  // page_id与frame_id关联
+  auto cleaning = cleaning_pages_.find(page_id);
+  if (cleaning != cleaning_pages_.end()) {
+    // 后台线程还没写完，磁盘上是旧数据，直接用暂存的副本
+    memcpy(GetFrame(frame_id).data_, cleaning->second, PAGE_SIZE);
+  } else {
+    disk_manager_->ReadPage(page_id, GetFrame(frame_id).data_);  // 从disk加载数据
+  }
+  GetFrame(frame_id).page_id_ = page_id;
+  GetFrame(frame_id).is_dirty_ = false;
+}
+
+void BufferPoolManagerInstance::FlushFrame(frame_id_t frame_id) {
+  if (!GetFrame(frame_id).is_dirty_) return;
+  disk_manager_->WritePage(GetFrame(frame_id).page_id_, GetFrame(frame_id).data_);
+  dirty_writebacks_++;
+  GetFrame(frame_id).is_dirty_ = false;
+}
+
+void BufferPoolManagerInstance::WaitForCleaner(unique_lock<mutex> &lock, page_id_t page_id) {
+  cleaner_done_.wait(lock, [this, page_id] { return cleaning_pages_.count(page_id) == 0; });
+}
+
+size_t BufferPoolManagerInstance::CleanPages(double clean_ratio) {
+  vector<pair<page_id_t, frame_id_t>> candidates;
+  {
+    std::lock_guard<mutex> guard(latch_);
+    // 统计可被替换的frame中有多少是干净的
+    size_t evictable = free_list_.size(), clean = free_list_.size();
+    for (size_t i = 0; i < pool_size_; i++) {
+      Page &page = GetFrame(i);
+      if (page.page_id_ == INVALID_PAGE_ID || page.pin_count_ > 0) continue;
+      evictable++;
+      if (page.is_dirty_) {
+        candidates.emplace_back(page.page_id_, i);
+      } else {
+        clean++;
+      }
+    }
+    size_t target = static_cast<size_t>(clean_ratio * evictable);
+    if (clean >= target || candidates.empty()) return 0;
+    // 按page_id顺序写回，尽量让磁盘写是顺序的
+    size_t batch = min(min(target - clean, candidates.size()), static_cast<size_t>(PAGE_CLEANER_BATCH_SIZE));
+    sort(candidates.begin(), candidates.end());
+    candidates.resize(batch);
+    for (size_t i = 0; i < batch; i++) {
+      frame_id_t frame_id = candidates[i].second;
+      char *staging = cleaner_buffer_ + i * PAGE_SIZE;
+      memcpy(staging, GetFrame(frame_id).data_, PAGE_SIZE);
+      GetFrame(frame_id).is_dirty_ = false;
+      cleaned_[frame_id] = true;
+      cleaning_pages_[candidates[i].first] = staging;
+    }
+  }
+  // 写盘时不持有latch，前台的FetchPage/UnpinPage不受影响；相邻的页合并成一次写
+  vector<page_id_t> page_ids;
+  vector<const char *> page_data;
+  for (size_t i = 0; i < candidates.size(); i++) {
+    page_ids.push_back(candidates[i].first);
+    page_data.push_back(cleaner_buffer_ + i * PAGE_SIZE);
+  }
+  bool is_written = disk_manager_->WritePages(page_ids, page_data);
+  if (!is_written) {
+    // 写失败了：还在缓冲池里的页重新标成脏页，以frame里的数据为准；已经被换出的页只剩暂存的副本，
+    // 副本留在cleaning_pages_里（这期间再读入的话用的是它），放开latch重试
+    vector<page_id_t> retry_ids;
+    vector<const char *> retry_data;
+    {
+      std::lock_guard<mutex> guard(latch_);
+      for (size_t i = 0; i < page_ids.size(); i++) {
+        frame_id_t frame_id;
+        if (GetPageTable()->Find(page_ids[i], &frame_id)) {
+          GetFrame(frame_id).is_dirty_ = true;
+          cleaned_[frame_id] = false;
+          cleaning_pages_.erase(page_ids[i]);
+        } else {
+          retry_ids.push_back(page_ids[i]);
+          retry_data.push_back(page_data[i]);
+        }
+      }
+    }
+    bool is_retried = retry_ids.empty();
+    for (int attempt = 0; attempt < PAGE_CLEANER_WRITE_RETRIES && !is_retried; attempt++) {
+      is_retried = disk_manager_->WritePages(retry_ids, retry_data);
+    }
+    std::lock_guard<mutex> guard(latch_);
+    for (size_t i = 0; i < retry_ids.size() && !is_retried; i++) {
+      // 重试期间又读回来的页，脏页标记会把它写下去；否则这一页就丢了，不能悄悄地继续
+      frame_id_t frame_id;
+      if (GetPageTable()->Find(retry_ids[i], &frame_id)) {
+        GetFrame(frame_id).is_dirty_ = true;
+        cleaned_[frame_id] = false;
+      } else {
+        LOG(FATAL) << "page cleaner failed to write back evicted page " << retry_ids[i];
+      }
+    }
+    cleaning_pages_.clear();
+  } else {
+    std::lock_guard<mutex> guard(latch_);
+    cleaning_pages_.clear();
+  }
+  cleaner_done_.notify_all();
+  if (!is_written) return 0;
+  pages_cleaned_ += candidates.size();
+  dirty_writebacks_ += candidates.size();
+  return candidates.size();
+}
+
+void BufferPoolManagerInstance::CollectCleanerStats(PageCleanerStats *stats) {
+  stats->pages_written_ += pages_cleaned_.load();
+  stats->stalls_avoided_ += stalls_avoided_.load();
+  stats->sync_writes_ += sync_writes_.load();
+}
+
+void BufferPoolManagerInstance::CollectResidentPages(vector<pair<uint32_t, page_id_t>> *pages) {
+  std::lock_guard<mutex> guard(latch_);
+  for (size_t i = 0; i < pool_size_; i++) {
+    if (GetFrame(i).page_id_ != INVALID_PAGE_ID) pages->emplace_back(ref_counts_[i], GetFrame(i).page_id_);
+  }
+}
+
+void BufferPoolManagerInstance::CollectStats(BufferPoolStats *stats) {
+  stats->fetch_hits_ += fetch_hits_.load(std::memory_order_relaxed);
+  stats->fetch_misses_ += fetch_misses_.load(std::memory_order_relaxed);
+  stats->new_pages_ += new_pages_.load(std::memory_order_relaxed);
+  stats->evictions_ += evictions_.load(std::memory_order_relaxed);
+  stats->dirty_writebacks_ += dirty_writebacks_.load(std::memory_order_relaxed);
+  stats->pin_waits_ += pin_waits_.load(std::memory_order_relaxed);
+  stats->pinned_frames_ += pinned_frames_.load(std::memory_order_relaxed);
+}
+
+bool BufferPoolManagerInstance::Resize(size_t pool_size) {
+  std::unique_lock<mutex> lock(latch_);
+  if (pool_size > pool_size_) {
+    while (chunks_.size() * BUFFER_POOL_CHUNK_SIZE < pool_size) {
+      AddChunk();
+    }
+    // 页表的负载因子不能超过0.5，装不下时换一张更大的表
+    if (2 * pool_size > GetPageTable()->Capacity()) {
+      auto *page_table = new PageTable(pool_size);
+      for (size_t i = 0; i < pool_size_; i++) {
+        if (GetFrame(i).page_id_ != INVALID_PAGE_ID) page_table->Insert(GetFrame(i).page_id_, i);
+      }
+      // IsResident不加latch，可能还在读旧表，旧表留到析构时再释放
+      retired_page_tables_.emplace_back(page_table_.exchange(page_table));
+    }
+    cleaned_.resize(pool_size, false);
+    ref_counts_.resize(pool_size, 0);
+    replacer_->Resize(pool_size);
+    for (size_t i = pool_size_; i < pool_size; i++) {
+      free_list_.emplace_back(i);
+    }
+    pool_size_ = pool_size;
+    return true;
+  }
+  if (pool_size == pool_size_) return true;
+
+  // 缩小时先等后台线程写完，再把尾部的frame全部腾空；有页被固定就放弃
+  cleaner_done_.wait(lock, [this] { return cleaning_pages_.empty(); });
+  for (size_t i = pool_size; i < pool_size_; i++) {
+    if (GetFrame(i).page_id_ != INVALID_PAGE_ID && GetFrame(i).pin_count_ > 0) return false;
+  }
+  for (size_t i = pool_size; i < pool_size_; i++) {
+    Page &page = GetFrame(i);
+    replacer_->Remove(i);
+    if (page.page_id_ == INVALID_PAGE_ID) continue;
+    FlushFrame(i);
+    GetPageTable()->Erase(page.page_id_);
+    page.page_id_ = INVALID_PAGE_ID;
+    evictions_++;
+  }
+  free_list_.remove_if([pool_size](frame_id_t frame_id) { return static_cast<size_t>(frame_id) >= pool_size; });
+  cleaned_.resize(pool_size);
+  ref_counts_.resize(pool_size);
+  replacer_->Resize(pool_size);
+  pool_size_ = pool_size;
+  // 不再使用的chunk整个还给系统，最后一个chunk中空出来的frame也释放物理内存
+  while ((chunks_.size() - 1) * BUFFER_POOL_CHUNK_SIZE >= pool_size_) {
+    RemoveChunk();
+  }
+  size_t used = pool_size_ - (chunks_.size() - 1) * BUFFER_POOL_CHUNK_SIZE;
+  madvise(chunks_.back().arena_ + used * PAGE_SIZE, (BUFFER_POOL_CHUNK_SIZE - used) * PAGE_SIZE, MADV_DONTNEED);
+  return true;
+}
+
+void BufferPoolManagerInstance::AddChunk() {
+  FrameChunk chunk;
+  chunk.arena_ = AllocateFrameArena(BUFFER_POOL_CHUNK_SIZE * PAGE_SIZE, &chunk.arena_size_);
+  chunk.pages_ = static_cast<Page *>(operator new[](BUFFER_POOL_CHUNK_SIZE * sizeof(Page)));
+  for (size_t i = 0; i < BUFFER_POOL_CHUNK_SIZE; i++) {
+    new (&chunk.pages_[i]) Page(chunk.arena_ + i * PAGE_SIZE);
+  }
+  chunks_.push_back(chunk);
+}
+
+void BufferPoolManagerInstance::RemoveChunk() {
+  FrameChunk &chunk = chunks_.back();
+  for (size_t i = 0; i < BUFFER_POOL_CHUNK_SIZE; i++) {
+    chunk.pages_[i].~Page();
+  }
+  operator delete[](chunk.pages_);
+  munmap(chunk.arena_, chunk.arena_size_);
+  chunks_.pop_back();
+}
+
+// Only used for debug
+bool BufferPoolManagerInstance::CheckAllUnpinned() {
+  std::lock_guard<mutex> guard(latch_);
+  bool res = true;
+  for (size_t i = 0; i < pool_size_; i++) {
+    if (GetFrame(i).pin_count_ != 0) {
+      res = false;
+      LOG(ERROR) << "page " << GetFrame(i).page_id_ << " pin count:" << GetFrame(i).pin_count_ << endl;
+    }
+  }
+  return res;
+}
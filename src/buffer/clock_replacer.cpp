@@ -0,0 +1,66 @@
+#include "buffer/clock_replacer.h"
+
+CLOCKReplacer::CLOCKReplacer(size_t num_pages) : capacity(num_pages), clock_status(num_pages) {
+  for (auto &status : clock_status) {
+    status.store(0, std::memory_order_relaxed);
+  }
+}
+
+CLOCKReplacer::~CLOCKReplacer() = default;
+
+/**
+ * 转动时钟指针，寻找可以被替换的数据页
+ */
+bool CLOCKReplacer::Victim(frame_id_t *frame_id) {
+  if (capacity == 0) return false;
+  // 第一圈最多清掉所有引用位，第二圈一定能找到victim；转两圈还没有说明没有可替换的数据页
+  for (size_t i = 0; i < 2 * capacity + 1; i++) {
+    size_t frame = clock_hand.fetch_add(1, std::memory_order_relaxed) % capacity;
+    uint8_t status = clock_status[frame].load(std::memory_order_acquire);
+    if (!(status & EVICTABLE_BIT)) continue;
+    if (status & REFERENCE_BIT) {
+      // 给第二次机会；失败说明别的线程刚刚改过这个frame，跳过即可
+      clock_status[frame].compare_exchange_strong(status, EVICTABLE_BIT, std::memory_order_acq_rel);
+      continue;
+    }
+    // 抢占成功的线程才能拿到这个frame
+    if (clock_status[frame].compare_exchange_strong(status, 0, std::memory_order_acq_rel)) {
+      *frame_id = static_cast<frame_id_t>(frame);
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * 数据页固定，不可被替换
+ */
+void CLOCKReplacer::Pin(frame_id_t frame_id) { clock_status[frame_id].store(0, std::memory_order_release); }
+
+/**
+ * 数据页解除固定，同时设置引用位
+ */
+void CLOCKReplacer::Unpin(frame_id_t frame_id) {
+  clock_status[frame_id].store(EVICTABLE_BIT | REFERENCE_BIT, std::memory_order_release);
+}
+
+/**
+ * atomic不能移动，只能新建一个状态数组再把旧的状态拷过去
+ */
+void CLOCKReplacer::Resize(size_t num_pages) {
+  vector<atomic<uint8_t>> resized(num_pages);
+  for (size_t i = 0; i < num_pages; i++) {
+    resized[i].store(i < capacity ? clock_status[i].load(std::memory_order_relaxed) : 0, std::memory_order_relaxed);
+  }
+  clock_status.swap(resized);
+  capacity = num_pages;
+  clock_hand.store(0, std::memory_order_relaxed);
+}
+
+size_t CLOCKReplacer::Size() {
+  size_t size = 0;
+  for (auto &status : clock_status) {
+    if (status.load(std::memory_order_relaxed) & EVICTABLE_BIT) size++;
+  }
+  return size;
+}
@@ -0,0 +1,65 @@
+#include "buffer/lru_k_replacer.h"
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k, size_t correlated_period)
+    : num_pages_(num_pages), k_(k), correlated_period_(correlated_period), frames_(num_pages) {}
+
+LRUKReplacer::~LRUKReplacer() = default;
+
+/**
+ * 选出backward k-distance最大的数据页
+ */
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+  if (evictable_.empty()) return false;
+  *frame_id = evictable_.begin()->second;
+  evictable_.erase(evictable_.begin());
+  // 被替换出去之后，这个frame会装入别的数据页，历史记录作废
+  frames_[*frame_id] = FrameHistory();
+  return true;
+}
+
+/**
+ * 每次Pin都视为对数据页的一次访问
+ */
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  FrameHistory &frame = frames_[frame_id];
+  if (frame.evictable_) {
+    evictable_.erase(make_pair(GetEvictKey(frame), frame_id));
+    frame.evictable_ = false;
+  }
+  size_t now = ++current_timestamp_;
+  // 相关访问（例如顺序扫描逐条读取同一页）只刷新最近访问时间
+  if (!frame.history_.empty() && now - frame.last_ <= correlated_period_) {
+    frame.last_ = now;
+    return;
+  }
+  frame.history_.push_front(now);
+  if (frame.history_.size() > k_) frame.history_.pop_back();
+  frame.last_ = now;
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  FrameHistory &frame = frames_[frame_id];
+  if (frame.evictable_) return;
+  // 没有任何访问记录就变成可替换的frame（例如预读进来的页），按进入replacer的时间排序
+  if (frame.history_.empty()) frame.last_ = ++current_timestamp_;
+  frame.evictable_ = true;
+  evictable_.emplace(GetEvictKey(frame), frame_id);
+}
+
+void LRUKReplacer::Remove(frame_id_t frame_id) {
+  FrameHistory &frame = frames_[frame_id];
+  if (frame.evictable_) evictable_.erase(make_pair(GetEvictKey(frame), frame_id));
+  frame = FrameHistory();
+}
+
+void LRUKReplacer::Resize(size_t num_pages) {
+  num_pages_ = num_pages;
+  frames_.resize(num_pages);
+}
+
+size_t LRUKReplacer::Size() { return evictable_.size(); }
+
+LRUKReplacer::EvictKey LRUKReplacer::GetEvictKey(const FrameHistory &frame) const {
+  if (frame.history_.size() < k_) return make_pair(0, frame.last_);
+  return make_pair(1, frame.history_.back());
+}
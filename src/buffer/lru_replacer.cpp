@@ -44,6 +44,13 @@ void LRUReplacer::Unpin(frame_id_t frame_id) {
 	unpined[frame_id] = lru_list_.begin();
 }
 
+/**
+ * lru_list_只记录可替换的frame，被移除的frame已经不在其中，只需更新容量
+ */
+void LRUReplacer::Resize(size_t num_pages) {
+	this->num_pages = num_pages;
+}
+
 /**
  * 返回当前LRUReplacer中能够被替换的数据页的数量
  */
@@ -0,0 +1,59 @@
+#include "buffer/page_table.h"
+
+#include <new>
+
+PageTable::PageTable(size_t num_frames) {
+  // 负载因子不超过0.5，最少占满一个cache line
+  size_t capacity = 8;
+  int bits = 3;
+  while (capacity < 2 * num_frames) {
+    capacity <<= 1;
+    bits++;
+  }
+  mask_ = capacity - 1;
+  shift_ = 64 - bits;
+  slots_ = new (std::align_val_t(64)) atomic<uint64_t>[capacity];
+  for (size_t i = 0; i < capacity; i++) {
+    slots_[i].store(EMPTY_SLOT, std::memory_order_relaxed);
+  }
+}
+
+PageTable::~PageTable() { operator delete[](slots_, std::align_val_t(64)); }
+
+void PageTable::Insert(page_id_t page_id, frame_id_t frame_id) {
+  size_t slot = Hash(page_id);
+  while (true) {
+    uint64_t entry = slots_[slot].load(std::memory_order_relaxed);
+    if (entry == EMPTY_SLOT) {
+      size_++;
+      break;
+    }
+    if (PageOf(entry) == page_id) break;
+    slot = (slot + 1) & mask_;
+  }
+  slots_[slot].store(MakeEntry(page_id, frame_id), std::memory_order_release);
+}
+
+bool PageTable::Erase(page_id_t page_id) {
+  size_t hole = Hash(page_id);
+  while (true) {
+    uint64_t entry = slots_[hole].load(std::memory_order_relaxed);
+    if (entry == EMPTY_SLOT) return false;
+    if (PageOf(entry) == page_id) break;
+    hole = (hole + 1) & mask_;
+  }
+  // 把后面探测链上的entry往前挪，填补删除留下的空位
+  for (size_t slot = (hole + 1) & mask_;; slot = (slot + 1) & mask_) {
+    uint64_t entry = slots_[slot].load(std::memory_order_relaxed);
+    if (entry == EMPTY_SLOT) break;
+    size_t home = Hash(PageOf(entry));
+    // home不在(hole, slot]之间时，这个entry挪到hole上仍然能被探测到
+    if (((slot - home) & mask_) >= ((slot - hole) & mask_)) {
+      slots_[hole].store(entry, std::memory_order_release);
+      hole = slot;
+    }
+  }
+  slots_[hole].store(EMPTY_SLOT, std::memory_order_release);
+  size_--;
+  return true;
+}
@@ -107,17 +107,19 @@ CatalogManager::~CatalogManager() {
 /**
  * TODO: Student Implement
  */
-dberr_t CatalogManager::CreateTable(const string &table_name, TableSchema *schema, Txn *txn, TableInfo *&table_info) {
+dberr_t CatalogManager::CreateTable(const string &table_name, TableSchema *schema, Txn *txn, TableInfo *&table_info,
+                                    TableFormat format, bool compressed) {
   // ASSERT(false, "Not Implemented yet");
   if(table_names_.find(table_name) != table_names_.end()){
     return DB_TABLE_ALREADY_EXIST;
   }
   //if certain table name doesn't exist,create a new table
   page_id_t new_page_id;
-  TableHeap* table = TableHeap::Create(buffer_pool_manager_,schema,txn,log_manager_,lock_manager_);
+  // 表的格式记在它的page里，元数据不用记；是否压缩记在元数据里
+  TableHeap* table = TableHeap::Create(buffer_pool_manager_,schema,txn,log_manager_,lock_manager_,format,compressed);
   Page* table_meta_page = buffer_pool_manager_->NewPage(new_page_id);
   page_id_t root_page_id = table->GetFirstPageId();
-  TableMetadata* table_meta_data = TableMetadata::Create(new_page_id,table_name,root_page_id,schema);
+  TableMetadata* table_meta_data = TableMetadata::Create(new_page_id,table_name,root_page_id,schema,compressed);
   table_meta_data->SerializeTo(table_meta_page->GetData());
   buffer_pool_manager_->UnpinPage(new_page_id,true);
 
@@ -183,7 +185,8 @@ dberr_t CatalogManager::CreateIndex(const std::string &table_name, const string
   index_info=IndexInfo::Create();
   index_info->Init(meta_data,table_info,buffer_pool_manager_);
   //将table中原有的数据插入索引中
-  auto itr=table_info->GetTableHeap()->Begin(txn);
+  // 回填时通过ring读取堆表，不污染buffer
+  auto itr=table_info->GetTableHeap()->Begin(txn, buffer_pool_manager_->GetAccessStrategy());
   vector<uint32_t> column_ids;
   vector<Column *> columns = index_info->GetIndexKeySchema()->GetColumns();
   for (auto column : columns) {
@@ -295,6 +298,8 @@ dberr_t CatalogManager::DropIndex(const string &table_name, const string &index_
  * TODO: Student Implement
  */
 dberr_t CatalogManager::FlushCatalogMetaPage() const {
+  // 只读打开时页映射在只读内存上，元数据也不会变
+  if (buffer_pool_manager_->IsReadOnly()) return DB_SUCCESS;
   Page* page=buffer_pool_manager_->FetchPage(CATALOG_META_PAGE_ID);
   catalog_meta_->SerializeTo(page->GetData());
   buffer_pool_manager_->UnpinPage(CATALOG_META_PAGE_ID,true);
@@ -314,7 +319,7 @@ dberr_t CatalogManager::LoadTable(const table_id_t table_id, const page_id_t pag
   Page* page=buffer_pool_manager_->FetchPage(page_id);
   TableMetadata* meta_data;
   TableMetadata::DeserializeFrom(page->GetData(),meta_data);
-  TableHeap* table_heap=TableHeap::Create(buffer_pool_manager_,meta_data->GetFirstPageId(),meta_data->GetSchema(),log_manager_,lock_manager_);
+  TableHeap* table_heap=TableHeap::Create(buffer_pool_manager_,meta_data->GetFirstPageId(),meta_data->GetSchema(),log_manager_,lock_manager_,meta_data->IsCompressed());
   //create table info to be added into tables
   TableInfo* table_info=TableInfo::Create();
   table_info->Init(meta_data,table_heap);
@@ -3,19 +3,25 @@
 //
 #include "common/instance.h"
 
-DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer_pool_size)
-    : db_file_name_(std::move(db_name)), init_(init) {
+DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer_pool_size,
+                                 uint32_t buffer_pool_instances, bool read_only)
+    : db_file_name_(std::move(db_name)), init_(init), read_only_(read_only) {
+  ASSERT(!(init_ && read_only_), "A read-only database cannot be initialized.");
   // Init database file if needed
+  warm_up_file_name_ = "./databases/." + db_file_name_ + ".warmup";
   db_file_name_ = "./databases/" + db_file_name_;
   // 如果init_为true,那么需要删除原来数据库文件,重新建立这个数据库
   if (init_) {
     // remove用于删除一个文件,参数是文件名
     // 如果删除失败,返回非0值
     remove(db_file_name_.c_str());
+    remove(warm_up_file_name_.c_str());
   }
   // Initialize components
-  disk_mgr_ = new DiskManager(db_file_name_);
-  bpm_ = new BufferPoolManager(buffer_pool_size, disk_mgr_);
+  disk_mgr_ = new DiskManager(db_file_name_, false, read_only_);
+  bpm_ = new BufferPoolManager(buffer_pool_size, disk_mgr_, buffer_pool_instances, ReplacerType::kLRUK);
+  // 后台写回脏页，前台换页时尽量不用等写盘
+  bpm_->StartPageCleaner();
 
   // Allocate static page for db storage engine
   // 如果需要新建数据库文件的话,需要......
@@ -45,10 +51,14 @@ DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer
     // newpage会pin这个page,需要手动解除
     bpm_->UnpinPage(CATALOG_META_PAGE_ID, false);
     bpm_->UnpinPage(INDEX_ROOTS_PAGE_ID, false);
+    // 分配信息只缓存在内存里，新建的库先落盘，之后再打开才能看到这两个页
+    disk_mgr_->Sync();
   } else {
     // 如果说不需要init,那么CATALOG_META_PAGE_ID和INDEX_ROOTS_PAGE_ID的两个page一定被占用
     ASSERT(!bpm_->IsPageFree(CATALOG_META_PAGE_ID), "Invalid catalog meta page.");
     ASSERT(!bpm_->IsPageFree(INDEX_ROOTS_PAGE_ID), "Invalid header page.");
+    // 后台把上次关闭时的热页读回来
+    bpm_->StartWarmUp(warm_up_file_name_);
   }
   // 创建catalog_manager
   catalog_mgr_ = new CatalogManager(bpm_, nullptr, nullptr, init);
@@ -57,6 +67,8 @@ DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer
 // DBStorageEngine的析构函数, 释放掉对象中的new来的变量,catalog,bufferpool,disk.
 DBStorageEngine::~DBStorageEngine() {
   delete catalog_mgr_;
+  // 正常关闭时记下buffer中的页，下次打开时预热
+  bpm_->SaveWarmUpFile(warm_up_file_name_);
   delete bpm_;
   delete disk_mgr_;
 }
@@ -1,6 +1,7 @@
 #include "executor/execute_engine.h"
 
 #include <dirent.h>
+#include <strings.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <cstring>
@@ -23,7 +24,7 @@ int yyparse(void);
 #include "parser/parser.h"
 }
 
-ExecuteEngine::ExecuteEngine() {
+ExecuteEngine::ExecuteEngine(bool read_only) : read_only_(read_only) {
 	// 数据库文件存在databases中, 在instance.cpp中被指定
   char path[] = "./databases";
 	// DIR在dirent.h中被定义, 用于在进行文件系统操作时，表示被打开的目录
@@ -44,7 +45,8 @@ ExecuteEngine::ExecuteEngine() {
         stdir->d_name[0] == '.')
       continue;
 		// 已经存在这个数据库文件,所以init参数为false
-    dbs_[stdir->d_name] = new DBStorageEngine(stdir->d_name, false);
+    dbs_[stdir->d_name] = new DBStorageEngine(stdir->d_name, false, DEFAULT_BUFFER_POOL_SIZE,
+                                              DEFAULT_BUFFER_POOL_INSTANCES, read_only_);
   }
   closedir(dir);
 }
@@ -120,6 +122,23 @@ dberr_t ExecuteEngine::Execute(pSyntaxNode ast) {
   auto start_time = std::chrono::system_clock::now();
   unique_ptr<ExecuteContext> context(nullptr);
   if (!current_db_.empty()) context = dbs_[current_db_]->MakeExecuteContext(nullptr);
+  // 只读打开时拒绝所有会写文件的语句
+  if (read_only_) {
+    switch (ast->type_) {
+      case kNodeCreateDB:
+      case kNodeDropDB:
+      case kNodeCreateTable:
+      case kNodeDropTable:
+      case kNodeCreateIndex:
+      case kNodeDropIndex:
+      case kNodeInsert:
+      case kNodeDelete:
+      case kNodeUpdate:
+        return DB_READ_ONLY;
+      default:
+        break;
+    }
+  }
   switch (ast->type_) {
     case kNodeCreateDB:
       return ExecuteCreateDatabase(ast, context.get());
@@ -137,6 +156,10 @@ dberr_t ExecuteEngine::Execute(pSyntaxNode ast) {
       return ExecuteDropTable(ast, context.get());
     case kNodeShowIndexes:
       return ExecuteShowIndexes(ast, context.get());
+    case kNodeShowStatus:
+      return ExecuteShowStatus(ast, context.get());
+    case kNodeSetVariable:
+      return ExecuteSetVariable(ast, context.get());
     case kNodeCreateIndex:
       return ExecuteCreateIndex(ast, context.get());
     case kNodeDropIndex:
@@ -242,6 +265,9 @@ void ExecuteEngine::ExecuteInformation(dberr_t result) {
     case DB_KEY_NOT_FOUND:
       cout << "Key not exists." << endl;
       break;
+    case DB_READ_ONLY:
+      cout << "Databases are opened read-only." << endl;
+      break;
     case DB_QUIT:
       cout << "Bye." << endl;
       break;
@@ -274,8 +300,11 @@ dberr_t ExecuteEngine::ExecuteDropDatabase(pSyntaxNode ast, ExecuteContext *cont
   }
 	// 从物理意义上删除数据库文件
   remove(db_name.c_str());
+  string warm_up_file_name = dbs_[db_name]->warm_up_file_name_;
 	// 释放DBStorageEngine内存
   delete dbs_[db_name];
+  // 析构时会写预热文件，必须在之后删除
+  remove(warm_up_file_name.c_str());
 	// 从map中删除键值对
   dbs_.erase(db_name);
   return DB_SUCCESS;
@@ -386,6 +415,25 @@ dberr_t ExecuteEngine::ExecuteCreateTable(pSyntaxNode ast, ExecuteContext *conte
 	std::vector<std::string> primary_keys;
 	// 所有column
 	vector<Column*> columns;
+	// create table ... using pax, compressed 用PAX格式存储、压缩存放，默认按行存储、不压缩
+	TableFormat format = TableFormat::kRowFormat;
+	bool compressed = false;
+	pSyntaxNode format_node = ast->child_->next_->next_;
+	if (format_node != nullptr && format_node->type_ == kNodeTableFormat) {
+		for (pSyntaxNode option_node = format_node->child_; option_node != nullptr; option_node = option_node->next_) {
+			std::string option_string = option_node->val_;
+			if (strcasecmp(option_string.c_str(), "pax") == 0) {
+				format = TableFormat::kPaxFormat;
+			} else if (strcasecmp(option_string.c_str(), "row") == 0) {
+				format = TableFormat::kRowFormat;
+			} else if (strcasecmp(option_string.c_str(), "compressed") == 0) {
+				compressed = true;
+			} else {
+				cout << "Unknown table option [" << option_string << "], row, pax or compressed." << endl;
+				return DB_FAILED;
+			}
+		}
+	}
 
 	pSyntaxNode column_node = ast->child_->next_->child_;
 	while (column_node != nullptr) {
@@ -451,7 +499,8 @@ dberr_t ExecuteEngine::ExecuteCreateTable(pSyntaxNode ast, ExecuteContext *conte
 
   Schema *schema = new Schema(columns);
   TableInfo *table_info;
-  dberr_t result = catalog_manager->CreateTable(table_name, schema, context->GetTransaction(), table_info);
+  dberr_t result = catalog_manager->CreateTable(table_name, schema, context->GetTransaction(), table_info, format,
+                                                compressed);
   if(result == DB_TABLE_ALREADY_EXIST){
     return DB_TABLE_ALREADY_EXIST;
   }
@@ -537,6 +586,93 @@ dberr_t ExecuteEngine::ExecuteShowIndexes(pSyntaxNode ast, ExecuteContext *conte
   return DB_SUCCESS;
 }
 
+dberr_t ExecuteEngine::ExecuteShowStatus(pSyntaxNode ast, ExecuteContext *context) {
+#ifdef ENABLE_EXECUTE_DEBUG
+  LOG(INFO) << "ExecuteShowStatus" << std::endl;
+#endif
+  // 目前只支持 show buffer status
+  if (strcasecmp(ast->child_->val_, "buffer") != 0 || strcasecmp(ast->child_->next_->val_, "status") != 0) {
+    cout << "Unknown status [" << ast->child_->val_ << " " << ast->child_->next_->val_ << "]." << endl;
+    return DB_FAILED;
+  }
+  if (current_db_.empty()) {
+    cout << "No database selected." << endl;
+    return DB_FAILED;
+  }
+  BufferPoolManager *bpm = dbs_[current_db_]->bpm_;
+  BufferPoolStats stats = bpm->GetStats();
+  stringstream hit_ratio;
+  hit_ratio << fixed << setprecision(4) << stats.HitRatio();
+  WarmUpStats warm_up = bpm->GetWarmUpStats();
+  stringstream warm_up_ratio, warm_up_ms;
+  warm_up_ratio << fixed << setprecision(4) << warm_up.RestoredRatio();
+  warm_up_ms << fixed << setprecision(2) << warm_up.elapsed_ms_;
+  vector<pair<string, string>> status = {
+      {"pool_size", to_string(bpm->GetPoolSize())},
+      {"pool_instances", to_string(bpm->GetNumInstances())},
+      {"fetch_hits", to_string(stats.fetch_hits_)},
+      {"fetch_misses", to_string(stats.fetch_misses_)},
+      {"hit_ratio", hit_ratio.str()},
+      {"new_pages", to_string(stats.new_pages_)},
+      {"evictions", to_string(stats.evictions_)},
+      {"dirty_writebacks", to_string(stats.dirty_writebacks_)},
+      {"pin_waits", to_string(stats.pin_waits_)},
+      {"pinned_frames", to_string(stats.pinned_frames_)},
+      {"warm_up_state", warm_up.finished_ ? "done" : "running"},
+      {"warm_up_pages_listed", to_string(warm_up.pages_listed_)},
+      {"warm_up_pages_restored", to_string(warm_up.pages_restored_)},
+      {"warm_up_restored_ratio", warm_up_ratio.str()},
+      {"warm_up_ms", warm_up_ms.str()}};
+  // 按照show databases的格式输出两列
+  size_t name_width = 13, value_width = 5;
+  for (const auto &item : status) {
+    name_width = max(name_width, item.first.length());
+    value_width = max(value_width, item.second.length());
+  }
+  auto divider = [&] {
+    cout << "+" << setfill('-') << setw(name_width + 2) << "" << "+" << setw(value_width + 2) << "" << "+" << endl;
+  };
+  divider();
+  cout << "| " << std::left << setfill(' ') << setw(name_width) << "Variable_name" << " | " << setw(value_width)
+       << "Value" << " |" << endl;
+  divider();
+  for (const auto &item : status) {
+    cout << "| " << std::left << setfill(' ') << setw(name_width) << item.first << " | " << setw(value_width)
+         << item.second << " |" << endl;
+  }
+  divider();
+  return DB_SUCCESS;
+}
+
+dberr_t ExecuteEngine::ExecuteSetVariable(pSyntaxNode ast, ExecuteContext *context) {
+#ifdef ENABLE_EXECUTE_DEBUG
+  LOG(INFO) << "ExecuteSetVariable" << std::endl;
+#endif
+  // 目前只支持 set buffer_pool_size = N，N是页数
+  if (strcasecmp(ast->child_->val_, "buffer_pool_size") != 0) {
+    cout << "Unknown variable [" << ast->child_->val_ << "]." << endl;
+    return DB_FAILED;
+  }
+  if (current_db_.empty()) {
+    cout << "No database selected." << endl;
+    return DB_FAILED;
+  }
+  const char *value = ast->child_->next_->val_;
+  char *end = nullptr;
+  unsigned long long pool_size = strtoull(value, &end, 10);
+  BufferPoolManager *bpm = dbs_[current_db_]->bpm_;
+  if (value[0] == '-' || *end != '\0' || pool_size < bpm->GetNumInstances()) {
+    cout << "Invalid buffer_pool_size [" << value << "], at least " << bpm->GetNumInstances() << " pages." << endl;
+    return DB_FAILED;
+  }
+  if (!bpm->Resize(pool_size)) {
+    cout << "Some pages are pinned, buffer_pool_size is " << bpm->GetPoolSize() << " pages." << endl;
+    return DB_FAILED;
+  }
+  cout << "Buffer pool resized to " << bpm->GetPoolSize() << " pages." << endl;
+  return DB_SUCCESS;
+}
+
 /**
  * TODO: Student Implement .
  */
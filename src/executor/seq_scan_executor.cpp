@@ -4,10 +4,7 @@
 #include "executor/executors/seq_scan_executor.h"
 
 SeqScanExecutor::SeqScanExecutor(ExecuteContext *exec_ctx, const SeqScanPlanNode *plan)
-    : AbstractExecutor(exec_ctx),
-      plan_(plan),
-      iterator_(nullptr, RowId(INVALID_PAGE_ID, 0), nullptr),
-      is_schema_same_(false) {}
+    : AbstractExecutor(exec_ctx), plan_(plan), is_schema_same_(false) {}
 
 bool SeqScanExecutor::SchemaEqual(const Schema *table_schema, const Schema *output_schema) {
   auto table_columns = table_schema->GetColumns();
@@ -29,48 +26,66 @@ bool SeqScanExecutor::SchemaEqual(const Schema *table_schema, const Schema *outp
   return true;
 }
 
-void SeqScanExecutor::TupleTransfer(const Schema *table_schema, const Schema *output_schema, const Row *row,
-                                    Row *output_row) {
-  const auto &output_columns = output_schema->GetColumns();
-  std::vector<Field> dest_row;
-  dest_row.reserve(output_columns.size());
-
-  // 将每个输出列对应的字段添加到新的行中
-  for (const auto &column : output_columns) {
-    auto idx = column->GetTableInd();
-    dest_row.emplace_back(*row->GetField(idx));
-  }
-
-  *output_row = Row(dest_row);
-}
-
 void SeqScanExecutor::Init() {
   exec_ctx_->GetCatalog()->GetTable(plan_->GetTableName(), table_info_);
-  auto first_row = table_info_->GetTableHeap()->Begin(nullptr);
-	iterator_ = table_info_->GetTableHeap()->Begin(exec_ctx_->GetTransaction());
   schema_ = plan_->OutputSchema();
   is_schema_same_ = SchemaEqual(table_info_->GetSchema(), schema_);
+  column_ids_.clear();
+  for (const auto &column : schema_->GetColumns()) {
+    column_ids_.push_back(column->GetTableInd());
+  }
+  cursor_.reset();
+  parallel_scan_.reset();
+  TableHeap *table_heap = table_info_->GetTableHeap();
+  size_t num_threads = std::thread::hardware_concurrency();
+  std::vector<page_id_t> page_ids;
+  if (plan_->IsParallel() && num_threads > 1) {
+    table_heap->GetPageIds(&page_ids);
+  }
+  if (page_ids.size() >= PARALLEL_SCAN_MIN_PAGES) {
+    // 大表按page范围切分给多个线程扫描，每个线程各自用ring的一部分
+    AbstractExpressionRef predicate = plan_->GetPredicate();
+    ParallelTableScan::Filter filter;
+    if (predicate != nullptr) {
+      filter = [predicate](const RowView &row) {
+        return predicate->Evaluate(row).CompareEquals(Field(kTypeInt, 1)) != CmpBool::kFalse;
+      };
+    }
+    parallel_scan_ = std::make_unique<ParallelTableScan>(
+        table_heap, exec_ctx_->GetTransaction(), std::move(filter),
+        is_schema_same_ ? std::vector<uint32_t>() : column_ids_, num_threads,
+        exec_ctx_->GetBufferPoolManager()->GetAccessStrategy(BUFFER_RING_SIZE * num_threads));
+    return;
+  }
+	// 顺序扫描通过一个小的ring读取page，不会把其他会话的热点页挤出buffer
+	cursor_ = std::make_unique<TableScanCursor>(table_heap, exec_ctx_->GetTransaction(),
+	                                            exec_ctx_->GetBufferPoolManager()->GetAccessStrategy());
 }
 
 bool SeqScanExecutor::Next(Row *row, RowId *rid) {
+  if (parallel_scan_ != nullptr) {
+    // 谓词和投影已经由扫描线程做完了
+    if (!parallel_scan_->Next(row)) return false;
+    *rid = row->GetRowId();
+    return true;
+  }
   auto predicate = plan_->GetPredicate();
-  const auto *table_schema = table_info_->GetSchema();
-  // 遍历表中的行
-  while (iterator_ != table_info_->GetTableHeap()->End()) {
-    const Row &current_row = *iterator_;
+  // 遍历表中的行，谓词直接在page里的行上求值，只有输出的行才反序列化
+  while (cursor_->Next()) {
+    const RowView &current_row = cursor_->GetRow();
     // 如果有谓词，进行过滤
-    if (predicate && !predicate->Evaluate(&current_row).CompareEquals(Field(kTypeInt, 1))) {
-      ++iterator_;
+    if (predicate && !predicate->Evaluate(current_row).CompareEquals(Field(kTypeInt, 1))) {
       continue;
     }
     *rid = current_row.GetRowId();
     // 根据 Schema 是否相同进行行转换
     if (!is_schema_same_) {
-      TupleTransfer(table_schema, schema_, &current_row, row);
+      current_row.ToRow(column_ids_, row);
     } else {
-      *row = current_row;
+      current_row.ToRow(row);
     }
-    ++iterator_;
+    // 行已经拷贝出来了，上层的delete/update要写这一页，先放开latch
+    cursor_->Release();
     return true;
   }
   return false;
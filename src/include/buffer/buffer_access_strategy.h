@@ -0,0 +1,51 @@
+#ifndef MINISQL_BUFFER_ACCESS_STRATEGY_H
+#define MINISQL_BUFFER_ACCESS_STRATEGY_H
+
+#include <algorithm>
+#include <vector>
+
+#include "common/config.h"
+
+using namespace std;
+
+/**
+ * The frames one shard lent to a BufferAccessStrategy, remembered together with the page each of them was loaded
+ * with. Only touched under the latch of that shard.
+ */
+struct BufferRing {
+  struct Slot {
+    frame_id_t frame_id_{INVALID_FRAME_ID};
+    page_id_t page_id_{INVALID_PAGE_ID};
+  };
+  vector<Slot> slots_;
+  size_t next_{0};  // slot to recycle on the next miss
+};
+
+/**
+ * BufferAccessStrategy lets a bulk operation, e.g. a sequential scan or the backfill of a new index, read pages
+ * through a small private ring of frames. On a miss, the operation recycles the frame it loaded ring_size misses ago,
+ * as long as that frame still holds the same page and nobody pins it, instead of asking the replacer for a victim.
+ * The operation therefore occupies at most ring_size frames, and cannot push the working set of other sessions out
+ * of the pool whatever the replacement policy is.
+ *
+ * Hits are served as usual, and ring frames go back to the replacer when unpinned, so they are reclaimed normally
+ * once the operation is over. The ring is split evenly over the shards of the pool, a strategy must only be used with
+ * the pool that created it.
+ */
+class BufferAccessStrategy {
+ public:
+  explicit BufferAccessStrategy(size_t num_instances, size_t ring_size = BUFFER_RING_SIZE) : rings_(num_instances) {
+    size_t ring_size_per_instance = max(static_cast<size_t>(1), ring_size / num_instances);
+    for (auto &ring : rings_) {
+      ring.slots_.resize(ring_size_per_instance);
+    }
+  }
+
+  /** @return the ring of the shard responsible for page_id */
+  inline BufferRing *GetRing(page_id_t page_id) { return &rings_[static_cast<size_t>(page_id) % rings_.size()]; }
+
+ private:
+  vector<BufferRing> rings_;  // one ring per shard
+};
+
+#endif  // MINISQL_BUFFER_ACCESS_STRATEGY_H
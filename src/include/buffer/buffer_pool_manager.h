@@ -1,58 +1,236 @@
 #ifndef MINISQL_BUFFER_POOL_MANAGER_H
 #define MINISQL_BUFFER_POOL_MANAGER_H
 
-#include <list>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
 #include <mutex>
-#include <unordered_map>
+#include <string>
+#include <thread>
+#include <vector>
 
-#include "buffer/lru_replacer.h"
+#include "buffer/buffer_pool_manager_instance.h"
 #include "page/disk_file_meta_page.h"
 #include "page/page.h"
 #include "storage/disk_manager.h"
 
 using namespace std;
 
+/**
+ * Progress of the warm-up started by BufferPoolManager::StartWarmUp.
+ */
+struct WarmUpStats {
+  size_t pages_listed_{0};    // pages recorded in the warm-up file
+  size_t pages_restored_{0};  // listed pages that are resident again
+  double elapsed_ms_{0};      // time spent by the loader so far
+  bool finished_{false};      // the loader is done, or there was no warm-up file
+
+  /** @return fraction of the listed pages that were restored, 0 if none were listed */
+  inline double RestoredRatio() const {
+    return pages_listed_ == 0 ? 0 : static_cast<double>(pages_restored_) / pages_listed_;
+  }
+};
+
+/**
+ * BufferPoolManager splits its frames into num_instances independent shards (BufferPoolManagerInstance). A page always
+ * lives in the shard selected by page_id % num_instances, so FetchPage/UnpinPage/NewPage on different pages only take
+ * the latch of their own shard and can proceed on different cores at the same time.
+ *
+ * replacer_type selects the replacement policy of every shard; DBStorageEngine uses LRU-K so that large scans do not
+ * flush the index working set.
+ *
+ * An optional background page cleaner keeps a fraction of the evictable frames clean, so that FetchPage/NewPage
+ * rarely have to write a dirty victim before they can reuse its frame. A read-ahead worker, started on the first
+ * prefetch request, loads pages that callers announce they are about to fetch.
+ *
+ * SaveWarmUpFile and StartWarmUp carry the working set over a restart: the resident page ids are saved on a clean
+ * shutdown and read back in the background when the database is opened again.
+ *
+ * If the disk manager is read-only, the shards are bypassed: FetchPage returns a descriptor that points straight into
+ * the disk manager's mapping of the file, created on first use and kept until the pool is destroyed. There is no copy,
+ * pinning or eviction, the page cleaner, read-ahead and warm-up do nothing, and NewPage and DeletePage fail.
+ */
 class BufferPoolManager {
  public:
-  explicit BufferPoolManager(size_t pool_size, DiskManager *disk_manager);
+  explicit BufferPoolManager(size_t pool_size, DiskManager *disk_manager, size_t num_instances = 1,
+                             ReplacerType replacer_type = ReplacerType::kLRU);
 
   ~BufferPoolManager();
 
-  Page *FetchPage(page_id_t page_id);
+  /**
+   * Fetch the requested page, reading it from disk if it is not resident.
+   * @param strategy if set, a miss recycles a frame of the strategy's ring instead of evicting another page
+   */
+  Page *FetchPage(page_id_t page_id, BufferAccessStrategy *strategy = nullptr);
+
+  /**
+   * @return a new ring of ring_size frames for a bulk read of this pool, see BufferAccessStrategy. It is shared so
+   * that pending read-ahead requests keep it alive after the reader is done.
+   */
+  inline shared_ptr<BufferAccessStrategy> GetAccessStrategy(size_t ring_size = BUFFER_RING_SIZE) {
+    return make_shared<BufferAccessStrategy>(instances_.size(), ring_size);
+  }
 
   bool UnpinPage(page_id_t page_id, bool is_dirty);
 
+  /**
+   * Ask the read-ahead worker to load the given pages in the background. Returns immediately; requests are dropped
+   * when PREFETCH_QUEUE_CAPACITY requests are already pending. Prefetched pages are not pinned.
+   */
+  void PrefetchPages(const vector<page_id_t> &page_ids);
+
+  /**
+   * Ask the read-ahead worker to load up to count pages of a page chain in the background, starting with page_id and
+   * following next_page from each loaded page. If strategy is set, the pages are loaded into its ring.
+   */
+  void PrefetchPageChain(page_id_t page_id, size_t count, NextPageFunc next_page,
+                         shared_ptr<BufferAccessStrategy> strategy = nullptr);
+
   bool FlushPage(page_id_t page_id);
 
-  Page *NewPage(page_id_t &page_id);
+  /**
+   * Allocate a new page on disk and place it in its shard. If that shard has no frame to spare the allocation is
+   * rolled back and nullptr is returned.
+   * @param run if set, the page is allocated from this run so that the pages of a table or index stay together on disk
+   */
+  Page *NewPage(page_id_t &page_id, PageRun *run = nullptr);
+
+  /**
+   * Give back the pages the run reserved but did not use, see DiskManager::ReleasePageRun.
+   */
+  void ReleasePageRun(PageRun *run);
 
   bool DeletePage(page_id_t page_id);
 
   bool IsPageFree(page_id_t page_id);
 
+  /** @return true if the page is stored compressed */
+  inline bool IsPageCompressed(page_id_t page_id) { return disk_manager_->IsPageCompressed(page_id); }
+
   bool CheckAllUnpinned();
 
+  /**
+   * Start the background page cleaner. Every PAGE_CLEANER_INTERVAL_MS, and right away again while a shard still has
+   * a backlog, it tops each shard up to clean_ratio clean evictable frames. Does nothing if it already runs.
+   */
+  void StartPageCleaner(double clean_ratio = PAGE_CLEANER_CLEAN_RATIO);
+
+  /**
+   * Stop the background page cleaner and wait for its last batch to reach the disk.
+   */
+  void StopPageCleaner();
+
+  /** @return the page cleaner counters summed over all shards */
+  PageCleanerStats GetPageCleanerStats();
+
+  /**
+   * @return the hit, eviction and write-back counters summed over all shards. The counters are read without latching
+   * the shards, so a snapshot taken under load is not exactly consistent across counters.
+   */
+  BufferPoolStats GetStats();
+
+  /**
+   * Write the ids of the resident pages to path, hottest first, hotness being the number of fetches since the page
+   * was loaded. Meant to be called on a clean shutdown, before the pool is destroyed.
+   * @return false if the file could not be written
+   */
+  bool SaveWarmUpFile(const string &path);
+
+  /**
+   * Start a background loader that reads back the pages listed in a file written by SaveWarmUpFile. Each shard takes
+   * the hottest listed pages it has room for, and they are read in page id order so that the disk sees a forward
+   * sweep. The loader only fills free frames, it never evicts pages fetched in the meantime. Does nothing if a
+   * warm-up already runs; a missing or malformed file finishes the warm-up right away.
+   */
+  void StartWarmUp(const string &path);
+
+  /** @return progress of the warm-up */
+  WarmUpStats GetWarmUpStats();
+
+  /**
+   * Grow or shrink the pool to pool_size frames while it is in use, spread over the shards as in the constructor.
+   * Shards allocate and release their frames in chunks of BUFFER_POOL_CHUNK_SIZE. Shrinking evicts the pages of the
+   * frames that go away and writes back the dirty ones; a shard that has one of those frames pinned keeps its old size.
+   * @return false if pool_size is smaller than the number of shards or some shard could not shrink, GetPoolSize then
+   * tells the size actually reached
+   */
+  bool Resize(size_t pool_size);
+
+  /** @return the total number of frames over all shards */
+  inline size_t GetPoolSize() const { return pool_size_; }
+
+  inline size_t GetNumInstances() const { return instances_.size(); }
+
+  /** @return true if the pages are served from a read-only mapping of the file and must not be modified */
+  inline bool IsReadOnly() const { return disk_manager_->IsReadOnly(); }
+
  private:
   /**
    * Allocate new page (operations like create index/table) For now just keep an increasing counter
    */
-  page_id_t AllocatePage();
+  page_id_t AllocatePage(PageRun *run = nullptr);
 
   /**
    * Deallocate page (operations like drop index/table) Need bitmap in header page for tracking pages
    */
   void DeallocatePage(page_id_t page_id);
 
-  frame_id_t TryToFindFreePage();
+  /** Body of the page cleaner thread. */
+  void PageCleanerLoop();
+
+  /** Queue a read-ahead request, starting the worker if needed. */
+  void EnqueuePrefetch(page_id_t page_id, size_t count, NextPageFunc next_page,
+                       shared_ptr<BufferAccessStrategy> strategy);
+
+  /** Body of the read-ahead worker thread. */
+  void PrefetchLoop();
+
+  /** Body of the warm-up loader thread. */
+  void WarmUpLoop(string path);
+
+  /** @return the descriptor of a page of the read-only mapping, nullptr if the page is not in the file */
+  Page *FetchMappedPage(page_id_t page_id);
+
+  /** @return the shard responsible for page_id */
+  inline BufferPoolManagerInstance *GetInstance(page_id_t page_id) {
+    return instances_[static_cast<size_t>(page_id) % instances_.size()];
+  }
 
  private:
-  size_t pool_size_;                                 // number of pages in buffer pool
-  Page *pages_;                                      // array of pages
-  DiskManager *disk_manager_;                        // pointer to the disk manager.
-  unordered_map<page_id_t, frame_id_t> page_table_;  // to keep track of pages
-  Replacer *replacer_;                               // to find an unpinned page for replacement
-  list<frame_id_t> free_list_;                       // to find a free page for replacement
-  recursive_mutex latch_;                            // to protect shared data structure
+  atomic<size_t> pool_size_;                        // number of pages in buffer pool
+  DiskManager *disk_manager_;                       // pointer to the disk manager.
+  vector<BufferPoolManagerInstance *> instances_;  // shards of the buffer pool
+  mutex resize_latch_;                              // serializes Resize
+
+  size_t mapped_page_count_{0};                    // pages of the read-only mapping
+  unique_ptr<atomic<Page *>[]> mapped_pages_;      // descriptors of mapped pages, nullptr until first fetched
+
+  thread cleaner_thread_;             // background page cleaner
+  mutex cleaner_latch_;               // protects cleaner_running_ and wakes up the cleaner
+  condition_variable cleaner_wakeup_;
+  bool cleaner_running_{false};
+  double clean_ratio_{PAGE_CLEANER_CLEAN_RATIO};
+
+  struct PrefetchRequest {
+    page_id_t page_id_;      // next page to load
+    size_t remaining_;       // pages left to load, including page_id_
+    NextPageFunc next_page_;  // how to follow the chain, empty for a single page
+    shared_ptr<BufferAccessStrategy> strategy_;  // ring to load the pages into, if any
+  };
+  thread prefetch_thread_;              // background read-ahead worker
+  mutex prefetch_latch_;                // protects prefetch_queue_ and prefetch_running_
+  condition_variable prefetch_wakeup_;
+  deque<PrefetchRequest> prefetch_queue_;
+  bool prefetch_running_{false};
+  bool prefetch_stopped_{false};
+
+  thread warm_up_thread_;             // background warm-up loader
+  atomic<bool> warm_up_stopped_{false};
+  atomic<bool> warm_up_finished_{false};
+  atomic<size_t> warm_up_listed_{0};
+  atomic<size_t> warm_up_restored_{0};
+  atomic<int64_t> warm_up_elapsed_us_{0};
 };
 
 #endif  // MINISQL_BUFFER_POOL_MANAGER_H
@@ -0,0 +1,240 @@
+#ifndef MINISQL_BUFFER_POOL_MANAGER_INSTANCE_H
+#define MINISQL_BUFFER_POOL_MANAGER_INSTANCE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "buffer/page_table.h"
+#include "page/page.h"
+#include "storage/disk_manager.h"
+
+using namespace std;
+
+/** Reads the id of the page that follows the given one in some page chain, e.g. TablePage::GetNextPageId. */
+using NextPageFunc = function<page_id_t(Page *)>;
+
+/**
+ * Counters of the background page cleaner.
+ */
+struct PageCleanerStats {
+  size_t pages_written_{0};   // pages written back by the page cleaner
+  size_t stalls_avoided_{0};  // evictions that found a victim already cleaned by the page cleaner
+  size_t sync_writes_{0};     // evictions that still had to write a dirty victim in the foreground
+};
+
+/**
+ * Counters of a buffer pool, summed over its shards. All counters are cumulative except pinned_frames_.
+ */
+struct BufferPoolStats {
+  size_t fetch_hits_{0};        // FetchPage calls that found the page resident
+  size_t fetch_misses_{0};      // FetchPage calls that read the page from disk
+  size_t new_pages_{0};         // pages created by NewPage
+  size_t evictions_{0};         // resident pages dropped to make room for another page
+  size_t dirty_writebacks_{0};  // dirty pages written back, by eviction, flushes or the page cleaner
+  size_t pin_waits_{0};         // FetchPage/NewPage calls that failed because every frame was pinned
+  size_t pinned_frames_{0};     // frames pinned right now
+
+  /** @return fraction of FetchPage calls that were hits, 0 if there were none */
+  inline double HitRatio() const {
+    size_t fetches = fetch_hits_ + fetch_misses_;
+    return fetches == 0 ? 0 : static_cast<double>(fetch_hits_) / fetches;
+  }
+};
+
+/**
+ * BufferPoolManagerInstance is one shard of the buffer pool. It owns a fixed number of frames together with its own
+ * page table, free list, replacer and latch, so that operations on different shards never contend with each other.
+ *
+ * The frames of a shard are allocated in chunks of BUFFER_POOL_CHUNK_SIZE frames. Each chunk is one mmap-ed arena,
+ * aligned to 2 MB and backed by transparent huge pages, so every frame can be handed to O_DIRECT I/O, plus a separate
+ * compact array of Page descriptors. Chunks never move, so Resize can add and release them while pages are pinned.
+ *
+ * Page id allocation is not handled here: the owning BufferPoolManager allocates the logical page id on disk and
+ * routes every request to the shard the page id hashes to.
+ */
+class BufferPoolManagerInstance {
+ public:
+  explicit BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager,
+                                     ReplacerType replacer_type = ReplacerType::kLRU);
+
+  ~BufferPoolManagerInstance();
+
+  /**
+   * Fetch the requested page from the buffer pool, reading it from disk if it is not resident.
+   * @param ring if set, a miss recycles a frame of this ring before asking the replacer, see BufferAccessStrategy
+   * @return nullptr if every frame of this shard is pinned
+   */
+  Page *FetchPage(page_id_t page_id, BufferRing *ring = nullptr);
+
+  /**
+   * Unpin the target page. The dirty flag is sticky: unpinning a dirty page with is_dirty = false keeps it dirty.
+   * @return false if the page is not resident or its pin count is already 0
+   */
+  bool UnpinPage(page_id_t page_id, bool is_dirty);
+
+  /**
+   * Write the target page back to disk, whether or not it is dirty.
+   * @return false if the page is not resident
+   */
+  bool FlushPage(page_id_t page_id);
+
+  /**
+   * Place a freshly allocated page into a frame of this shard. The frame is zeroed and pinned once.
+   * @param page_id logical page id already allocated by the caller
+   * @return nullptr if every frame of this shard is pinned
+   */
+  Page *NewPage(page_id_t page_id);
+
+  /**
+   * Load the target page into this shard without pinning it. Unlike FetchPage this does not count as a reference, so
+   * the replacer orders the page only by the time it was loaded until somebody really fetches it.
+   * @param next_page if set, applied to the resident page to find the next page of its chain
+   * @param ring if set, the page is loaded into a frame of this ring, as FetchPage would
+   * @return the next page of the chain, INVALID_PAGE_ID if next_page is empty or no frame is free
+   */
+  page_id_t PrefetchPage(page_id_t page_id, const NextPageFunc &next_page, BufferRing *ring = nullptr);
+
+  /**
+   * Load the target page into a free frame of this shard without pinning it, as PrefetchPage does, but never evict a
+   * resident page to make room for it. Used to warm up the pool after a restart.
+   * @return false if the page is not resident and this shard has no free frame left
+   */
+  bool WarmUpPage(page_id_t page_id);
+
+  /**
+   * Drop the target page from this shard and return its frame to the free list.
+   * @return false if the page is resident and still pinned, true otherwise
+   */
+  bool DeletePage(page_id_t page_id);
+
+  /**
+   * Write back every dirty page held by this shard.
+   */
+  void FlushAllPages();
+
+  /**
+   * One round of the background page cleaner. If less than clean_ratio of the evictable frames (free frames and
+   * unpinned resident frames) are clean, copy up to PAGE_CLEANER_BATCH_SIZE dirty unpinned frames into the staging
+   * buffer, mark them clean and write them back in page_id order without holding the latch.
+   * Only one thread may clean a shard at a time, since the staging buffer is shared.
+   * @return number of pages written
+   */
+  size_t CleanPages(double clean_ratio);
+
+  /** Add the counters of this shard to stats. */
+  void CollectCleanerStats(PageCleanerStats *stats);
+
+  /** Add the counters of this shard to stats, without taking the latch. */
+  void CollectStats(BufferPoolStats *stats);
+
+  /**
+   * Check without taking the latch whether the page is resident. The answer may be stale by the time the caller acts on
+   * it, so it is only a hint, e.g. to skip read-ahead of pages that are already in the pool.
+   */
+  inline bool IsResident(page_id_t page_id) const {
+    frame_id_t frame_id;
+    return GetPageTable()->Find(page_id, &frame_id);
+  }
+
+  /**
+   * Append every resident page of this shard to pages, together with its hotness: the number of times it was fetched
+   * since it was loaded into its frame.
+   */
+  void CollectResidentPages(vector<pair<uint32_t, page_id_t>> *pages);
+
+  /**
+   * Grow or shrink this shard to pool_size frames. Growing adds free frames. Shrinking evicts the pages held by the
+   * frames beyond the new size, writing back the dirty ones, and gives the memory of the chunks that are no longer used
+   * back to the system.
+   * @return false, leaving the shard unchanged, if one of the frames to drop is pinned
+   */
+  bool Resize(size_t pool_size);
+
+  bool CheckAllUnpinned();
+
+  inline size_t GetPoolSize() const { return pool_size_; }
+
+ private:
+  /** One allocation unit of frames. */
+  struct FrameChunk {
+    char *arena_;        // page contents of BUFFER_POOL_CHUNK_SIZE frames
+    size_t arena_size_;  // bytes mapped for arena_
+    Page *pages_;        // frame descriptors, pages_[i] points to frame i of the arena
+  };
+
+  /** @return the descriptor of the frame. Caller must hold latch_. */
+  inline Page &GetFrame(frame_id_t frame_id) {
+    return chunks_[frame_id / BUFFER_POOL_CHUNK_SIZE].pages_[frame_id % BUFFER_POOL_CHUNK_SIZE];
+  }
+
+  /** @return the current page table, replaced by a larger one when the shard grows */
+  inline PageTable *GetPageTable() const { return page_table_.load(std::memory_order_acquire); }
+
+  /** Append a chunk of BUFFER_POOL_CHUNK_SIZE frames. Caller must hold latch_. */
+  void AddChunk();
+
+  /** Release the last chunk. None of its frames may be in use. Caller must hold latch_. */
+  void RemoveChunk();
+
+  /**
+   * Pick a frame for a new resident page, from the free list first and then from the replacer. A dirty victim is
+   * written back and removed from the page table. Caller must hold latch_.
+   * @return false if no frame can be reclaimed
+   */
+  bool TryToFindFreeFrame(frame_id_t *frame_id);
+
+  /**
+   * Pick a frame for page_id on behalf of a ring: recycle the frame of the next ring slot if it still holds the page
+   * the ring loaded into it and is unpinned, otherwise fall back to TryToFindFreeFrame and lend that frame to the ring.
+   * Caller must hold latch_.
+   */
+  bool TryToFindRingFrame(BufferRing *ring, page_id_t page_id, frame_id_t *frame_id);
+
+  /** Fill the frame with the content of page_id and register it in the page table. Caller must hold latch_. */
+  void LoadFrame(frame_id_t frame_id, page_id_t page_id);
+
+  /** Write back the frame if it is dirty. Caller must hold latch_. */
+  void FlushFrame(frame_id_t frame_id);
+
+  /** Block until the page cleaner has finished writing page_id. Caller must hold latch_ through lock. */
+  void WaitForCleaner(unique_lock<mutex> &lock, page_id_t page_id);
+
+ private:
+  atomic<size_t> pool_size_;                         // number of pages in this shard
+  vector<FrameChunk> chunks_;                        // frame i lives in chunk i / BUFFER_POOL_CHUNK_SIZE
+  DiskManager *disk_manager_;                        // pointer to the disk manager.
+  atomic<PageTable *> page_table_;                   // to keep track of pages
+  vector<unique_ptr<PageTable>> retired_page_tables_;  // replaced tables, lock-free readers may still use them
+  Replacer *replacer_;                               // to find an unpinned page for replacement
+  list<frame_id_t> free_list_;                       // to find a free page for replacement
+  mutex latch_;                                      // to protect shared data structure
+
+  char *cleaner_buffer_;                             // staging copies of the pages the cleaner is writing
+  unordered_map<page_id_t, char *> cleaning_pages_;  // pages whose write-back is in flight -> staging copy
+  condition_variable cleaner_done_;                  // signaled when a cleaner batch has reached the disk
+  vector<bool> cleaned_;                             // frame was last written back by the cleaner
+  vector<uint32_t> ref_counts_;                      // FetchPage calls since the frame was loaded
+  atomic<size_t> pages_cleaned_{0};
+  atomic<size_t> stalls_avoided_{0};
+  atomic<size_t> sync_writes_{0};
+
+  atomic<size_t> fetch_hits_{0};  // counters reported by CollectStats
+  atomic<size_t> fetch_misses_{0};
+  atomic<size_t> new_pages_{0};
+  atomic<size_t> evictions_{0};
+  atomic<size_t> dirty_writebacks_{0};
+  atomic<size_t> pin_waits_{0};
+  atomic<size_t> pinned_frames_{0};
+};
+
+#endif  // MINISQL_BUFFER_POOL_MANAGER_INSTANCE_H
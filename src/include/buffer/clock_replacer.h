@@ -1,12 +1,7 @@
 #ifndef MINISQL_CLOCK_REPLACER_H
 #define MINISQL_CLOCK_REPLACER_H
 
-#include <algorithm>
-#include <list>
-#include <map>
-#include <mutex>
-#include <queue>
-#include <unordered_set>
+#include <atomic>
 #include <vector>
 
 #include "buffer/replacer.h"
@@ -16,6 +11,12 @@ using namespace std;
 
 /**
  * CLOCKReplacer implements the clock replacement.
+ *
+ * Every frame owns one atomic byte holding an evictable bit and a reference bit, so the replacer only allocates when it
+ * is constructed or resized. Pin and Unpin are single atomic stores. Victim sweeps the clock hand over the frames,
+ * clearing reference bits with compare-and-swap and claiming the first evictable frame whose reference bit is already
+ * clear.
+ * None of the operations take a lock.
  */
 class CLOCKReplacer : public Replacer {
  public:
@@ -36,12 +37,19 @@ class CLOCKReplacer : public Replacer {
 
   void Unpin(frame_id_t frame_id) override;
 
+  /** Not thread safe, unlike the other operations: the caller must stop all other use of the replacer. */
+  void Resize(size_t num_pages) override;
+
+  /** @note counts the evictable frames with a full sweep, meant for tests and debugging only */
   size_t Size() override;
 
  private:
+  static constexpr uint8_t EVICTABLE_BIT = 0x1;
+  static constexpr uint8_t REFERENCE_BIT = 0x2;
+
   size_t capacity;
-  list<frame_id_t> clock_list;               // replacer中可以被替换的数据页
-  map<frame_id_t, frame_id_t> clock_status;  // 数据页的存储状态
+  vector<atomic<uint8_t>> clock_status;  // 每个frame的状态位：是否可被替换、是否最近被访问
+  atomic<size_t> clock_hand{0};          // 时钟指针
 };
 
-#endif  // MINISQL_CLOCK_REPLACER_H
\ No newline at end of file
+#endif  // MINISQL_CLOCK_REPLACER_H
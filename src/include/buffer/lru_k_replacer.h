@@ -0,0 +1,75 @@
+#ifndef MINISQL_LRU_K_REPLACER_H
+#define MINISQL_LRU_K_REPLACER_H
+
+#include <list>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+using namespace std;
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy.
+ *
+ * Every Pin counts as a reference to the frame. The victim is the evictable frame whose K-th most recent reference is
+ * the oldest (largest backward K-distance). Frames with fewer than K references have an infinite backward K-distance
+ * and are evicted first, least recently used first, so pages touched only by a one-pass scan leave the pool before
+ * pages that are re-read by index lookups.
+ *
+ * A reference that comes within correlated_period accesses of the previous reference to the same frame is
+ * correlated (e.g. a scan reading every tuple of a page) and only refreshes the last reference time instead of
+ * counting as a new one.
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k number of references remembered per frame
+   * @param correlated_period references closer than this number of accesses are treated as one
+   */
+  explicit LRUKReplacer(size_t num_pages, size_t k = LRUK_REPLACER_K,
+                        size_t correlated_period = LRUK_CORRELATED_PERIOD);
+
+  /**
+   * Destroys the LRUKReplacer.
+   */
+  ~LRUKReplacer() override;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  void Resize(size_t num_pages) override;
+
+  size_t Size() override;
+
+ private:
+  /** (0, last reference) for frames with less than K references, (1, K-th reference) otherwise */
+  using EvictKey = pair<int, size_t>;
+
+  struct FrameHistory {
+    list<size_t> history_;  // uncorrelated reference times, most recent first, at most K entries
+    size_t last_{0};        // time of the latest reference, correlated or not
+    bool evictable_{false};
+  };
+
+  EvictKey GetEvictKey(const FrameHistory &frame) const;
+
+ private:
+  size_t num_pages_;
+  size_t k_;
+  size_t correlated_period_;
+  size_t current_timestamp_{0};
+  vector<FrameHistory> frames_;
+  set<pair<EvictKey, frame_id_t>> evictable_;  // ordered by eviction priority
+};
+
+#endif  // MINISQL_LRU_K_REPLACER_H
@@ -33,6 +33,8 @@ class LRUReplacer : public Replacer {
 
   void Unpin(frame_id_t frame_id) override;
 
+  void Resize(size_t num_pages) override;
+
   size_t Size() override;
 
 private:
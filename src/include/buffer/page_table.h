@@ -0,0 +1,83 @@
+#ifndef MINISQL_PAGE_TABLE_H
+#define MINISQL_PAGE_TABLE_H
+
+#include <atomic>
+#include <cstddef>
+
+#include "common/config.h"
+
+using namespace std;
+
+/**
+ * PageTable maps the page ids resident in one buffer pool shard to their frames.
+ *
+ * It is a linear probing hash table preallocated for a fixed number of frames, with at least twice as many slots as
+ * frames. Every slot is a single 64-bit word packing the page id and the frame id, so a probe walks consecutive words
+ * of the same cache lines and inserting never allocates. Erase uses backward shift deletion, so there are no tombstones
+ * and probe sequences stay short however long the shard runs.
+ *
+ * Insert and Erase must be serialized by the caller (the shard latch). Find may run concurrently with them: it never
+ * returns a frame that was not mapped to the page at some point, but it may miss an entry that a concurrent Erase is
+ * shifting, so a lock-free miss is only a hint.
+ */
+class PageTable {
+ public:
+  /**
+   * @param num_frames the maximum number of entries the table will hold
+   */
+  explicit PageTable(size_t num_frames);
+
+  ~PageTable();
+
+  PageTable(const PageTable &) = delete;
+  PageTable &operator=(const PageTable &) = delete;
+
+  /**
+   * @return true and the frame holding page_id if the page is in the table
+   */
+  inline bool Find(page_id_t page_id, frame_id_t *frame_id) const {
+    for (size_t slot = Hash(page_id);; slot = (slot + 1) & mask_) {
+      uint64_t entry = slots_[slot].load(std::memory_order_acquire);
+      if (entry == EMPTY_SLOT) return false;
+      if (PageOf(entry) == page_id) {
+        *frame_id = FrameOf(entry);
+        return true;
+      }
+    }
+  }
+
+  /**
+   * Map page_id to frame_id, replacing the previous mapping of page_id if there is one.
+   */
+  void Insert(page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * @return false if page_id is not in the table
+   */
+  bool Erase(page_id_t page_id);
+
+  inline size_t Size() const { return size_; }
+
+  inline size_t Capacity() const { return mask_ + 1; }
+
+ private:
+  static constexpr uint64_t EMPTY_SLOT = ~static_cast<uint64_t>(0);  // page id INVALID_PAGE_ID is never stored
+
+  static inline uint64_t MakeEntry(page_id_t page_id, frame_id_t frame_id) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(page_id)) << 32) | static_cast<uint32_t>(frame_id);
+  }
+  static inline page_id_t PageOf(uint64_t entry) { return static_cast<page_id_t>(entry >> 32); }
+  static inline frame_id_t FrameOf(uint64_t entry) { return static_cast<frame_id_t>(entry & 0xFFFFFFFF); }
+
+  /** Fibonacci hashing, page ids routed to one shard share a stride that must not map to the same slots. */
+  inline size_t Hash(page_id_t page_id) const {
+    return static_cast<size_t>((static_cast<uint32_t>(page_id) * 0x9E3779B97F4A7C15ULL) >> shift_) & mask_;
+  }
+
+  atomic<uint64_t> *slots_;
+  size_t mask_;   // number of slots - 1, the number of slots is a power of two
+  int shift_;     // 64 - log2(number of slots)
+  size_t size_{0};
+};
+
+#endif  // MINISQL_PAGE_TABLE_H
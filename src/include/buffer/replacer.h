@@ -5,6 +5,11 @@
 
 #include "common/config.h"
 
+/**
+ * Replacement policies the buffer pool can be built with.
+ */
+enum class ReplacerType { kLRU, kLRUK, kClock };
+
 /**
  * Replacer is an abstract class that tracks page usage.
  */
@@ -33,6 +38,20 @@ class Replacer {
    */
   virtual void Unpin(frame_id_t frame_id) = 0;
 
+  /**
+   * Forgets a frame entirely, e.g. because its page was deleted and the frame went back to the free list.
+   * Policies that keep access history for pinned frames must drop it here.
+   * @param frame_id the id of the frame to remove
+   */
+  virtual void Remove(frame_id_t frame_id) { Pin(frame_id); }
+
+  /**
+   * Change the number of frames tracked by the replacer when the buffer pool is resized. Before shrinking, the caller
+   * must Remove every frame whose id is num_pages or larger.
+   * @param num_pages the new number of frames
+   */
+  virtual void Resize(size_t num_pages) = 0;
+
   /** @return the number of elements in the replacer that can be victimized */
   virtual size_t Size() = 0;
 };
@@ -76,7 +76,8 @@ class CatalogManager {
 
   ~CatalogManager();
 
-  dberr_t CreateTable(const std::string &table_name, TableSchema *schema, Txn *txn, TableInfo *&table_info);
+  dberr_t CreateTable(const std::string &table_name, TableSchema *schema, Txn *txn, TableInfo *&table_info,
+                      TableFormat format = TableFormat::kRowFormat, bool compressed = false);
 
   dberr_t GetTable(const std::string &table_name, TableInfo *&table_info);
 
@@ -25,7 +25,7 @@ class TableMetadata {
    * will create new table schema and owned by mem heap
    */
   static TableMetadata *Create(table_id_t table_id, std::string table_name, page_id_t root_page_id,
-                               TableSchema *schema);
+                               TableSchema *schema, bool compressed = false);
 
   inline table_id_t GetTableId() const { return table_id_; }
 
@@ -35,17 +35,23 @@ class TableMetadata {
 
   inline Schema *GetSchema() const { return schema_; }
 
+  /** @return true if the pages of the table are stored compressed, see DiskManager */
+  inline bool IsCompressed() const { return compressed_; }
+
  private:
   TableMetadata() = delete;
 
-  TableMetadata(table_id_t table_id, std::string table_name, page_id_t root_page_id, TableSchema *schema);
+  TableMetadata(table_id_t table_id, std::string table_name, page_id_t root_page_id, TableSchema *schema,
+                bool compressed);
 
  private:
   static constexpr uint32_t TABLE_METADATA_MAGIC_NUM = 344528;
+  static constexpr uint32_t TABLE_METADATA_OPTIONS_MAGIC_NUM = 344529;  // followed by the storage options
   table_id_t table_id_;
   std::string table_name_;
   page_id_t root_page_id_;
   Schema *schema_;
+  bool compressed_;
 };
 
 /**
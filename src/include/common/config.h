@@ -13,11 +13,36 @@ static constexpr int META_PAGE_ID = 0;          // physical page id of the disk
 static constexpr int CATALOG_META_PAGE_ID = 0;  // logical page id of the catalog meta data
 static constexpr int INDEX_ROOTS_PAGE_ID = 1;   // logical page id of the index roots
 
-static constexpr int PAGE_SIZE = 4096;                  // size of a data page in byte
+// 页大小在编译时选定（CMake选项MINISQL_PAGE_SIZE），并记录在每个数据库文件的meta page中
+#ifndef MINISQL_PAGE_SIZE
+#define MINISQL_PAGE_SIZE 4096
+#endif
+static constexpr int PAGE_SIZE = MINISQL_PAGE_SIZE;     // size of a data page in byte
+static_assert(PAGE_SIZE == 4096 || PAGE_SIZE == 8192 || PAGE_SIZE == 16384 || PAGE_SIZE == 32768,
+              "Supported page sizes are 4, 8, 16 and 32 KB.");
 static constexpr int DEFAULT_BUFFER_POOL_SIZE = 20480;  // default size of buffer pool
+static constexpr int DEFAULT_BUFFER_POOL_INSTANCES = 8;  // default number of buffer pool shards
+static constexpr int BUFFER_POOL_CHUNK_SIZE = 1024;      // frames a shard allocates or releases at a time on resize
+static constexpr int LRUK_REPLACER_K = 2;               // number of references remembered by LRU-K
+static constexpr int LRUK_CORRELATED_PERIOD = 4;        // references closer than this (in accesses) are correlated
+static constexpr double PAGE_CLEANER_CLEAN_RATIO = 0.2;  // fraction of evictable frames the page cleaner keeps clean
+static constexpr int PAGE_CLEANER_INTERVAL_MS = 10;      // how often the page cleaner wakes up
+static constexpr int PAGE_CLEANER_BATCH_SIZE = 64;       // max pages the page cleaner writes per shard and round
+static constexpr int PAGE_CLEANER_WRITE_RETRIES = 3;     // retries of a failed write-back of already evicted pages
+static constexpr int PREFETCH_QUEUE_CAPACITY = 256;      // pending read-ahead requests, later ones are dropped
+static constexpr int TABLE_READ_AHEAD_PAGES = 8;         // pages a table scan keeps read ahead of itself
+static constexpr int BUFFER_RING_SIZE = 32;              // frames a bulk read may recycle, see BufferAccessStrategy
+static constexpr int ASYNC_IO_QUEUE_DEPTH = 64;          // asynchronous I/O requests a DiskManager keeps in flight
+static constexpr int ASYNC_IO_THREADS = 4;               // workers of the asynchronous I/O fallback without io_uring
+static constexpr int FILE_PREALLOCATE_PAGES = 256;       // pages the db file is preallocated by when it grows
+static constexpr int COMPRESSED_BLOCK_SIZE = 512;        // a compressed page is stored in a multiple of this size
+static constexpr int PARALLEL_SCAN_MORSEL_PAGES = 16;    // pages a worker of a parallel scan takes at a time
+static constexpr int PARALLEL_SCAN_MIN_PAGES = 64;       // smaller tables are scanned by a single thread
+static constexpr int ROW_INLINE_SIZE = PAGE_SIZE / 4;    // larger rows keep their longest char values in overflow pages
 
 static constexpr uint32_t FIELD_NULL_LEN = UINT32_MAX;
-static constexpr uint32_t VARCHAR_MAX_LEN = PAGE_SIZE / 2;  // max length of varchar
+static constexpr uint32_t VARCHAR_MAX_LEN = 1U << 24;         // max length of varchar
+static constexpr uint32_t CHAR_OVERFLOW_FLAG = 1U << 31;      // set in the stored length of a char in overflow pages
 
 // static std::string DB_META_FILE = "minisql.meta.db";
 
@@ -12,6 +12,7 @@ enum dberr_t {
   DB_INDEX_NOT_FOUND, // 索引未找到
   DB_COLUMN_NAME_NOT_EXIST, // 列名不存在
   DB_KEY_NOT_FOUND, // 键未找到
+  DB_READ_ONLY, // 数据库以只读方式打开，不能修改
   DB_QUIT // 数据库退出
 };
 
@@ -0,0 +1,161 @@
+#ifndef MINISQL_HYBRID_LATCH_H
+#define MINISQL_HYBRID_LATCH_H
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "macros.h"
+
+/**
+ * HybridLatch is an 8-byte reader-writer latch with optimistic reads, meant to be embedded in every frame descriptor.
+ *
+ * The state word holds the number of shared holders, an exclusive bit and a "somebody is parked" bit. An uncontended
+ * RLock/RUnlock or WLock/WUnlock is a single atomic read-modify-write. A thread that cannot get the latch spins briefly
+ * and then parks on the state word with a futex; unlocks only enter the kernel when the parked bit is set.
+ *
+ * Like ReaderWriterLatch, a writer announces itself before the readers have drained, so new readers wait behind it and
+ * a stream of readers cannot starve writers.
+ *
+ * The version word is a sequence lock: it is odd while a writer may be modifying the protected data, and advances on
+ * every exclusive section. An optimistic reader takes a version with TryOptimisticRead, reads without latching, and
+ * keeps what it read only if ValidateOptimisticRead still accepts the version. Optimistic readers never write to the
+ * latch, so they do not bounce its cache line between cores. Anything read optimistically may be torn and must not be
+ * dereferenced or used as a loop bound before validation.
+ */
+class HybridLatch {
+  static constexpr uint32_t EXCLUSIVE = 1u << 31;     // a writer holds the latch, or waits for the readers to leave
+  static constexpr uint32_t PARKED = 1u << 30;        // some thread sleeps on state_
+  static constexpr uint32_t READERS = PARKED - 1;     // number of shared holders
+  static constexpr int SPIN_COUNT = 64;               // tries before parking
+
+ public:
+  HybridLatch() = default;
+
+  ~HybridLatch() = default;
+
+  DISALLOW_COPY(HybridLatch);
+
+  /**
+   * Acquire a write latch.
+   */
+  void WLock() {
+    // 先抢到写标记，之后新来的读者都会等待
+    for (int spin = 0;; spin++) {
+      uint32_t state = state_.load(std::memory_order_relaxed);
+      if (!(state & EXCLUSIVE)) {
+        if (state_.compare_exchange_weak(state, state | EXCLUSIVE, std::memory_order_acquire)) break;
+        continue;
+      }
+      Backoff(spin, state);
+    }
+    // 再等已经进入的读者离开
+    for (int spin = 0;; spin++) {
+      uint32_t state = state_.load(std::memory_order_acquire);
+      if ((state & READERS) == 0) break;
+      Backoff(spin, state);
+    }
+    // 版本号变成奇数，乐观读者在写完之前都无法通过验证
+    version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  /**
+   * Release a write latch.
+   */
+  void WUnlock() {
+    version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    // 持有写锁时不会有读者计数，直接清空
+    if (state_.exchange(0, std::memory_order_release) & PARKED) Wake();
+  }
+
+  /**
+   * Acquire a read latch.
+   */
+  void RLock() {
+    for (int spin = 0;; spin++) {
+      uint32_t state = state_.load(std::memory_order_relaxed);
+      if (!(state & EXCLUSIVE)) {
+        ASSERT((state & READERS) != READERS, "Too many readers.");
+        if (state_.compare_exchange_weak(state, state + 1, std::memory_order_acquire)) return;
+        continue;
+      }
+      Backoff(spin, state);
+    }
+  }
+
+  /**
+   * Release a read latch.
+   */
+  void RUnlock() {
+    uint32_t state = state_.fetch_sub(1, std::memory_order_release);
+    ASSERT((state & READERS) != 0, "RUnlock failed.");
+    // 最后一个读者离开，等待中的写者需要被唤醒
+    if ((state & READERS) == 1 && (state & PARKED)) {
+      state_.fetch_and(~PARKED, std::memory_order_relaxed);
+      Wake();
+    }
+  }
+
+  /**
+   * Start an optimistic read.
+   * @param[out] version to pass to ValidateOptimisticRead once the data has been read
+   * @return false if a writer holds the latch, the caller should retry or fall back to RLock
+   */
+  inline bool TryOptimisticRead(uint32_t *version) const {
+    *version = version_.load(std::memory_order_acquire);
+    return (*version & 1) == 0;
+  }
+
+  /**
+   * @return true if no writer entered the latch since TryOptimisticRead returned version, i.e. the data read in
+   * between is consistent
+   */
+  inline bool ValidateOptimisticRead(uint32_t version) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version_.load(std::memory_order_relaxed) == version;
+  }
+
+ private:
+  /**
+   * Wait a little for state_ to change from state: spin first, then sleep until an unlock wakes us up.
+   */
+  void Backoff(int spin, uint32_t state) {
+    if (spin < SPIN_COUNT) {
+#if defined(__x86_64__) || defined(__i386__)
+      __builtin_ia32_pause();
+#endif
+      return;
+    }
+    // 先挂上parked标记，释放的一方看到它才会进内核唤醒
+    if (!(state & PARKED) && !state_.compare_exchange_strong(state, state | PARKED, std::memory_order_relaxed)) {
+      return;
+    }
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&state_), FUTEX_WAIT_PRIVATE, state | PARKED, nullptr, nullptr, 0);
+#else
+    std::this_thread::yield();
+#endif
+  }
+
+  /** Wake up every thread parked on state_, they compete for the latch again. */
+  void Wake() {
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&state_), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#endif
+  }
+
+  std::atomic<uint32_t> state_{0};    // EXCLUSIVE | PARKED | number of readers
+  std::atomic<uint32_t> version_{0};  // odd while a writer may be modifying the data
+};
+
+static_assert(sizeof(HybridLatch) == 8, "HybridLatch must stay one word.");
+
+#endif  // MINISQL_HYBRID_LATCH_H
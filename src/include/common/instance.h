@@ -14,7 +14,12 @@
 
 class DBStorageEngine {
  public:
-  explicit DBStorageEngine(std::string db_name, bool init = true, uint32_t buffer_pool_size = DEFAULT_BUFFER_POOL_SIZE);
+  /**
+   * @param read_only open an existing database for queries only: the file is mapped into memory and pages are read
+   * from the mapping without going through buffer frames, see DiskManager. init must be false then.
+   */
+  explicit DBStorageEngine(std::string db_name, bool init = true, uint32_t buffer_pool_size = DEFAULT_BUFFER_POOL_SIZE,
+                           uint32_t buffer_pool_instances = DEFAULT_BUFFER_POOL_INSTANCES, bool read_only = false);
 
   ~DBStorageEngine();
 
@@ -25,7 +30,9 @@ class DBStorageEngine {
   BufferPoolManager *bpm_;
   CatalogManager *catalog_mgr_;
   std::string db_file_name_;
+  std::string warm_up_file_name_;  // resident pages saved on shutdown, a dot file so it is not taken for a database
   bool init_;
+  bool read_only_;
 };
 
 #endif  // MINISQL_INSTANCE_H
@@ -22,7 +22,11 @@ extern "C" {
  */
 class ExecuteEngine {
  public:
-  ExecuteEngine();
+  /**
+   * @param read_only open the existing databases read-only, see DBStorageEngine. Statements that would modify a
+   * database, or create or drop one, then fail with DB_READ_ONLY.
+   */
+  explicit ExecuteEngine(bool read_only = false);
 
 	// ExecuteEngine的析构函数,需要delete所有DBStorageEngine
   ~ExecuteEngine() {
@@ -81,6 +85,14 @@ class ExecuteEngine {
 	// show indexes;
   dberr_t ExecuteShowIndexes(pSyntaxNode ast, ExecuteContext *context);
 
+	// 打印当前数据库buffer pool的命中率、换出、写回等统计信息
+	// SHOW BUFFER STATUS;
+  dberr_t ExecuteShowStatus(pSyntaxNode ast, ExecuteContext *context);
+
+	// 在线调整当前数据库buffer pool的大小（页数）
+	// SET buffer_pool_size = 4096;
+  dberr_t ExecuteSetVariable(pSyntaxNode ast, ExecuteContext *context);
+
   dberr_t ExecuteCreateIndex(pSyntaxNode ast, ExecuteContext *context);
 
 	// 删除某个索引
@@ -106,6 +118,7 @@ class ExecuteEngine {
   // 如果有多个数据库,可以使用using语句切换,所以说需要有一个变量指定当前有效的数据库
 	// 数据库通过string来唯一标识
 	std::string current_db_;                                 /** current database */
+  bool read_only_;                                         /** databases are opened read-only */
 };
 
 #endif  // MINISQL_EXECUTE_ENGINE_H
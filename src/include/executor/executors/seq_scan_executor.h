@@ -5,14 +5,18 @@
 #ifndef MINISQL_SEQ_SCAN_EXECUTOR_H
 #define MINISQL_SEQ_SCAN_EXECUTOR_H
 
+#include <memory>
 #include <vector>
 
 #include "executor/execute_context.h"
 #include "executor/executors/abstract_executor.h"
 #include "executor/plans/seq_scan_plan.h"
+#include "storage/parallel_table_scan.h"
+#include "storage/table_scan_cursor.h"
 
 /**
- * The SeqScanExecutor executor executes a sequential table scan.
+ * The SeqScanExecutor executor executes a sequential table scan. A large table is scanned by one worker per core,
+ * which evaluate the predicate in place, see ParallelTableScan.
  */
 class SeqScanExecutor : public AbstractExecutor {
  public:
@@ -39,15 +43,18 @@ class SeqScanExecutor : public AbstractExecutor {
 
   bool SchemaEqual(const Schema *table_schema, const Schema *output_schema);
 
-  void TupleTransfer(const Schema *table_schema, const Schema *output_schema, const Row *row, Row *output_row);
-
  private:
   /** The sequential scan plan node to be executed */
   const SeqScanPlanNode *plan_;
   TableInfo *table_info_{};
-  TableIterator iterator_;
+  /** Rows are filtered in place in the table pages, only the rows produced are deserialized */
+  std::unique_ptr<TableScanCursor> cursor_;
+  /** Used instead of cursor_ for tables of at least PARALLEL_SCAN_MIN_PAGES pages */
+  std::unique_ptr<ParallelTableScan> parallel_scan_;
   const Schema *schema_{};
   bool is_schema_same_;
+  /** Table columns of the output columns, used when the schemas differ */
+  std::vector<uint32_t> column_ids_;
 };
 
 #endif  // MINISQL_SEQ_SCAN_EXECUTOR_H
@@ -29,11 +29,19 @@ class SeqScanPlanNode : public AbstractPlanNode {
 
   AbstractExpressionRef GetPredicate() const { return filter_predicate_; }
 
+  /** @return true if large tables may be scanned by several threads, see ParallelTableScan */
+  bool IsParallel() const { return parallel_; }
+
+  void SetParallel(bool parallel) { parallel_ = parallel; }
+
   /** The table name */
   std::string table_name_;
 
   /** The predicate to filter in SeqScan.*/
   AbstractExpressionRef filter_predicate_;
+
+  /** Whether the scan may run in parallel, the rows come in the same order either way. */
+  bool parallel_{true};
 };
 
 #endif  // MINISQL_SEQ_SCAN_PLAN_H
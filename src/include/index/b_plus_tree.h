@@ -1,6 +1,7 @@
 #ifndef MINISQL_B_PLUS_TREE_H
 #define MINISQL_B_PLUS_TREE_H
 
+#include <fstream>
 #include <queue>
 #include <string>
 #include <vector>
@@ -107,6 +108,7 @@ class BPlusTree {
   KeyManager processor_;
   int leaf_max_size_;
   int internal_max_size_;
+  PageRun page_run_;  // pages reserved for this tree, so that its nodes stay together on disk
 };
 
 #endif  // MINISQL_B_PLUS_TREE_H
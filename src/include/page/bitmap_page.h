@@ -6,6 +6,11 @@
 #include "common/config.h"
 #include "common/macros.h"
 
+/**
+ * BitmapPage records which pages of an extent are allocated, one bit per page, most significant bit of each byte
+ * first. next_free_page_ is kept as a hint: every page below it is allocated. Free pages are searched for one 64-bit
+ * word at a time.
+ */
 template <size_t PageSize>
 class BitmapPage {
  public:
@@ -20,6 +25,12 @@ class BitmapPage {
    */
   bool AllocatePage(uint32_t &page_offset);
 
+  /**
+   * Allocate a given page of the extent.
+   * @return true if the page was free.
+   */
+  bool AllocatePageAt(uint32_t page_offset);
+
   /**
    * @return true if successfully de-allocate a page.
    */
@@ -30,6 +41,22 @@ class BitmapPage {
    */
   bool IsPageFree(uint32_t page_offset) const;
 
+  /**
+   * @return the first free page at or after start, GetMaxSupportedSize() if there is none
+   */
+  uint32_t FindFreePage(uint32_t start) const;
+
+  /**
+   * @return the lowest free page of the extent, GetMaxSupportedSize() if there is none
+   */
+  uint32_t FirstFreePage() const;
+
+  /**
+   * @return the first page at or after start that begins 64 free pages, aligned to 64 pages, GetMaxSupportedSize()
+   * if there is none
+   */
+  uint32_t FindFreeRun(uint32_t start) const;
+
  private:
   /**
    * check a bit(byte_index, bit_index) in bytes is free(value 0).
@@ -40,9 +67,14 @@ class BitmapPage {
    */
   bool IsPageFreeLow(uint32_t byte_index, uint8_t bit_index) const;
 
+  /** @return the 64 bits of pages [64 * word_index, 64 * word_index + 64), the lowest page in the highest bit */
+  uint64_t GetWord(size_t word_index) const;
+
   /** Note: need to update if modify page structure. */
   static constexpr size_t MAX_CHARS = PageSize - 2 * sizeof(uint32_t);
 
+  static_assert(MAX_CHARS % sizeof(uint64_t) == 0, "The bitmap must consist of whole 64-bit words.");
+
  private:
   /** The space occupied by all members of the class should be equal to the PageSize */
   [[maybe_unused]] uint32_t page_allocated_;
@@ -2,11 +2,16 @@
 #define MINISQL_DISK_FILE_META_PAGE_H
 
 #include <cstdint>
+#include <cstring>
 
 #include "page/bitmap_page.h"
 
-static constexpr page_id_t MAX_VALID_PAGE_ID = (PAGE_SIZE - 8) / 4 * BitmapPage<PAGE_SIZE>::GetMaxSupportedSize();
-
+/**
+ * DiskFileMetaPage is the first physical page of a database file. It starts with a magic number and the page size the
+ * file was created with, followed by the number of allocated pages and extents and the pages used in each extent.
+ *
+ * Files written before the page size was recorded lack the two leading fields, see DiskFileMetaPage::UpgradeLegacy.
+ */
 class DiskFileMetaPage {
  public:
   uint32_t GetExtentNums() { return num_extents_; }
@@ -20,10 +25,47 @@ class DiskFileMetaPage {
     return extent_used_page_[extent_id];
   }
 
+  /** @return true if the page starts with the magic number, false for a new or a legacy file */
+  inline bool HasMagicNum() const { return magic_num_ == MAGIC_NUM; }
+
+  /** @return the page size recorded in the file */
+  inline uint32_t GetPageSize() const { return page_size_; }
+
+  /** Stamp a new file with the magic number and the page size of this build. */
+  inline void Init() {
+    magic_num_ = MAGIC_NUM;
+    page_size_ = PAGE_SIZE;
+  }
+
+  /**
+   * Convert a page in the legacy 4 KB layout, which lacks the magic number and the page size, in place.
+   * @return false if the legacy page uses extents the new layout has no room for
+   */
+  inline bool UpgradeLegacy() {
+    auto *words = reinterpret_cast<uint32_t *>(this);
+    // 旧格式: | num_allocated_pages_ | num_extents_ | extent_used_page_[(PAGE_SIZE - 8) / 4] |
+    for (size_t i = MAX_EXTENTS; i < (PAGE_SIZE - 2 * sizeof(uint32_t)) / sizeof(uint32_t); i++) {
+      if (words[2 + i] != 0) return false;
+    }
+    memmove(words + 2, words, (2 + MAX_EXTENTS) * sizeof(uint32_t));
+    Init();
+    return true;
+  }
+
+  static constexpr uint32_t MAGIC_NUM = 0x4D53444D;  // "MSDM"
+  static constexpr size_t HEADER_SIZE = 4 * sizeof(uint32_t);
+  /** Number of extents the meta page can describe. */
+  static constexpr size_t MAX_EXTENTS = (PAGE_SIZE - HEADER_SIZE) / sizeof(uint32_t);
+
  public:
+  uint32_t magic_num_{0};
+  uint32_t page_size_{0};
   uint32_t num_allocated_pages_{0};
   uint32_t num_extents_{0};  // each extent consists with a bit map and BIT_MAP_SIZE pages
   uint32_t extent_used_page_[0];
 };
 
+static constexpr page_id_t MAX_VALID_PAGE_ID =
+    DiskFileMetaPage::MAX_EXTENTS * BitmapPage<PAGE_SIZE>::GetMaxSupportedSize();
+
 #endif  // MINISQL_DISK_FILE_META_PAGE_H
@@ -0,0 +1,77 @@
+#ifndef MINISQL_FREE_SPACE_MAP_PAGE_H
+#define MINISQL_FREE_SPACE_MAP_PAGE_H
+
+#include <cstdint>
+
+#include "common/config.h"
+
+/**
+ * FreeSpaceMapPage lists the pages of a table heap in the order of the page chain, each with the class of its free
+ * space: a page of class c has room for a row of c * CLASS_UNIT bytes. The pages of a heap's map are chained, see
+ * TableHeap.
+ *
+ * Format (size in byte):
+ *  ------------------------------------------------------------------------------------------------
+ * | NextPageId (4) | PageCount (4) | PageId_1 (4) | ... | PageId_N (4) | Class_1 (1) | ... | Class_N (1) |
+ *  ------------------------------------------------------------------------------------------------
+ */
+class FreeSpaceMapPage {
+ public:
+  void Init() {
+    next_page_id_ = INVALID_PAGE_ID;
+    count_ = 0;
+  }
+
+  inline page_id_t GetNextPageId() const { return next_page_id_; }
+
+  inline void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+  inline uint32_t GetCount() const { return count_; }
+
+  inline bool IsFull() const { return count_ >= CAPACITY; }
+
+  inline page_id_t GetHeapPageId(uint32_t index) const { return page_ids_[index]; }
+
+  inline uint8_t GetClass(uint32_t index) const { return GetClasses()[index]; }
+
+  inline void SetClass(uint32_t index, uint8_t space_class) { GetClasses()[index] = space_class; }
+
+  /**
+   * Add a heap page at the end of the list.
+   * @return false if the page is full
+   */
+  bool Append(page_id_t heap_page_id, uint8_t space_class);
+
+  /**
+   * @return the index of the first heap page of at least space_class, GetCount() if there is none
+   */
+  uint32_t FindPage(uint8_t space_class) const;
+
+  /** @return the largest class of the listed heap pages, 0 if there are none */
+  uint8_t GetMaxClass() const;
+
+  /** @return the class of a page with free_space bytes of room for a row */
+  static inline uint8_t ToClass(uint32_t free_space) {
+    return static_cast<uint8_t>(free_space / CLASS_UNIT < CLASS_COUNT - 1 ? free_space / CLASS_UNIT : CLASS_COUNT - 1);
+  }
+
+  /** @return the class a page needs to hold a row of size bytes, CLASS_COUNT or more if no class guarantees it */
+  static inline uint32_t ClassFor(uint32_t size) { return (size + CLASS_UNIT - 1) / CLASS_UNIT; }
+
+  static constexpr uint32_t CLASS_COUNT = 256;
+  static constexpr uint32_t CLASS_UNIT = PAGE_SIZE / CLASS_COUNT;
+  /** Number of heap pages one page of the map lists, 5 bytes each. */
+  static constexpr uint32_t CAPACITY = (PAGE_SIZE - 2 * sizeof(uint32_t)) / (sizeof(page_id_t) + 1);
+
+ private:
+  inline const uint8_t *GetClasses() const { return reinterpret_cast<const uint8_t *>(page_ids_ + CAPACITY); }
+
+  inline uint8_t *GetClasses() { return reinterpret_cast<uint8_t *>(page_ids_ + CAPACITY); }
+
+ private:
+  page_id_t next_page_id_;
+  uint32_t count_;
+  page_id_t page_ids_[0];
+};
+
+#endif  // MINISQL_FREE_SPACE_MAP_PAGE_H
@@ -0,0 +1,42 @@
+#ifndef MINISQL_OVERFLOW_PAGE_H
+#define MINISQL_OVERFLOW_PAGE_H
+
+#include <cstdint>
+
+#include "common/config.h"
+
+/**
+ * OverflowPage holds a part of a char value too long to stay in its row. The parts of a value are in a chain of
+ * overflow pages, in order; the row keeps the length of the value and the first page of the chain, see TableHeap.
+ *
+ * Format (size in byte):
+ *  ------------------------------------------------
+ * | NextPageId (4) | Size (4) | Data (Size) | ... |
+ *  ------------------------------------------------
+ */
+class OverflowPage {
+ public:
+  void Init(page_id_t next_page_id, uint32_t size) {
+    next_page_id_ = next_page_id;
+    size_ = size;
+  }
+
+  inline page_id_t GetNextPageId() const { return next_page_id_; }
+
+  inline void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+  /** @return number of bytes of the value on this page */
+  inline uint32_t GetSize() const { return size_; }
+
+  inline char *GetData() { return data_; }
+
+  /** Number of bytes of a value one overflow page holds. */
+  static constexpr uint32_t CAPACITY = PAGE_SIZE - sizeof(page_id_t) - sizeof(uint32_t);
+
+ private:
+  page_id_t next_page_id_;
+  uint32_t size_;
+  char data_[0];
+};
+
+#endif  // MINISQL_OVERFLOW_PAGE_H
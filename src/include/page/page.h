@@ -3,28 +3,39 @@
 
 #include <cstring>
 #include <iostream>
+#include <new>
 #include <shared_mutex>
 
 #include "common/config.h"
-#include "common/rwlatch.h"
+#include "common/hybrid_latch.h"
 
 /**
  * Page is the basic unit of storage within the database system. Page provides a wrapper for actual data pages being
  * held in main memory. Page also contains book-keeping information that is used by the buffer pool manager, e.g.
  * pin count, dirty flag, page id, etc.
+ *
+ * Page itself is only the frame descriptor: the page content lives in a separate PAGE_SIZE aligned buffer. The buffer
+ * pool points its descriptors into one frame arena, so scanning the descriptors never touches page data. A Page
+ * created on its own allocates and owns its buffer.
  */
 class Page {
   // There is book-keeping information inside the page that should only be relevant to the buffer pool manager.
   friend class BufferPoolManager;
+  friend class BufferPoolManagerInstance;
 
  public:
   DISALLOW_COPY(Page)
 
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /** Constructor. Allocates a zeroed buffer owned by this page. */
+  Page() : data_(new (std::align_val_t(PAGE_SIZE)) char[PAGE_SIZE]), owns_data_(true) { ResetMemory(); }
 
-  /** Default destructor. */
-  ~Page() = default;
+  /** Constructor. Wraps a buffer of PAGE_SIZE bytes owned by somebody else, e.g. a frame of the buffer pool. */
+  explicit Page(char *data) : data_(data) {}
+
+  /** Destructor. Frees the buffer if this page owns it. */
+  ~Page() {
+    if (owns_data_) operator delete[](data_, std::align_val_t(PAGE_SIZE));
+  }
 
   /** @return the actual data contained within this page */
   inline char *GetData() { return data_; }
@@ -50,6 +61,15 @@ class Page {
   /** Release the page read latch. */
   inline void RUnlatch() { rwlatch_.RUnlock(); }
 
+  /**
+   * Start reading the page without latching it, see HybridLatch.
+   * @return false if a writer holds the page latch
+   */
+  inline bool TryOptimisticRead(uint32_t *version) const { return rwlatch_.TryOptimisticRead(version); }
+
+  /** @return true if the page was not modified since TryOptimisticRead returned version */
+  inline bool ValidateOptimisticRead(uint32_t version) const { return rwlatch_.ValidateOptimisticRead(version); }
+
   /** @return the page LSN. */
   inline lsn_t GetLSN() { return *reinterpret_cast<lsn_t *>(GetData() + OFFSET_LSN); }
 
@@ -70,7 +90,9 @@ class Page {
   inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, PAGE_SIZE); }
 
   /** The actual data that is stored within a page. */
-  char data_[PAGE_SIZE]{};
+  char *data_;
+  /** True if data_ was allocated by this page. */
+  bool owns_data_ = false;
   /** The ID of this page. */
   page_id_t page_id_ = INVALID_PAGE_ID;
   /** The pin count of this page. */
@@ -78,7 +100,7 @@ class Page {
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
   bool is_dirty_ = false;
   /** Page latch. */
-  ReaderWriterLatch rwlatch_;
+  HybridLatch rwlatch_;
 };
 
 #endif  // MINISQL_PAGE_H
@@ -0,0 +1,142 @@
+#ifndef MINISQL_PAX_PAGE_H
+#define MINISQL_PAX_PAGE_H
+
+#include "page/table_page.h"
+
+/**
+ * PaxPage is the PAX (partition attributes across) layout of a table page. Instead of whole rows, the page holds one
+ * minipage per column with the values of that column for all its slots, so that reading a column of a row needs
+ * neither the other columns nor a deserialized Row. The number of slots is fixed by Init from the schema: every slot
+ * has room in the fixed width minipages, while char values are kept in a heap at the end of the page.
+ *
+ * Format (size in byte):
+ *  -----------------------------------------------------------------------------------------------------
+ * | PageId (4) | LSN (4) | PrevPageId (4) | NextPageId (4) | PaxMark (4) | SlotCount (4) | RowCount (4) |
+ *  -----------------------------------------------------------------------------------------------------
+ *  -------------------------------------------------------------------------------------------------------------
+ * | ColumnCount (4) | HeapPointer (4) | HeapBegin (4) | HeapGarbage (4) | Column_1 type (4) | Minipage_1 (4) | ... |
+ *  -------------------------------------------------------------------------------------------------------------
+ *  ---------------------------------------------------------------------------------------------------
+ * | SlotFlag_1 (1) | ... | SlotFlag_N (1) | MINIPAGE_1 | ... | MINIPAGE_C | ... FREE SPACE ... | HEAP |
+ *  ---------------------------------------------------------------------------------------------------
+ *                                                                         ^ heap pointer
+ * A minipage starts with a null bitmap of SlotCount bits, followed by SlotCount values: 4 bytes for an int or a float,
+ * an offset (4) and a length (4) into the heap for a char. Char values of deleted or updated rows stay in the heap as
+ * garbage until an insert needs the room, the heap is compacted then. A char value kept in overflow pages takes no heap
+ * room: its length has CHAR_OVERFLOW_FLAG set, and its offset is the first overflow page instead.
+ */
+class PaxPage : public TablePage {
+ public:
+  void Init(page_id_t page_id, page_id_t prev_id, Schema *schema, LogManager *log_mgr, Txn *txn);
+
+  bool InsertTuple(Row &row, Schema *schema, Txn *txn, LockManager *lock_manager, LogManager *log_manager);
+
+  /**
+   * Same as TablePage::InsertTuples, free slots are reused though. Serialized sizes are not needed here, the space a
+   * row takes is its fixed column width plus its char values in the heap.
+   */
+  size_t InsertTuples(std::vector<Row> &rows, size_t begin, Schema *schema);
+
+  bool MarkDelete(const RowId &rid, Txn *txn, LockManager *lock_manager, LogManager *log_manager);
+
+  /** @return 0 if updated, 1 if the page does not have room for the new row, 2 if there is no such row */
+  int UpdateTuple(const Row &new_row, Row *old_row, Schema *schema, Txn *txn, LockManager *lock_manager,
+                  LogManager *log_manager);
+
+  void ApplyDelete(const RowId &rid, Txn *txn, LogManager *log_manager);
+
+  void RollbackDelete(const RowId &rid, Txn *txn, LogManager *log_manager);
+
+  bool GetTuple(Row *row, Schema *schema, Txn *txn, LockManager *lock_manager);
+
+  bool GetFirstTupleRid(RowId *first_rid);
+
+  bool GetNextTupleRid(const RowId &cur_rid, RowId *next_rid);
+
+  /** @return true if slot_num holds a row, also if it is marked as deleted */
+  bool HasTuple(uint32_t slot_num) { return slot_num < GetSlotCount() && GetSlotFlags()[slot_num] != SLOT_FREE; }
+
+  /**
+   * @return room for a new row as GetRowSize counts it: the width of a slot plus the free heap bytes, 0 if all slots
+   * are taken
+   */
+  uint32_t GetFreeSpaceForRow();
+
+  /**
+   * @return the room row takes in a PAX page: the width of a slot, its values in the minipages rounded up to the unit
+   * of the free space map, plus its char values in the heap
+   */
+  static uint32_t GetRowSize(const Row &row, Schema *schema);
+
+  /** @return true if the given column of the row in slot_num is null */
+  bool IsNull(uint32_t slot_num, uint32_t column) {
+    return (GetMinipage(column)[slot_num / 8] & (1 << (7 - slot_num % 8))) != 0;
+  }
+
+  /**
+   * @return the given column of the row in slot_num; a char field points into the page instead of owning a copy, or
+   * only refers to its overflow pages
+   */
+  Field GetField(uint32_t slot_num, uint32_t column, bool copy = false);
+
+ private:
+  uint32_t GetHeader(size_t offset) { return *reinterpret_cast<uint32_t *>(GetData() + offset); }
+
+  void SetHeader(size_t offset, uint32_t value) { memcpy(GetData() + offset, &value, sizeof(uint32_t)); }
+
+  uint32_t GetSlotCount() { return GetHeader(OFFSET_SLOT_COUNT); }
+
+  uint32_t GetColumnCount() { return GetHeader(OFFSET_COLUMN_COUNT); }
+
+  TypeId GetColumnType(uint32_t column) {
+    return static_cast<TypeId>(GetHeader(OFFSET_COLUMNS + SIZE_COLUMN * column));
+  }
+
+  char *GetMinipage(uint32_t column) { return GetData() + GetHeader(OFFSET_COLUMNS + SIZE_COLUMN * column + 4); }
+
+  uint8_t *GetSlotFlags() {
+    return reinterpret_cast<uint8_t *>(GetData() + OFFSET_COLUMNS + SIZE_COLUMN * GetColumnCount());
+  }
+
+  /** @return the value of the given column in slot_num, behind the null bitmap of the minipage */
+  char *GetValue(uint32_t slot_num, uint32_t column) {
+    return GetMinipage(column) + (GetSlotCount() + 7) / 8 + slot_num * ValueSize(GetColumnType(column));
+  }
+
+  void SetNull(uint32_t slot_num, uint32_t column, bool is_null);
+
+  /** @return true if slot_num holds a row that is not deleted */
+  bool IsLive(uint32_t slot_num) { return slot_num < GetSlotCount() && GetSlotFlags()[slot_num] == SLOT_USED; }
+
+  /** @return the heap bytes the char values of row take */
+  static uint32_t GetHeapSize(const Row &row, Schema *schema);
+
+  /** @return the heap bytes the char values of the row in slot_num take */
+  uint32_t GetHeapSize(uint32_t slot_num);
+
+  /** Make room for size heap bytes, compacting the heap if needed. @return false if there is not enough room */
+  bool ReserveHeap(uint32_t size);
+
+  /** Write the values of row into slot_num, the heap must have room for them. */
+  void WriteRow(uint32_t slot_num, const Row &row);
+
+  /** Read the row in slot_num into row, with copies of its values. */
+  void ReadRow(uint32_t slot_num, Row *row);
+
+  static uint32_t ValueSize(TypeId type) { return type == TypeId::kTypeChar ? 2 * sizeof(uint32_t) : sizeof(uint32_t); }
+
+ private:
+  static constexpr size_t OFFSET_SLOT_COUNT = 20;
+  static constexpr size_t OFFSET_ROW_COUNT = 24;
+  static constexpr size_t OFFSET_COLUMN_COUNT = 28;
+  static constexpr size_t OFFSET_HEAP_POINTER = 32;
+  static constexpr size_t OFFSET_HEAP_BEGIN = 36;
+  static constexpr size_t OFFSET_HEAP_GARBAGE = 40;
+  static constexpr size_t OFFSET_COLUMNS = 44;
+  static constexpr size_t SIZE_COLUMN = 8;
+  static constexpr uint8_t SLOT_FREE = 0;
+  static constexpr uint8_t SLOT_USED = 1;
+  static constexpr uint8_t SLOT_DELETED = 3;  // used, and marked as deleted
+};
+
+#endif  // MINISQL_PAX_PAGE_H
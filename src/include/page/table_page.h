@@ -15,6 +15,10 @@
  *  ----------------------------------------------------------------
  *  | TupleCount (4) | Tuple_1 offset (4) | Tuple_1 size (4) | ... |
  *  ----------------------------------------------------------------
+ *
+ * A table may store its pages in the PAX layout instead, see PaxPage. Both share the page id, LSN and page chain
+ * fields; a PAX page holds PAX_MARK where the free space pointer would be, and the methods below hand it over to
+ * PaxPage, so that a table heap and its iterators use either layout through TablePage.
  **/
 
 #include <cstring>
@@ -25,12 +29,26 @@
 #include "concurrency/txn.h"
 #include "page/page.h"
 #include "record/row.h"
+#include "record/row_view.h"
 #include "recovery/log_manager.h"
 
+class PaxPage;
+
+/** Layout of the pages of a table, chosen when the table is created. */
+enum class TableFormat { kRowFormat = 0, kPaxFormat };
+
 class TablePage : public Page {
  public:
   void Init(page_id_t page_id, page_id_t prev_id, LogManager *log_mgr, Txn *txn);
 
+  /** Init the page in the given layout; schema is only needed by the PAX layout. */
+  void Init(page_id_t page_id, page_id_t prev_id, TableFormat format, Schema *schema, LogManager *log_mgr, Txn *txn);
+
+  /** @return true if the page has the PAX layout */
+  bool IsPax() { return GetFreeSpacePointer() == PAX_MARK; }
+
+  inline TableFormat GetFormat() { return IsPax() ? TableFormat::kPaxFormat : TableFormat::kRowFormat; }
+
 	// 根据TablePage的定义，TablePage最前面的部分为Header，存储TablePage的相关说明，数据
 	// 最前面的是TablePageId，通过类型转换，获得数据
   page_id_t GetTablePageId() { return *reinterpret_cast<page_id_t *>(GetData()); }
@@ -53,6 +71,13 @@ class TablePage : public Page {
 
   bool InsertTuple(Row &row, Schema *schema, Txn *txn, LockManager *lock_manager, LogManager *log_manager);
 
+  /**
+   * Append rows[begin], rows[begin + 1], ... to the page in new slots, as many as fit, without reusing empty slots.
+   * @param sizes sizes[i] is the serialized size of rows[i], so that it is not computed again
+   * @return the index of the first row that did not fit, rows.size() if all of them did
+   */
+  size_t InsertTuples(std::vector<Row> &rows, const std::vector<uint32_t> &sizes, size_t begin, Schema *schema);
+
   bool MarkDelete(const RowId &rid, Txn *txn, LockManager *lock_manager, LogManager *log_manager);
 
   int UpdateTuple(const Row &new_row, Row *old_row, Schema *schema, Txn *txn, LockManager *lock_manager,
@@ -64,10 +89,25 @@ class TablePage : public Page {
 
   bool GetTuple(Row *row, Schema *schema, Txn *txn, LockManager *lock_manager);
 
+	// tuple在页内序列化的数据，不拷贝；tuple不存在或者已经被删除时返回nullptr，PAX的page也返回nullptr
+  char *GetTupleData(const RowId &rid);
+
+	// slot里有tuple，标记删除了的也算
+  bool HasTuple(const RowId &rid);
+
+	// 不拷贝地读一个存在的tuple，标记删除了的也可以，两种格式都可以
+  RowView GetRowView(const RowId &rid, const Schema *schema);
+
   bool GetFirstTupleRid(RowId *first_rid);
 
   bool GetNextTupleRid(const RowId &cur_rid, RowId *next_rid);
 
+	// 这一页还能插入的最大的一行，剩余空间还要留出新tuple的slot
+  uint32_t GetFreeSpaceForRow();
+
+ protected:
+  inline PaxPage *AsPax() { return reinterpret_cast<PaxPage *>(this); }
+
  private:
   uint32_t GetFreeSpacePointer() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_FREE_SPACE); }
 
@@ -112,7 +152,7 @@ class TablePage : public Page {
 
   static uint32_t UnsetDeletedFlag(uint32_t tuple_size) { return static_cast<uint32_t>(tuple_size & (~DELETE_MASK)); }
 
- private:
+ protected:
   static_assert(sizeof(page_id_t) == 4);
 	// DELETE_MASK是一个位掩码，让1左移31位至32位，用于标记一个Tuple被删除
   static constexpr uint64_t DELETE_MASK = (1U << (8 * sizeof(uint32_t) - 1));
@@ -124,6 +164,7 @@ class TablePage : public Page {
   static constexpr size_t OFFSET_TUPLE_COUNT = 20; // TupleCount的偏移量
   static constexpr size_t OFFSET_TUPLE_OFFSET = 24; // TupleOffset的偏移量
   static constexpr size_t OFFSET_TUPLE_SIZE = 28; // TupleSize的偏移量
+  static constexpr uint32_t PAX_MARK = UINT32_MAX; // PAX的page在FreeSpacePointer的位置存放的标记
 
  public:
   static constexpr size_t SIZE_MAX_ROW = PAGE_SIZE - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE;
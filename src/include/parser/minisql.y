@@ -7,6 +7,8 @@
   int yyerror(char* error);
 %}
 
+%define api.header.include {"parser/minisql_yacc.h"}
+
 %union {
 	pSyntaxNode syntax_node;
 }
@@ -22,7 +24,7 @@
 %type <syntax_node> sql_create_database sql_drop_database sql_show_databases sql_use_database
 %type <syntax_node> sql_show_tables sql_create_table sql_drop_table
 %type <syntax_node> column_definition_list column_definition column_type column_list
-%type <syntax_node> sql_create_index sql_drop_index sql_show_indexes
+%type <syntax_node> sql_create_index sql_drop_index sql_show_indexes sql_show_status sql_set_variable
 %type <syntax_node> sql_trx_begin sql_trx_commit sql_trx_rollback
 %type <syntax_node> sql_select select_columns column_values column_value operator
 %type <syntax_node> connector where_conditions where_condition
@@ -49,6 +51,8 @@ sql:
   | sql_create_index { $$ = $1; }
   | sql_drop_index { $$ = $1; }
   | sql_show_indexes { $$ = $1; }
+  | sql_show_status { $$ = $1; }
+  | sql_set_variable { $$ = $1; }
   | sql_select { $$ = $1; }
   | sql_insert { $$ = $1; }
   | sql_delete { $$ = $1; }
@@ -101,6 +105,16 @@ sql_create_table:
     SyntaxNodeAddChildren($$, $3);
     SyntaxNodeAddChildren($$, list_node);
   }
+  | CREATE TABLE IDENTIFIER '(' column_definition_list ')' USING column_list {
+    $$ = CreateSyntaxNode(kNodeCreateTable, NULL);
+    pSyntaxNode list_node = CreateSyntaxNode(kNodeColumnDefinitionList, NULL);
+    SyntaxNodeAddChildren(list_node, $5);
+    SyntaxNodeAddChildren($$, $3);
+    SyntaxNodeAddChildren($$, list_node);
+    pSyntaxNode table_format_node = CreateSyntaxNode(kNodeTableFormat, "table options");
+    SyntaxNodeAddChildren(table_format_node, $8);
+    SyntaxNodeAddChildren($$, table_format_node);
+  }
   ;
 
 column_list:
@@ -195,6 +209,22 @@ sql_show_indexes:
   }
   ;
 
+sql_show_status:
+  SHOW IDENTIFIER IDENTIFIER {
+    $$ = CreateSyntaxNode(kNodeShowStatus, NULL);
+    SyntaxNodeAddChildren($$, $2);
+    SyntaxNodeAddSibling($2, $3);
+  }
+  ;
+
+sql_set_variable:
+  SET IDENTIFIER EQ NUMBER {
+    $$ = CreateSyntaxNode(kNodeSetVariable, NULL);
+    SyntaxNodeAddChildren($$, $2);
+    SyntaxNodeAddSibling($2, $4);
+  }
+  ;
+
 sql_select:
   SELECT select_columns FROM IDENTIFIER {
     $$ = CreateSyntaxNode(kNodeSelect, NULL);
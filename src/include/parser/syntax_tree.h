@@ -44,7 +44,10 @@ typedef enum {
   kNodeIndexType,            /** type of index */
   kNodeTrxBegin,             /** begin recovery command */
   kNodeTrxCommit,            /** commit recovery command */
-  kNodeTrxRollback           /** rollback recovery command */
+  kNodeTrxRollback,          /** rollback recovery command */
+  kNodeShowStatus,           /** show status command, eg: show buffer status */
+  kNodeSetVariable,          /** set variable command, eg: set buffer_pool_size = 4096 */
+  kNodeTableFormat           /** storage options of a table, eg: create table ... using pax, compressed */
 } SyntaxNodeType;
 
 /**
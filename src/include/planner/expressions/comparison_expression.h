@@ -26,6 +26,11 @@ class ComparisonExpression : public AbstractExpression {
     Field rhs = GetChildAt(1)->Evaluate(row);
     return Field(kTypeInt, PerformComparison(lhs, rhs));
   }
+  Field Evaluate(const RowView &row) const override {
+    Field lhs = GetChildAt(0)->Evaluate(row);
+    Field rhs = GetChildAt(1)->Evaluate(row);
+    return Field(kTypeInt, PerformComparison(lhs, rhs));
+  }
 
   Field EvaluateJoin(const Row *left_row, const Row *right_row) const override {
     Field lhs = GetChildAt(0)->EvaluateJoin(left_row, right_row);
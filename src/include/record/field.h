@@ -67,12 +67,20 @@ class Field {
     }
   }
 
+  // char存在overflow page里，只记下长度和第一个overflow page，用到时再由TableHeap读出来
+  explicit Field(TypeId type, uint32_t len, page_id_t overflow_page_id)
+      : type_id_(type), len_(len), overflow_page_id_(overflow_page_id) {
+    ASSERT(type == TypeId::kTypeChar, "Invalid type.");
+    value_.chars_ = nullptr;
+  }
+
   // copy constructor
   explicit Field(const Field &other) {
     type_id_ = other.type_id_;
     len_ = other.len_;
     is_null_ = other.is_null_;
     manage_data_ = other.manage_data_;
+    overflow_page_id_ = other.overflow_page_id_;
     if (type_id_ == TypeId::kTypeChar && !is_null_ && manage_data_) {
       value_.chars_ = new char[len_];
       memcpy(value_.chars_, other.value_.chars_, len_);
@@ -93,6 +101,11 @@ class Field {
 
   inline TypeId GetTypeId() const { return type_id_; }
 
+  /** @return true if the char value is not here but in overflow pages, see TableHeap::ReadOverflow */
+  inline bool IsOverflow() const { return overflow_page_id_ != INVALID_PAGE_ID; }
+
+  inline page_id_t GetOverflowPageId() const { return overflow_page_id_; }
+
   inline const char *GetData() const { return Type::GetInstance(type_id_)->GetData(*this); }
 
   inline uint32_t SerializeTo(char *buf) const { return Type::GetInstance(type_id_)->SerializeTo(*this, buf); }
@@ -136,6 +149,7 @@ class Field {
     std::swap(first.len_, second.len_);
     std::swap(first.is_null_, second.is_null_);
     std::swap(first.manage_data_, second.manage_data_);
+    std::swap(first.overflow_page_id_, second.overflow_page_id_);
   }
 
   std::string toString() {
@@ -165,6 +179,7 @@ class Field {
   uint32_t len_;
   bool is_null_{false};
   bool manage_data_{false}; // 是否具有数据的所有权
+  page_id_t overflow_page_id_{INVALID_PAGE_ID};  // 值存在overflow page里时，第一个overflow page
 };
 
 #endif  // MINISQL_FIELD_H
@@ -0,0 +1,81 @@
+#ifndef MINISQL_ROW_VIEW_H
+#define MINISQL_ROW_VIEW_H
+
+#include <vector>
+
+#include "common/macros.h"
+#include "common/rowid.h"
+#include "record/field.h"
+#include "record/row.h"
+#include "record/schema.h"
+
+class PaxPage;
+
+class TableHeap;
+
+/**
+ * RowView reads a serialized row (see Row for the format) where it lies, typically inside a pinned TablePage, instead
+ * of deserializing it into newly allocated Fields. A field is only decoded when it is asked for, by skipping the
+ * fields in front of it.
+ *
+ * The view does not own the bytes: it is valid as long as they are, e.g. until the TableScanCursor that returned it
+ * moves on or releases its latch. Fields returned by GetField point into the bytes as well; ToRow makes a Row that
+ * owns its data.
+ *
+ * A row of a PaxPage has no serialized bytes; its view reads each field straight from the minipage of the column.
+ *
+ * A char value kept in overflow pages is only read from them when it is asked for, by GetField or ToRow, and only if
+ * the view knows the TableHeap of the row; otherwise the field returned merely refers to the pages, see
+ * Field::IsOverflow.
+ */
+class RowView {
+ public:
+  RowView() = default;
+
+  RowView(char *data, const Schema *schema, RowId rid) : data_(data), schema_(schema), rid_(rid) {}
+
+  RowView(PaxPage *pax_page, uint32_t slot_num, const Schema *schema, RowId rid)
+      : pax_page_(pax_page), slot_num_(slot_num), schema_(schema), rid_(rid) {}
+
+  inline RowId GetRowId() const { return rid_; }
+
+  /** Read char values kept in overflow pages from the pages of table_heap. */
+  inline void SetTableHeap(TableHeap *table_heap) { table_heap_ = table_heap; }
+
+  inline uint32_t GetFieldCount() const {
+    return pax_page_ != nullptr ? schema_->GetColumnCount() : MACH_READ_UINT32(data_);
+  }
+
+  /** @return true if the field is null */
+  bool IsNull(uint32_t idx) const;
+
+  /**
+   * @return the field idx, decoded on the spot. A char field points into the row instead of owning a copy, so no memory
+   * is allocated.
+   */
+  Field GetField(uint32_t idx) const;
+
+  /**
+   * Deserialize the whole row into row, with its row id.
+   */
+  void ToRow(Row *row) const;
+
+  /**
+   * Deserialize only the given fields, in the given order, into row, with the row id of this row.
+   */
+  void ToRow(const std::vector<uint32_t> &column_ids, Row *row) const;
+
+ private:
+  /** @return the start of field idx, found by skipping the fields in front of it */
+  char *GetFieldData(uint32_t idx) const;
+
+ private:
+  char *data_{nullptr};
+  PaxPage *pax_page_{nullptr};
+  uint32_t slot_num_{0};
+  const Schema *schema_{nullptr};
+  RowId rid_{};
+  TableHeap *table_heap_{nullptr};
+};
+
+#endif  // MINISQL_ROW_VIEW_H
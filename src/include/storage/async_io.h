@@ -0,0 +1,150 @@
+#ifndef MINISQL_ASYNC_IO_H
+#define MINISQL_ASYNC_IO_H
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common/config.h"
+
+/** Completion of an asynchronous I/O: the number of bytes transferred, or -errno. */
+using IOCallback = std::function<void(ssize_t result)>;
+
+/**
+ * AsyncIO keeps many positional reads and writes on one file in flight at the same time. Submit returns as soon as the
+ * request is queued; the callback runs on an internal thread once the request is done, so it must be short and must
+ * not wait for another request of the same AsyncIO. The iovec array is copied, the buffers it points to must stay
+ * valid until the callback. A short transfer only happens at the end of the file or on error, callers see it through
+ * the result.
+ *
+ * The destructor waits for every submitted request to complete.
+ */
+class AsyncIO {
+ public:
+  /**
+   * @return an io_uring engine if the kernel supports it, a thread pool engine otherwise
+   */
+  static std::unique_ptr<AsyncIO> Create(int fd, size_t queue_depth = ASYNC_IO_QUEUE_DEPTH);
+
+  virtual ~AsyncIO() = default;
+
+  /**
+   * Queue a read (write = false) into, or a write from, the buffers of iov at the given file offset. Blocks while
+   * queue_depth requests are already in flight.
+   */
+  virtual void Submit(bool write, const iovec *iov, int iovcnt, off_t offset, IOCallback callback) = 0;
+
+  /** @return name of the engine, for logs */
+  virtual const char *GetName() const = 0;
+};
+
+/**
+ * AsyncIO on an io_uring instance, driven with raw system calls. Submitters fill the submission ring under a latch and
+ * enter the kernel once per request; a completion thread sleeps in io_uring_enter and runs the callbacks. Like the
+ * thread pool, it transfers until done: the completion thread submits the rest of a request that completed partially
+ * or was interrupted, and runs the callback only at the end of the file or on error.
+ */
+class UringAsyncIO : public AsyncIO {
+ public:
+  /**
+   * @return nullptr if the kernel does not provide io_uring, or refuses to set it up (e.g. seccomp)
+   */
+  static std::unique_ptr<UringAsyncIO> Create(int fd, size_t queue_depth);
+
+  ~UringAsyncIO() override;
+
+  void Submit(bool write, const iovec *iov, int iovcnt, off_t offset, IOCallback callback) override;
+
+  const char *GetName() const override { return "io_uring"; }
+
+ private:
+  struct Request {
+    uint8_t opcode_;
+    std::vector<iovec> iov_;
+    off_t offset_;
+    IOCallback callback_;
+    size_t first_{0};         // first iovec not completely transferred yet
+    ssize_t transferred_{0};  // bytes transferred so far
+  };
+
+  UringAsyncIO() = default;
+
+  /** Fill the next submission queue entry for the rest of request and hand it to the kernel. Caller must hold latch_. */
+  void PushEntry(uint8_t opcode, Request *request);
+
+  /**
+   * Submit the rest of a request after a completion with result res.
+   * @return false if the request is done: transferred completely, at the end of the file, or failed
+   */
+  bool Resubmit(Request *request, int res);
+
+  /** Body of the completion thread. */
+  void CompletionLoop();
+
+  int fd_{-1};
+  int ring_fd_{-1};
+  void *sq_ring_{nullptr};
+  size_t sq_ring_size_{0};
+  void *cq_ring_{nullptr};
+  size_t cq_ring_size_{0};
+  void *sqes_{nullptr};
+  size_t sqes_size_{0};
+  unsigned *sq_tail_{nullptr};
+  unsigned *sq_mask_{nullptr};
+  unsigned *sq_array_{nullptr};
+  unsigned *cq_head_{nullptr};
+  unsigned *cq_tail_{nullptr};
+  unsigned *cq_mask_{nullptr};
+  void *cqes_{nullptr};
+  size_t queue_depth_{0};
+
+  std::mutex latch_;                       // protects the submission ring and in_flight_
+  std::condition_variable completed_;      // signaled whenever a request completes
+  size_t in_flight_{0};                    // submitted requests whose callback has not run yet
+  std::thread completion_thread_;
+};
+
+/**
+ * AsyncIO fallback for kernels without io_uring: a few worker threads doing blocking preadv/pwritev.
+ */
+class ThreadPoolAsyncIO : public AsyncIO {
+ public:
+  explicit ThreadPoolAsyncIO(int fd, size_t queue_depth = ASYNC_IO_QUEUE_DEPTH,
+                             size_t num_threads = ASYNC_IO_THREADS);
+
+  ~ThreadPoolAsyncIO() override;
+
+  void Submit(bool write, const iovec *iov, int iovcnt, off_t offset, IOCallback callback) override;
+
+  const char *GetName() const override { return "thread pool"; }
+
+ private:
+  struct Request {
+    bool write_;
+    std::vector<iovec> iov_;
+    off_t offset_;
+    IOCallback callback_;
+  };
+
+  /** Body of the worker threads. */
+  void WorkerLoop();
+
+  int fd_;
+  size_t queue_depth_;
+  std::mutex latch_;                   // protects queue_, in_flight_ and stopped_
+  std::condition_variable wakeup_;     // signaled when a request is queued or the pool stops
+  std::condition_variable completed_;  // signaled whenever a request completes
+  std::deque<Request> queue_;
+  size_t in_flight_{0};
+  bool stopped_{false};
+  std::vector<std::thread> workers_;
+};
+
+#endif  // MINISQL_ASYNC_IO_H
@@ -2,15 +2,28 @@
 #define DISK_MGR_H
 
 #include <atomic>
-#include <fstream>
+#include <future>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include "common/config.h"
 #include "common/macros.h"
 #include "page/bitmap_page.h"
 #include "page/disk_file_meta_page.h"
+#include "storage/async_io.h"
+
+/**
+ * Pages reserved by one table heap or index so that its pages end up next to each other on disk, see
+ * DiskManager::AllocatePage.
+ */
+struct PageRun {
+  page_id_t next_{INVALID_PAGE_ID};  // next page of the run to hand out
+  page_id_t end_{INVALID_PAGE_ID};   // one past the last page of the run
+  bool compress_{false};             // pages allocated through the run are stored compressed
+};
 
 /**
  * DiskManager takes care of the allocation and de allocation of pages within a database. It performs the reading and
@@ -19,15 +32,54 @@
  * Disk page storage format: (Free Page BitMap Size = PAGE_SIZE * 8, we note it as N)
  * | Meta Page | Free Page BitMap 1 | Page 1 | Page 2 | ....
  *      | Page N | Free Page BitMap 2 | Page N+1 | ... | Page 2N | ... |
+ *
+ * PAGE_SIZE is chosen when the code is built. The meta page records the page size a file was created with, and
+ * opening a file created with another page size throws std::runtime_error. Files from before the page size was
+ * recorded are 4 KB files; their meta page is upgraded in memory and written back in the new layout on Sync.
+ *
+ * The file is accessed through a file descriptor with positional pread/pwrite, so page reads and writes need no lock
+ * and run concurrently; only the allocation bitmaps and the meta page are protected by db_io_latch_. Writes reach the
+ * operating system right away but are only durable after Sync (Close syncs as well). With direct_io the file is opened
+ * with O_DIRECT, bypassing the page cache, and I/O from buffers that are not PAGE_SIZE aligned goes through an aligned
+ * bounce buffer; if the file system does not support O_DIRECT the file is opened normally.
+ *
+ * ReadPageAsync/WritePageAsync, ReadPages and WritePages go through an AsyncIO engine (io_uring, or a thread pool on
+ * kernels without it) created on first use, so that up to ASYNC_IO_QUEUE_DEPTH requests are in flight at once.
+ *
+ * The allocation bitmaps are cached in memory once read, and only written back by Sync and Close if they changed, so
+ * allocating and freeing pages costs no I/O. A summary bit per extent tells whether the extent has a free page left.
+ *
+ * A table heap or index allocates through its own PageRun: it reserves PAGE_RUN_SIZE free pages in a row, aligned to a
+ * word of the bitmap, and takes its pages from there until they are used up. Allocations without a run skip the
+ * reserved pages as long as there are other free pages. Reservations only live in memory. As pages are allocated the
+ * file is preallocated FILE_PREALLOCATE_PAGES at a time, where the file system supports fallocate.
+ *
+ * With read_only the file is opened read-only and mapped into memory as a whole, and GetMappedPage points straight
+ * into the mapping. The mapping is read-only as well. Nothing is ever written: writes are dropped with an error,
+ * AllocatePage returns INVALID_PAGE_ID and Sync does nothing.
+ *
+ * Pages allocated through a PageRun with compress_ set, or marked with SetPageCompressed, are compressed with
+ * PageCompressor when written. A compressed page keeps its slot in the file but only the first blocks of it, a multiple
+ * of COMPRESSED_BLOCK_SIZE, are written; where the file system supports it the rest of the slot is punched out of the
+ * file, so it takes no disk space and reads without touching the disk. A page that does not shrink by at least one
+ * block is written as is.
+ * Compressed pages start with a CompressedPageHeader, which is how reads recognize and decompress them; the extents
+ * keep a bitmap of the pages stored compressed in memory, learned again from the pages as they are read.
  */
 class DiskManager {
  public:
-  explicit DiskManager(const std::string &db_file);
+  /**
+   * @param read_only open an existing file read-only and map it into memory, direct_io is ignored then
+   */
+  explicit DiskManager(const std::string &db_file, bool direct_io = false, bool read_only = false);
 
   ~DiskManager() {
     if (!closed) {
       Close();
     }
+    for (size_t i = 0; i < MAX_EXTENTS; i++) {
+      delete[] compressed_pages_[i].load();
+    }
   }
 
   /**
@@ -42,11 +94,46 @@ class DiskManager {
    */
   void WritePage(page_id_t logical_page_id, const char *page_data);
 
+  /**
+   * Start reading a page. page_data must stay valid until the returned future is ready.
+   */
+  std::future<void> ReadPageAsync(page_id_t logical_page_id, char *page_data);
+
+  /**
+   * Start writing a page. page_data must stay valid and unchanged until the returned future is ready. If the page
+   * cannot be written completely, getting the future throws std::runtime_error.
+   */
+  std::future<void> WritePageAsync(page_id_t logical_page_id, const char *page_data);
+
+  /**
+   * Read several pages, page_data[i] receiving logical_page_ids[i]. Pages that are adjacent on disk are read with one
+   * vectored request, and all the requests are in flight at the same time.
+   */
+  void ReadPages(const std::vector<page_id_t> &logical_page_ids, const std::vector<char *> &page_data);
+
+  /**
+   * Write several pages, page_data[i] going to logical_page_ids[i]. Pages that are adjacent on disk are written with
+   * one vectored request, and all the requests are in flight at the same time.
+   * @return false if a page could not be written completely
+   */
+  bool WritePages(const std::vector<page_id_t> &logical_page_ids, const std::vector<const char *> &page_data);
+
+  /**
+   * Write back the meta page and the changed allocation bitmaps, and make every write that returned so far durable.
+   */
+  void Sync();
+
   /**
    * Get next free page from disk
+   * @param run if set, the page is taken from this run, which reserves new pages when it is used up
    * @return logical page id of allocated page
    */
-  page_id_t AllocatePage();
+  page_id_t AllocatePage(PageRun *run = nullptr);
+
+  /**
+   * Give back the pages of the run that were not handed out yet, e.g. when its table is dropped.
+   */
+  void ReleasePageRun(PageRun *run);
 
   /**
    * Free this page and reset bit map
@@ -69,23 +156,186 @@ class DiskManager {
    */
   char *GetMetaData() { return meta_data_; }
 
+  /** @return true if the file is opened with O_DIRECT */
+  inline bool IsDirectIO() const { return direct_io_; }
+
+  /** @return true if the file is opened read-only and mapped into memory */
+  inline bool IsReadOnly() const { return read_only_; }
+
+  /**
+   * @return the page inside the read-only mapping of the file, nullptr if the disk manager is not read-only or the
+   * page lies beyond the end of the file. The memory must not be written to.
+   */
+  char *GetMappedPage(page_id_t logical_page_id);
+
+  /**
+   * Decompress a page as it is stored on disk, e.g. in the read-only mapping. page_data may be the same as stored.
+   * @return false if the page is not stored compressed, page_data is left untouched then
+   */
+  bool DecompressPage(page_id_t logical_page_id, const char *stored, char *page_data);
+
+  /**
+   * Store the page compressed from its next write on, or uncompressed again.
+   */
+  void SetPageCompressed(page_id_t logical_page_id, bool compressed);
+
+  /** @return true if the page is stored compressed, or will be on its next write */
+  bool IsPageCompressed(page_id_t logical_page_id);
+
+  /** @return the number of logical pages the file has room for, i.e. the upper bound of the mapped page ids */
+  size_t GetMappedPageCount() const;
+
   static constexpr size_t BITMAP_SIZE = BitmapPage<PAGE_SIZE>::GetMaxSupportedSize();
 
+  /** Number of extents the meta page can describe. */
+  static constexpr size_t MAX_EXTENTS = DiskFileMetaPage::MAX_EXTENTS;
+
+  /** Number of pages a PageRun reserves at a time, one word of the bitmap. */
+  static constexpr size_t PAGE_RUN_SIZE = 64;
+
+  static_assert(BITMAP_SIZE % PAGE_RUN_SIZE == 0, "A page run must not cross extents.");
+
  private:
+  /** Open or create the file for reading and writing. */
+  void OpenFile();
+
+  /** Open the existing file read-only and map it into memory. */
+  void OpenMapping();
+
+  /** Check the page size recorded in the meta page, stamping a new file and upgrading a legacy one. */
+  void CheckMetaPage();
+
+  /** Start of a compressed page on disk, followed by the PageCompressor data. */
+  struct CompressedPageHeader {
+    uint32_t magic_;
+    page_id_t page_id_;  // logical page id, so that a page that is not compressed is not mistaken for one
+    uint32_t size_;      // size of the compressed data
+    uint32_t checksum_;  // checksum of the uncompressed page
+  };
+
+  static constexpr uint32_t COMPRESSED_PAGE_MAGIC = 0x4D53435A;  // "MSCZ"
+
+  /**
+   * Write the page compressed.
+   * @return false if it does not compress well enough or could not be written, the caller writes it as is then
+   */
+  bool WriteCompressedPage(page_id_t logical_page_id, const char *page_data);
+
+  /**
+   * @return the bits of the extent's pages stored compressed, nullptr if there are none and create is false
+   */
+  std::atomic<uint64_t> *GetCompressedBits(uint32_t extent_id, bool create);
+
+  /** In-memory copy of an extent's bitmap page. */
+  struct CachedBitmap {
+    alignas(PAGE_SIZE) char data_[PAGE_SIZE];
+    bool dirty_{false};
+    // one bit per PAGE_RUN_SIZE pages, set if a PageRun reserved them
+    uint64_t reserved_[(BITMAP_SIZE / PAGE_RUN_SIZE + 63) / 64]{};
+
+    inline BitmapPage<PAGE_SIZE> *GetPage() { return reinterpret_cast<BitmapPage<PAGE_SIZE> *>(data_); }
+
+    inline bool IsReserved(uint32_t page_offset) const {
+      uint32_t run_index = page_offset / PAGE_RUN_SIZE;
+      return (reserved_[run_index / 64] >> (run_index % 64)) & 1;
+    }
+
+    inline void SetReserved(uint32_t page_offset, bool reserved) {
+      uint32_t run_index = page_offset / PAGE_RUN_SIZE;
+      if (reserved) {
+        reserved_[run_index / 64] |= 1ULL << (run_index % 64);
+      } else {
+        reserved_[run_index / 64] &= ~(1ULL << (run_index % 64));
+      }
+    }
+  };
+
+  /**
+   * @return the bitmap of the extent, read from disk on first use. Caller must hold db_io_latch_.
+   */
+  CachedBitmap *GetBitmap(uint32_t extent_id);
+
+  /**
+   * Allocate page_offset of the extent and update the meta page. Caller must hold db_io_latch_.
+   * @return the logical page id, INVALID_PAGE_ID if the page was not free
+   */
+  page_id_t TakePage(uint32_t extent_id, uint32_t page_offset);
+
+  /**
+   * Allocate the next free page of the run, reserving a new run when it is used up. Caller must hold db_io_latch_.
+   * @return INVALID_PAGE_ID if no PAGE_RUN_SIZE free pages are left to reserve
+   */
+  page_id_t AllocateFromRun(PageRun *run);
+
+  /**
+   * Allocate the lowest free page that no run reserved, or the lowest free page if all of them are reserved. Caller
+   * must hold db_io_latch_.
+   */
+  page_id_t AllocateUnreserved();
+
+  /**
+   * Reserve PAGE_RUN_SIZE free pages for the run, preferably right after its old pages. Caller must hold
+   * db_io_latch_.
+   * @return false if there are no such pages
+   */
+  bool ReservePageRun(PageRun *run);
+
   /**
-   * Helper function to get disk file size
+   * Make sure the file has disk space allocated up to logical_page_id. Caller must hold db_io_latch_.
    */
-  int GetFileSize(const std::string &file_name);
+  void Preallocate(page_id_t logical_page_id);
+
+  /** Write back the bitmaps changed since the last call. Caller must hold db_io_latch_. */
+  void FlushBitmaps();
+
+  /** Mark whether an extent still has free pages in the summary. */
+  inline void SetExtentFull(uint32_t extent_id, bool full) {
+    if (full) {
+      non_full_extents_[extent_id / 64] &= ~(1ULL << (extent_id % 64));
+    } else {
+      non_full_extents_[extent_id / 64] |= 1ULL << (extent_id % 64);
+    }
+  }
 
   /**
    * Read physical page from disk
    */
-  void ReadPhysicalPage(page_id_t physical_page_id, char *page_data);
+  inline void ReadPhysicalPage(page_id_t physical_page_id, char *page_data) {
+    ReadPhysicalPages(physical_page_id, &page_data, 1);
+  }
 
   /**
    * Write data to physical page in disk
    */
-  void WritePhysicalPage(page_id_t physical_page_id, const char *page_data);
+  inline bool WritePhysicalPage(page_id_t physical_page_id, const char *page_data) {
+    return WritePhysicalPages(physical_page_id, &page_data, 1);
+  }
+
+  /**
+   * Read count physical pages starting at first_physical_page_id into pages_data. The part beyond the end of the file
+   * reads as zeros.
+   */
+  void ReadPhysicalPages(page_id_t first_physical_page_id, char *const *pages_data, size_t count);
+
+  /**
+   * Write count physical pages starting at first_physical_page_id from pages_data.
+   * @return false if they could not be written completely
+   */
+  bool WritePhysicalPages(page_id_t first_physical_page_id, const char *const *pages_data, size_t count);
+
+  /**
+   * Start reading or writing count physical pages starting at first_physical_page_id. Reads past the end of the file
+   * fill the pages with zeros. done runs once the pages are transferred, with false if the transfer failed or a write
+   * was short.
+   */
+  void SubmitPhysicalPages(bool write, page_id_t first_physical_page_id, char *const *pages_data, size_t count,
+                           std::function<void(bool ok)> done);
+
+  /** @return the asynchronous I/O engine, created on first use */
+  AsyncIO *GetAsyncIO();
+
+  /** Raise the cached file size to at least end. */
+  void GrowFileSize(size_t end);
 
   /**
    * Map logical page id to physical page id
@@ -93,13 +343,34 @@ class DiskManager {
   page_id_t MapPageId(page_id_t logical_page_id);
 
  private:
-  // stream to write db file
-  std::fstream db_io_;
+  // descriptor of the db file
+  int fd_{-1};
   std::string file_name_;
-  // with multiple buffer pool instances, need to protect file access
+  bool direct_io_;
+  bool read_only_;
+  // mapping of the whole file in read-only mode
+  char *mapping_{nullptr};
+  size_t mapping_size_{0};
+  // size of the db file, kept in memory so that reads past the end need no system call
+  std::atomic<size_t> file_size_{0};
+  std::unique_ptr<AsyncIO> async_io_;
+  std::once_flag async_io_created_;
+  // protects the allocation bitmaps and the meta page
   std::recursive_mutex db_io_latch_;
+  // cached bitmap pages indexed by extent, nullptr until first used
+  std::vector<std::unique_ptr<CachedBitmap>> bitmaps_;
+  // one bit per extent, set if the extent has a free page
+  std::vector<uint64_t> non_full_extents_;
+  // bytes at the start of the file that have disk space allocated
+  size_t preallocated_end_{0};
+  // false once fallocate turned out to be unsupported
+  bool preallocate_{true};
+  // per extent one bit per page, set if the page is stored compressed; nullptr until a page of the extent is
+  std::unique_ptr<std::atomic<std::atomic<uint64_t> *>[]> compressed_pages_;
+  // false once punching holes turned out to be unsupported
+  std::atomic<bool> punch_holes_{true};
   bool closed{false};
-  char meta_data_[PAGE_SIZE];
+  alignas(PAGE_SIZE) char meta_data_[PAGE_SIZE];
 };
 
 #endif
\ No newline at end of file
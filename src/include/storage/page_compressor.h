@@ -0,0 +1,35 @@
+#ifndef MINISQL_PAGE_COMPRESSOR_H
+#define MINISQL_PAGE_COMPRESSOR_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * PageCompressor is a small LZ77 codec in the style of LZ4, used by DiskManager to store pages compressed.
+ *
+ * The compressed data is a sequence of tokens. The high nibble of a token is the number of literals that follow it,
+ * the low nibble the length of the match after them minus MIN_MATCH; a nibble of 15 is continued by bytes that are
+ * added to it until one is not 255. The literals are followed by the 2 byte little endian offset of the match. The
+ * last token has no match, the data ends right after its literals.
+ */
+class PageCompressor {
+ public:
+  /**
+   * Compress size bytes of src into dst.
+   * @return the size of the compressed data, 0 if it does not fit into capacity bytes
+   */
+  static size_t Compress(const char *src, size_t size, char *dst, size_t capacity);
+
+  /**
+   * Decompress size bytes of src into dst, which must come out at exactly dst_size bytes.
+   * @return false if src is not valid compressed data of that size
+   */
+  static bool Decompress(const char *src, size_t size, char *dst, size_t dst_size);
+
+  static constexpr size_t MIN_MATCH = 4;
+
+ private:
+  static constexpr int HASH_BITS = 12;
+};
+
+#endif  // MINISQL_PAGE_COMPRESSOR_H
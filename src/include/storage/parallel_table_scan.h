@@ -0,0 +1,84 @@
+#ifndef MINISQL_PARALLEL_TABLE_SCAN_H
+#define MINISQL_PARALLEL_TABLE_SCAN_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "buffer/buffer_access_strategy.h"
+#include "concurrency/txn.h"
+#include "record/row.h"
+#include "record/row_view.h"
+
+class TableHeap;
+
+/**
+ * ParallelTableScan scans a table heap with several worker threads. The pages of the table, as listed by its free space
+ * map, are split into morsels of PARALLEL_SCAN_MORSEL_PAGES consecutive pages of the chain; each worker takes the next
+ * morsel nobody took yet, scans it with a TableScanCursor, and keeps the rows the filter accepts. Next returns the rows
+ * morsel after morsel, i.e. in the same order as a scan by a single thread.
+ *
+ * Workers stay at most 2 morsels per worker ahead of the morsel Next returns rows from, so that the rows kept in memory
+ * are bounded. The pages of the table are listed when the scan starts; pages appended later are not scanned.
+ */
+class ParallelTableScan {
+ public:
+  /** Decides on a row in place, called by the worker threads concurrently. */
+  using Filter = std::function<bool(const RowView &row)>;
+
+  /**
+   * Start the workers.
+   * @param filter rows are kept if it returns true, all rows are kept if it is empty
+   * @param column_ids the columns of a kept row to return, in this order; all columns if empty
+   * @param num_threads number of workers, fewer if the table has fewer morsels
+   * @param strategy if set, the pages are read through this ring, shared by the workers
+   */
+  ParallelTableScan(TableHeap *table_heap, Txn *txn, Filter filter, std::vector<uint32_t> column_ids,
+                    size_t num_threads, std::shared_ptr<BufferAccessStrategy> strategy = nullptr);
+
+  /** Stop the workers, also if the rows were not all returned. */
+  ~ParallelTableScan();
+
+  ParallelTableScan(const ParallelTableScan &) = delete;
+
+  ParallelTableScan &operator=(const ParallelTableScan &) = delete;
+
+  /**
+   * Move the next row kept by the workers into row, waiting for the worker that scans it if needed.
+   * @return false if there are no more rows
+   */
+  bool Next(Row *row);
+
+ private:
+  struct Morsel {
+    page_id_t first_page_id_;
+    page_id_t end_page_id_;   // first page of the next morsel, INVALID_PAGE_ID for the last one
+    std::deque<Row> rows_;    // rows kept, a deque so that rows never move once deserialized
+    bool done_{false};
+  };
+
+  /** Body of the worker threads. */
+  void Work();
+
+ private:
+  TableHeap *table_heap_;
+  Txn *txn_;
+  Filter filter_;
+  std::vector<uint32_t> column_ids_;
+  std::shared_ptr<BufferAccessStrategy> strategy_;
+  std::vector<Morsel> morsels_;
+  size_t window_;                      // how many morsels workers may be ahead of current_morsel_
+  std::mutex latch_;                   // protects the fields below, and done_ of the morsels
+  std::condition_variable progress_;   // signaled when a morsel is done or current_morsel_ moves on
+  size_t next_morsel_{0};              // next morsel a worker takes
+  size_t current_morsel_{0};           // morsel Next returns rows from
+  bool stopped_{false};
+  size_t next_row_{0};                 // next row of current_morsel_, only touched by Next
+  std::vector<std::thread> workers_;
+};
+
+#endif  // MINISQL_PARALLEL_TABLE_SCAN_H
@@ -1,37 +1,74 @@
 #ifndef MINISQL_TABLE_HEAP_H
 #define MINISQL_TABLE_HEAP_H
 
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/lock_manager.h"
+#include "page/free_space_map_page.h"
 #include "page/header_page.h"
+#include "page/overflow_page.h"
 #include "page/table_page.h"
 #include "recovery/log_manager.h"
 #include "storage/table_iterator.h"
 
+/**
+ * TableHeap stores the rows of a table in a chain of TablePages, in the row or the PAX layout chosen when the table is
+ * created. The pages record their layout, and a new page takes the layout of the last one.
+ *
+ * A free space map, a chain of FreeSpaceMapPages, lists the pages of the chain with the class of their free space, so
+ * that an insert goes straight to a page with room for the row, or to the last page, instead of trying the pages one by
+ * one. The first page has no previous page; its prev page id holds the first page of the map instead. A heap from
+ * before the map gets one built from its page chain the first time it is modified. The map is kept up to date by
+ * inserts, updates and deletes, and cached in memory (which map page lists which heap page, and the largest class on
+ * each map page) once read.
+ *
+ * A row larger than ROW_INLINE_SIZE bytes has its longest char values moved to chains of OverflowPages, longest first,
+ * until it is not; the row keeps the length and the first page of each of them. GetTuple and TableIterator return rows
+ * with the values read back, while a TableScanCursor only reads them for the columns asked for. The overflow pages of a
+ * row are deleted together with the row by ApplyDelete, or by UpdateTuple when the values are replaced.
+ */
 class TableHeap {
   friend class TableIterator;
 
+  friend class TableScanCursor;
+
  public:
   static TableHeap *Create(BufferPoolManager *buffer_pool_manager, Schema *schema, Txn *txn, LogManager *log_manager,
-                           LockManager *lock_manager) {
-    return new TableHeap(buffer_pool_manager, schema, txn, log_manager, lock_manager);
+                           LockManager *lock_manager, TableFormat format = TableFormat::kRowFormat,
+                           bool compressed = false) {
+    return new TableHeap(buffer_pool_manager, schema, txn, log_manager, lock_manager, format, compressed);
   }
 
   static TableHeap *Create(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id, Schema *schema,
-                           LogManager *log_manager, LockManager *lock_manager) {
-    return new TableHeap(buffer_pool_manager, first_page_id, schema, log_manager, lock_manager);
+                           LogManager *log_manager, LockManager *lock_manager, bool compressed = false) {
+    return new TableHeap(buffer_pool_manager, first_page_id, schema, log_manager, lock_manager, compressed);
   }
 
-  ~TableHeap() {}
+  // 表没有被删掉也要把预留但没用到的页还回去，不然要到重启才能分配给别人
+  ~TableHeap() { buffer_pool_manager_->ReleasePageRun(&page_run_); }
 
   /**
-   * Insert a tuple into the table. If the tuple is too large (>= page_size), return false.
+   * Insert a tuple into the table. If the tuple is too large even with its long char values in overflow pages, return
+   * false.
    * @param[in/out] row Tuple Row to insert, the rid of the inserted tuple is wrapped in object row
    * @param[in] txn The recovery performing the insert
    * @return true iff the insert is successful
    */
   bool InsertTuple(Row &row, Txn *txn);
 
+  /**
+   * Insert many rows at the end of the table, filling the last page and then new pages one after the other. Each page
+   * is pinned and latched once for all the rows it gets, and each row is sized once. Free space on earlier pages is
+   * left to InsertTuple.
+   * @param[in/out] rows Rows to insert, the rid of each inserted row is wrapped in it
+   * @return false if a row is too large or its overflow pages cannot be allocated, in which case nothing is inserted,
+   * or if the heap cannot grow, in which case the rows before the first one without a rid are inserted
+   */
+  bool InsertTuples(std::vector<Row> &rows, Txn *txn);
+
   /**
    * Mark the tuple as deleted. The actual delete will occur when ApplyDelete is called.
    * @param[in] rid Resource id of the tuple of delete
@@ -71,8 +108,17 @@ class TableHeap {
    */
   bool GetTuple(Row *row, Txn *txn);
 
+  /**
+   * @return a field owning a copy of the char value in the overflow pages field refers to, see Field::IsOverflow
+   */
+  Field ReadOverflow(const Field &field);
+
+  /** Replace the fields of row that refer to overflow pages by fields with their values. */
+  void ReadOverflow(Row *row);
+
 	// 释放掉堆表
   void FreeTableHeap() {
+    DeleteFreeSpaceMap();
 		// first_page_id是成员变量
     auto next_page_id = first_page_id_;
 		// 需要将所有page都释放掉，所以使用循环
@@ -83,10 +129,13 @@ class TableHeap {
       assert(page != nullptr);
 			// tablepage具有获得下一个pageid的函数
       next_page_id = page->GetNextPageId();
+			// 行放在overflow page里的值也要删掉
+      FreePageOverflow(page);
 			// 释放掉意味着我们不需要这页page，所以将之取消固定，并且delete掉
       buffer_pool_manager_->UnpinPage(old_page_id, false);
       buffer_pool_manager_->DeletePage(old_page_id);
     }
+    buffer_pool_manager_->ReleasePageRun(&page_run_);
   }
 
   /**
@@ -95,9 +144,10 @@ class TableHeap {
   void DeleteTable(page_id_t page_id = INVALID_PAGE_ID);
 
   /**
+   * @param strategy if set, the iterator reads the pages through this ring, see BufferAccessStrategy
    * @return the begin iterator of this table
    */
-  TableIterator Begin(Txn *txn);
+  TableIterator Begin(Txn *txn, std::shared_ptr<BufferAccessStrategy> strategy = nullptr);
 
   /**
    * @return the end iterator of this table
@@ -109,30 +159,129 @@ class TableHeap {
    */
   inline page_id_t GetFirstPageId() const { return first_page_id_; }
 
+  /**
+   * List the pages of this table in the order of the page chain, as the free space map has them, so that the table
+   * can be split into page ranges without following the chain, see ParallelTableScan. Returns false, with page_ids
+   * left empty, if the free space map could not be loaded.
+   */
+  bool GetPageIds(std::vector<page_id_t> *page_ids);
+
+  /**
+   * @return true if the pages of this table are stored compressed, see DiskManager. The setting is chosen when the
+   * table is created and kept in its TableMetadata, which passes it back in when the heap is opened again.
+   */
+  inline bool IsCompressed() const { return page_run_.compress_; }
+
+  /** @return the layout of the pages of this table */
+  TableFormat GetFormat();
+
  private:
+  /**
+   * Let the buffer pool read the TABLE_READ_AHEAD_PAGES pages starting at page_id along the page chain in the
+   * background, so that a scan finds them resident when it gets there.
+   */
+  void ReadAhead(page_id_t page_id, std::shared_ptr<BufferAccessStrategy> strategy);
+
+  /**
+   * Read the free space map into memory, building it from the page chain if the heap has none yet. Does nothing if it
+   * is loaded already. Returns false if a page could not be fetched; the map is then left unloaded and the next call
+   * starts over. Caller must hold fsm_latch_.
+   */
+  bool LoadFreeSpaceMap();
+
+  /** Forget the cached free space map. Caller must hold fsm_latch_. */
+  void ResetFreeSpaceMapCache();
+
+  /**
+   * @return a page the free space map says has room for row, INVALID_PAGE_ID if there is none. row_size is its
+   * serialized size; PAX pages count the room a row takes in them differently, see PaxPage::GetRowSize.
+   */
+  page_id_t FindPageWithSpace(const Row &row, uint32_t row_size);
+
+  /**
+   * Same as InsertTuple, for a row of row_size bytes that is not made smaller by overflow pages any more.
+   */
+  bool InsertStoredTuple(Row &row, uint32_t row_size, Txn *txn);
+
+  /** Same as InsertTuples, for rows of the given sizes that are not made smaller by overflow pages any more. */
+  bool InsertStoredTuples(std::vector<Row> &rows, const std::vector<uint32_t> &sizes, Txn *txn);
+
+  /**
+   * Make stored_row a copy of row with its longest char values moved to overflow pages, so that it takes at most
+   * ROW_INLINE_SIZE bytes if moving can achieve that.
+   * @return false if overflow pages cannot be allocated, in which case none are left behind
+   */
+  bool MoveToOverflow(const Row &row, Row *stored_row);
+
+  /** @return the first of new overflow pages holding data, INVALID_PAGE_ID if they cannot be allocated */
+  page_id_t WriteOverflow(const char *data, uint32_t len);
+
+  /** Delete the chain of overflow pages starting at page_id. */
+  void FreeOverflow(page_id_t page_id);
+
+  /** Delete the overflow pages the fields of row refer to. */
+  void FreeOverflow(const Row &row);
+
+  /** Delete the overflow pages of the tuple rid on page, also if it is marked as deleted. Caller latches the page. */
+  void FreeTupleOverflow(TablePage *page, const RowId &rid);
+
+  /** Delete the overflow pages of the rows on page. */
+  void FreePageOverflow(TablePage *page);
+
+  /**
+   * Insert the row into the last page, or into a new page appended to the chain if it does not fit there.
+   */
+  bool InsertAtTail(Row &row, Txn *txn);
+
+  /**
+   * Record the room left on a page after a change in the free space map.
+   */
+  void UpdateFreeSpace(page_id_t page_id, uint32_t free_space);
+
+  /** Same as UpdateFreeSpace, caller must hold fsm_latch_ and have loaded the map. */
+  void RecordFreeSpace(page_id_t page_id, uint32_t free_space);
+
+  /**
+   * List a page appended to the chain in the free space map, allocating a new map page if the last one is full.
+   * Returns false if no map page could be had, in which case the page must not be linked into the chain. Caller must
+   * hold fsm_latch_.
+   */
+  bool AppendToFreeSpaceMap(page_id_t page_id, uint32_t free_space);
+
+  /** Delete the pages of the free space map. */
+  void DeleteFreeSpaceMap();
+
+  /** Same as DeleteFreeSpaceMap, caller must hold fsm_latch_. */
+  void ClearFreeSpaceMap();
+
   /**
    * create table heap and initialize first page
    */
   explicit TableHeap(BufferPoolManager *buffer_pool_manager, Schema *schema, Txn *txn, LogManager *log_manager,
-                     LockManager *lock_manager)
+                     LockManager *lock_manager, TableFormat format, bool compressed)
       : buffer_pool_manager_(buffer_pool_manager),
         schema_(schema),
         log_manager_(log_manager),
         lock_manager_(lock_manager) {
+    page_run_.compress_ = compressed;
     // 这个构造函数需要我们自己实现
 		// 需要我们对first_page_id进行初始化
-		auto page = reinterpret_cast<TablePage*>(this->buffer_pool_manager_->NewPage(first_page_id_));
-		page->Init(first_page_id_, INVALID_PAGE_ID, log_manager, txn);
+		auto page = reinterpret_cast<TablePage*>(this->buffer_pool_manager_->NewPage(first_page_id_, &page_run_));
+		page->Init(first_page_id_, INVALID_PAGE_ID, format, schema, log_manager, txn);
 		this->buffer_pool_manager_->UnpinPage(first_page_id_, true);
+    std::scoped_lock<std::mutex> lock(fsm_latch_);
+    LoadFreeSpaceMap();
   };
 
   explicit TableHeap(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id, Schema *schema,
-                     LogManager *log_manager, LockManager *lock_manager)
+                     LogManager *log_manager, LockManager *lock_manager, bool compressed)
       : buffer_pool_manager_(buffer_pool_manager),
         first_page_id_(first_page_id),
         schema_(schema),
         log_manager_(log_manager),
-        lock_manager_(lock_manager) {}
+        lock_manager_(lock_manager) {
+    page_run_.compress_ = compressed;
+  }
 
  private:
   BufferPoolManager *buffer_pool_manager_;
@@ -140,6 +289,15 @@ class TableHeap {
   Schema *schema_;
   LogManager *log_manager_;
   LockManager *lock_manager_;
+  PageRun page_run_;  // pages reserved for this heap, so that its page chain is contiguous on disk
+  // protects the free space map and its cached state below
+  std::mutex fsm_latch_;
+  bool fsm_loaded_{false};
+  std::vector<page_id_t> fsm_pages_;                     // pages of the map in chain order
+  std::vector<uint8_t> fsm_max_class_;                   // largest class listed on each page of the map
+  std::unordered_map<page_id_t, uint32_t> fsm_entries_;  // position of each heap page in the map
+  page_id_t last_page_id_{INVALID_PAGE_ID};              // last page of the chain
+  TableFormat format_{TableFormat::kRowFormat};          // layout of the pages, read with the map
 };
 
 #endif  // MINISQL_TABLE_HEAP_H
@@ -1,6 +1,9 @@
 #ifndef MINISQL_TABLE_ITERATOR_H
 #define MINISQL_TABLE_ITERATOR_H
 
+#include <memory>
+
+#include "buffer/buffer_access_strategy.h"
 #include "common/rowid.h"
 #include "concurrency/txn.h"
 #include "record/row.h"
@@ -10,7 +13,8 @@ class TableHeap;
 class TableIterator {
 public:
  // you may define your own constructor based on your member variables
- explicit TableIterator(TableHeap *table_heap, RowId rid, Txn *txn);
+ explicit TableIterator(TableHeap *table_heap, RowId rid, Txn *txn,
+                        std::shared_ptr<BufferAccessStrategy> strategy = nullptr);
 
  explicit TableIterator(const TableIterator &other);
 
@@ -35,6 +39,10 @@ private:
 	TableHeap *table_heap;
 	Row *row;
 	Txn *txn;
+	// 再进入这么多个新的page之后，重新向后预读
+	size_t read_ahead_countdown;
+	// 非空时通过这个ring读取page，大表扫描不会把别人的热点页挤出buffer
+	std::shared_ptr<BufferAccessStrategy> strategy;
 };
 
 #endif  // MINISQL_TABLE_ITERATOR_H
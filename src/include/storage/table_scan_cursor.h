@@ -0,0 +1,78 @@
+#ifndef MINISQL_TABLE_SCAN_CURSOR_H
+#define MINISQL_TABLE_SCAN_CURSOR_H
+
+#include <memory>
+
+#include "buffer/buffer_access_strategy.h"
+#include "concurrency/txn.h"
+#include "page/table_page.h"
+#include "record/row_view.h"
+
+class TableHeap;
+
+/**
+ * TableScanCursor scans a table heap a page at a time. It keeps the page it is on pinned and returns the rows as
+ * RowViews pointing into the page, so that stepping through a page allocates and copies nothing, unlike TableIterator
+ * which deserializes every row into a new Row. The page stays read-latched from Next until the next call of Next,
+ * Release or the destructor, so that a writer cannot move or rewrite the row while the RowView is read; the RowView is
+ * valid that long. A caller that writes to the table between two calls of Next must Release first, or it waits for its
+ * own latch.
+ *
+ * Like TableIterator, the cursor reads the page chain ahead of itself, through strategy if it is set. A cursor may also
+ * scan only a range of the page chain, see ParallelTableScan.
+ */
+class TableScanCursor {
+ public:
+  explicit TableScanCursor(TableHeap *table_heap, Txn *txn, std::shared_ptr<BufferAccessStrategy> strategy = nullptr);
+
+  /**
+   * Scan the pages of the chain from first_page_id up to, but not including, end_page_id (INVALID_PAGE_ID for the end
+   * of the chain).
+   */
+  TableScanCursor(TableHeap *table_heap, Txn *txn, page_id_t first_page_id, page_id_t end_page_id,
+                  std::shared_ptr<BufferAccessStrategy> strategy = nullptr);
+
+  ~TableScanCursor();
+
+  TableScanCursor(const TableScanCursor &) = delete;
+
+  TableScanCursor &operator=(const TableScanCursor &) = delete;
+
+  /**
+   * Move to the next row, to the first row on the first call.
+   * @return false if there are no more rows
+   */
+  bool Next();
+
+  /** @return the row the cursor is on */
+  inline const RowView &GetRow() const { return row_; }
+
+  /**
+   * Give up the read latch on the current page before the next call of Next, e.g. once the row has been copied. The
+   * RowView must not be read afterwards.
+   */
+  void Release();
+
+ private:
+  /**
+   * Unpin the current page and pin page_id instead.
+   * @return false if page_id is INVALID_PAGE_ID or cannot be fetched, the cursor is at the end then
+   */
+  bool MoveToPage(page_id_t page_id);
+
+ private:
+  TableHeap *table_heap_;
+  Txn *txn_;
+  std::shared_ptr<BufferAccessStrategy> strategy_;
+  page_id_t first_page_id_;
+  page_id_t end_page_id_;
+  TablePage *page_{nullptr};  // pinned page the cursor is on
+  bool latched_{false};       // page_ is read-latched, from Next until Release
+  bool started_{false};
+  bool finished_{false};
+  // 再进入这么多个新的page之后，重新向后预读
+  size_t read_ahead_countdown_;
+  RowView row_;
+};
+
+#endif  // MINISQL_TABLE_SCAN_CURSOR_H
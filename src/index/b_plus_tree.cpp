@@ -21,7 +21,7 @@ BPlusTree::BPlusTree(index_id_t index_id, BufferPoolManager *buffer_pool_manager
         leaf_max_size_ = (PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / (processor_.GetKeySize()+ sizeof(RowId)) - 1;
     if(internal_max_size_ == 0)
         internal_max_size_ = (PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (processor_.GetKeySize() + sizeof(page_id_t)) - 1;
-    auto page = reinterpret_cast<IndexRootsPage *>(buffer_pool_manager->FetchPage(INDEX_ROOTS_PAGE_ID));
+    auto page = reinterpret_cast<IndexRootsPage *>(buffer_pool_manager->FetchPage(INDEX_ROOTS_PAGE_ID)->GetData());
     page_id_t root_id;
     if(page->GetRootId(index_id,&root_id)){
         root_page_id_ = root_id;
@@ -33,6 +33,7 @@ BPlusTree::BPlusTree(index_id_t index_id, BufferPoolManager *buffer_pool_manager
 }
 
 void BPlusTree::Destroy(page_id_t current_page_id) {
+    buffer_pool_manager_->ReleasePageRun(&page_run_);
 }
 
 /*
@@ -99,7 +100,7 @@ bool BPlusTree::Insert(GenericKey *key, const RowId &value, Txn *transaction) {
  */
 void BPlusTree::StartNewTree(GenericKey *key, const RowId &value) {
     page_id_t new_page_id = INVALID_PAGE_ID;
-    Page *root_page = buffer_pool_manager_->NewPage(new_page_id);
+    Page *root_page = buffer_pool_manager_->NewPage(new_page_id, &page_run_);
 
     if (nullptr == root_page) {
         throw std::runtime_error("out of memory");
@@ -156,7 +157,7 @@ bool BPlusTree::InsertIntoLeaf(GenericKey *key, const RowId &value, Txn *transac
  */
 BPlusTreeInternalPage *BPlusTree::Split(InternalPage *node, Txn *transaction) {
     page_id_t new_page_id;
-    Page *new_page = buffer_pool_manager_->NewPage(new_page_id);
+    Page *new_page = buffer_pool_manager_->NewPage(new_page_id, &page_run_);
     if (new_page == nullptr) {
         throw std::runtime_error("Out of memory");
         return nullptr;
@@ -172,7 +173,7 @@ BPlusTreeInternalPage *BPlusTree::Split(InternalPage *node, Txn *transaction) {
 
 BPlusTreeLeafPage *BPlusTree::Split(LeafPage *node, Txn *transaction) {
     page_id_t new_page_id,next_page_id;
-    Page *new_page = buffer_pool_manager_->NewPage(new_page_id);
+    Page *new_page = buffer_pool_manager_->NewPage(new_page_id, &page_run_);
     if (new_page == nullptr) {
         throw std::runtime_error("Out of memory");
         return nullptr;
@@ -201,7 +202,7 @@ void BPlusTree::InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlus
     if(old_node->IsRootPage()){
         page_id_t page_id;
         // 创建一个新的内部页面作为新的根节点
-        Page *page = buffer_pool_manager_->NewPage(page_id);
+        Page *page = buffer_pool_manager_->NewPage(page_id, &page_run_);
         auto *new_page = reinterpret_cast<InternalPage *>(page->GetData());
         new_page->Init(page_id,INVALID_PAGE_ID,processor_.GetKeySize(),leaf_max_size_);
         new_page->PopulateNewRoot(old_node->GetPageId(),key,new_node->GetPageId());
@@ -309,7 +310,7 @@ bool BPlusTree::CoalesceOrRedistribute(N *&node, Txn *transaction) {
         return false;
     }
 
-    auto *parent = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(node->GetParentPageId()));
+    auto *parent = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(node->GetParentPageId())->GetData());
     int size = parent->GetSize();
     int index = parent->ValueIndex(node->GetPageId());
 
@@ -320,7 +321,7 @@ bool BPlusTree::CoalesceOrRedistribute(N *&node, Txn *transaction) {
     bool should_delete_node = false;
 
     if (index == 0) {
-        N *sibling = reinterpret_cast<N *>(buffer_pool_manager_->FetchPage(parent->ValueAt(1)));
+        N *sibling = reinterpret_cast<N *>(buffer_pool_manager_->FetchPage(parent->ValueAt(1))->GetData());
         if ((sibling->GetSize() + node->GetSize()) <= node->GetMaxSize()) {
             should_delete_node = Coalesce(sibling, node, parent, index, transaction);
         } else {
@@ -328,7 +329,7 @@ bool BPlusTree::CoalesceOrRedistribute(N *&node, Txn *transaction) {
         }
         buffer_pool_manager_->UnpinPage(sibling->GetPageId(), true);
     } else if(index == (size-1)){
-        N *sibling = reinterpret_cast<N *>(buffer_pool_manager_->FetchPage(parent->ValueAt(index - 1)));
+        N *sibling = reinterpret_cast<N *>(buffer_pool_manager_->FetchPage(parent->ValueAt(index - 1))->GetData());
         if ((sibling->GetSize() + node->GetSize()) <= node->GetMaxSize()) {
             should_delete_node = Coalesce(node, sibling, parent, index - 1, transaction);
         } else {
@@ -336,8 +337,8 @@ bool BPlusTree::CoalesceOrRedistribute(N *&node, Txn *transaction) {
         }
         buffer_pool_manager_->UnpinPage(sibling->GetPageId(), true);
     } else{
-        N *sibling1 = reinterpret_cast<N *>(buffer_pool_manager_->FetchPage(parent->ValueAt(index-1)));
-        N *sibling2 = reinterpret_cast<N *>(buffer_pool_manager_->FetchPage(parent->ValueAt(index+1)));
+        N *sibling1 = reinterpret_cast<N *>(buffer_pool_manager_->FetchPage(parent->ValueAt(index-1))->GetData());
+        N *sibling2 = reinterpret_cast<N *>(buffer_pool_manager_->FetchPage(parent->ValueAt(index+1))->GetData());
         if((sibling1->GetSize()+node->GetSize()) <= node->GetMaxSize()){
             buffer_pool_manager_->UnpinPage(sibling2->GetPageId(),false);
             should_delete_node = Coalesce(node,sibling1,parent,index-1,transaction);
@@ -487,7 +488,7 @@ bool BPlusTree::AdjustRoot(BPlusTreePage *old_root_node) {
         auto *temp = reinterpret_cast<InternalPage *>(old_root_node);
         root_page_id_ = temp->ValueAt(0);
         UpdateRootPageId(0);
-        temp = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(root_page_id_));
+        temp = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(root_page_id_)->GetData());
         temp->SetParentPageId(INVALID_PAGE_ID);
         buffer_pool_manager_->UnpinPage(root_page_id_,true);
         return true;
@@ -506,7 +507,7 @@ bool BPlusTree::AdjustRoot(BPlusTreePage *old_root_node) {
 IndexIterator BPlusTree::Begin() {
     // Find the leftmost leaf page by calling the FindLeafPage method
     // with 'nullptr' as the key and 'true' to indicate the leftmost search.
-    auto *leftmost_leaf = reinterpret_cast<LeafPage *>(FindLeafPage(nullptr, root_page_id_,true));
+    auto *leftmost_leaf = reinterpret_cast<LeafPage *>(FindLeafPage(nullptr, root_page_id_,true)->GetData());
     // Get the page ID of the leftmost leaf page.
     page_id_t pageid = leftmost_leaf->GetPageId();
     // Unpin the leftmost leaf page since it's no longer needed in memory.
@@ -523,7 +524,7 @@ IndexIterator BPlusTree::Begin() {
 IndexIterator BPlusTree::Begin(const GenericKey *key) {
     // Find the leftmost leaf page by calling the FindLeafPage method
     // with 'nullptr' as the key and 'true' to indicate the leftmost search.
-    auto *leftmost_leaf = reinterpret_cast<LeafPage *>(FindLeafPage(key, root_page_id_,false));
+    auto *leftmost_leaf = reinterpret_cast<LeafPage *>(FindLeafPage(key, root_page_id_,false)->GetData());
     // Get the page ID of the leftmost leaf page.
     page_id_t pageid = leftmost_leaf->GetPageId();
     int index = leftmost_leaf->KeyIndex(key,processor_);
@@ -539,10 +540,10 @@ IndexIterator BPlusTree::Begin(const GenericKey *key) {
  * @return : index iterator
  */
 IndexIterator BPlusTree::End() {
-    auto *temp = reinterpret_cast<LeafPage *>(FindLeafPage(nullptr,root_page_id_,true));
+    auto *temp = reinterpret_cast<LeafPage *>(FindLeafPage(nullptr,root_page_id_,true)->GetData());
     BPlusTreeLeafPage *next;
     while(temp->GetNextPageId() != INVALID_PAGE_ID){
-        next=reinterpret_cast<LeafPage *>(buffer_pool_manager_->FetchPage(temp->GetNextPageId()));
+        next=reinterpret_cast<LeafPage *>(buffer_pool_manager_->FetchPage(temp->GetNextPageId())->GetData());
         buffer_pool_manager_->UnpinPage(temp->GetPageId(),false);
         temp=next;
     }
@@ -561,11 +562,12 @@ IndexIterator BPlusTree::End() {
  * Note: the leaf page is pinned, you need to unpin it after use.
  */
 Page *BPlusTree::FindLeafPage(const GenericKey *key, page_id_t page_id, bool leftMost) {
-    // Fetch the root page
-    auto * page = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(page_id));
     if(page_id == INVALID_PAGE_ID){
         return nullptr;
     }
+    // Fetch the root page
+    Page *raw_page = buffer_pool_manager_->FetchPage(page_id);
+    auto * page = reinterpret_cast<BPlusTreePage *>(raw_page->GetData());
     InternalPage *temp;
     page_id_t next_page_id;
     // Traverse the tree to find the correct leaf page
@@ -580,11 +582,12 @@ Page *BPlusTree::FindLeafPage(const GenericKey *key, page_id_t page_id, bool lef
             next_page_id = temp->Lookup(key, processor_);
         }
         // Fetch the next page
-        page = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(next_page_id));
+        raw_page = buffer_pool_manager_->FetchPage(next_page_id);
+        page = reinterpret_cast<BPlusTreePage *>(raw_page->GetData());
         // Unpin the current page before moving to the next
         buffer_pool_manager_->UnpinPage(temp->GetPageId(), false);
     }
-    return reinterpret_cast<Page *>(page);
+    return raw_page;
 }
 
 /*
@@ -596,7 +599,7 @@ Page *BPlusTree::FindLeafPage(const GenericKey *key, page_id_t page_id, bool lef
  * updating it.
  */
 void BPlusTree::UpdateRootPageId(int insert_record) {
-    auto page = reinterpret_cast<IndexRootsPage *>(buffer_pool_manager_->FetchPage(INDEX_ROOTS_PAGE_ID));
+    auto page = reinterpret_cast<IndexRootsPage *>(buffer_pool_manager_->FetchPage(INDEX_ROOTS_PAGE_ID)->GetData());
     if(insert_record){
         page->Insert(index_id_,root_page_id_);
     }
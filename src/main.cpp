@@ -1,4 +1,5 @@
 #include <cstdio>
+#include <cstring>
 
 #include "executor/execute_engine.h"
 #include "glog/logging.h"
@@ -36,8 +37,8 @@ int main(int argc, char **argv) {
   // command buffer
   const int buf_size = 1024;
   char cmd[buf_size];
-  // executor engine
-  ExecuteEngine engine;
+  // executor engine, --read-only opens the databases for queries only
+  ExecuteEngine engine(argc > 1 && strcmp(argv[1], "--read-only") == 0);
   // for print syntax tree
   TreeFileManagers syntax_tree_file_mgr("syntax_tree_");
   uint32_t syntax_tree_id = 0;
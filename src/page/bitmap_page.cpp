@@ -1,63 +1,101 @@
 #include "page/bitmap_page.h"
 
+#include <cstring>
+
 #include "glog/logging.h"
 
-/**
- * TODO: Student Implement
- */
 template <size_t PageSize>
 bool BitmapPage<PageSize>::AllocatePage(uint32_t &page_offset) {
-  if(page_allocated_==8*MAX_CHARS){
+  if (page_allocated_ >= GetMaxSupportedSize()) {
+    return false;
+  }
+  uint32_t free_page = FirstFreePage();
+  if (free_page >= GetMaxSupportedSize()) {
+    return false;
+  }
+  page_offset = free_page;
+  return AllocatePageAt(free_page);
+}
+
+template <size_t PageSize>
+bool BitmapPage<PageSize>::AllocatePageAt(uint32_t page_offset) {
+  if (page_offset >= GetMaxSupportedSize() || !IsPageFree(page_offset)) {
     return false;
   }
+  bytes[page_offset / 8] |= 1 << (7 - page_offset % 8);
   page_allocated_++;
-  //next_free_page_/8 is the byte position of the next free page
-  //next_free_page_%8 is the bit position of the next free page
-  bytes[next_free_page_/8]|=1<<(7-(next_free_page_%8));
-  page_offset=next_free_page_;
-  next_free_page_ = 8 * MAX_CHARS;
-  for(uint32_t i=(page_offset+1);i<8*MAX_CHARS;i++){
-    if((bytes[i/8]&(1<<(7-i%8))) == 0){
-      next_free_page_=i;
-      break;
-    }
+  if (page_offset == next_free_page_) {
+    next_free_page_ = FindFreePage(page_offset + 1);
   }
   return true;
 }
 
-/**
- * TODO: Student Implement
- */
 template <size_t PageSize>
 bool BitmapPage<PageSize>::DeAllocatePage(uint32_t page_offset) {
-  if(!(bytes[page_offset/8]&(1<<(7-page_offset%8)))){
+  if (page_offset >= GetMaxSupportedSize() || IsPageFree(page_offset)) {
     return false;
   }
-  bytes[page_offset/8]&=~(1<<(7-page_offset%8));
+  bytes[page_offset / 8] &= ~(1 << (7 - page_offset % 8));
   page_allocated_--;
-  if(next_free_page_>page_offset){
-    next_free_page_=page_offset;
+  if (next_free_page_ > page_offset) {
+    next_free_page_ = page_offset;
   }
   return true;
 }
 
-/**
- * TODO: Student Implement
- */
 template <size_t PageSize>
 bool BitmapPage<PageSize>::IsPageFree(uint32_t page_offset) const {
-  uint32_t byte_index=page_offset/8;
-  uint32_t bit_index=page_offset%8;
-  return IsPageFreeLow(byte_index,bit_index);
+  return IsPageFreeLow(page_offset / 8, page_offset % 8);
 }
 
 template <size_t PageSize>
 bool BitmapPage<PageSize>::IsPageFreeLow(uint32_t byte_index, uint8_t bit_index) const {
-  if(bytes[byte_index]&(1<<(7-bit_index))){
-    return false;
-  }else{
-    return true;
+  return (bytes[byte_index] & (1 << (7 - bit_index))) == 0;
+}
+
+template <size_t PageSize>
+uint64_t BitmapPage<PageSize>::GetWord(size_t word_index) const {
+  uint64_t word;
+  memcpy(&word, bytes + word_index * sizeof(uint64_t), sizeof(uint64_t));
+  // 页号小的在字节的高位，按大端解释后页号从最高位向低位排列
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  word = __builtin_bswap64(word);
+#endif
+  return word;
+}
+
+template <size_t PageSize>
+uint32_t BitmapPage<PageSize>::FindFreePage(uint32_t start) const {
+  for (size_t word_index = start / 64; word_index < MAX_CHARS / sizeof(uint64_t); word_index++) {
+    // 取反后第一个1就是第一个空闲页
+    uint64_t word = ~GetWord(word_index);
+    if (word_index == start / 64) {
+      word &= ~0ULL >> (start % 64);
+    }
+    if (word != 0) {
+      return static_cast<uint32_t>(word_index * 64 + __builtin_clzll(word));
+    }
+  }
+  return GetMaxSupportedSize();
+}
+
+template <size_t PageSize>
+uint32_t BitmapPage<PageSize>::FirstFreePage() const {
+  // next_free_page_失效（例如旧文件里的值）时从头找
+  if (next_free_page_ < GetMaxSupportedSize() && IsPageFree(next_free_page_)) {
+    return next_free_page_;
   }
+  return FindFreePage(0);
+}
+
+template <size_t PageSize>
+uint32_t BitmapPage<PageSize>::FindFreeRun(uint32_t start) const {
+  for (size_t word_index = (start + 63) / 64; word_index < MAX_CHARS / sizeof(uint64_t); word_index++) {
+    if (GetWord(word_index) == 0) {
+      return static_cast<uint32_t>(word_index * 64);
+    }
+  }
+  return GetMaxSupportedSize();
 }
 
 template class BitmapPage<64>;
@@ -72,4 +110,10 @@ template class BitmapPage<1024>;
 
 template class BitmapPage<2048>;
 
-template class BitmapPage<4096>;
\ No newline at end of file
+template class BitmapPage<4096>;
+
+template class BitmapPage<8192>;
+
+template class BitmapPage<16384>;
+
+template class BitmapPage<32768>;
\ No newline at end of file
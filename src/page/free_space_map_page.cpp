@@ -0,0 +1,28 @@
+#include "page/free_space_map_page.h"
+
+#include <algorithm>
+
+bool FreeSpaceMapPage::Append(page_id_t heap_page_id, uint8_t space_class) {
+  if (IsFull()) {
+    return false;
+  }
+  page_ids_[count_] = heap_page_id;
+  SetClass(count_, space_class);
+  count_++;
+  return true;
+}
+
+uint32_t FreeSpaceMapPage::FindPage(uint8_t space_class) const {
+  for (uint32_t i = 0; i < count_; i++) {
+    if (GetClass(i) >= space_class) return i;
+  }
+  return count_;
+}
+
+uint8_t FreeSpaceMapPage::GetMaxClass() const {
+  uint8_t max_class = 0;
+  for (uint32_t i = 0; i < count_; i++) {
+    max_class = std::max(max_class, GetClass(i));
+  }
+  return max_class;
+}
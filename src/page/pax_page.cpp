@@ -0,0 +1,303 @@
+#include "page/pax_page.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "page/free_space_map_page.h"
+
+// slot的宽度按free space map的单位向上取整：map里page的空间向下取整、行的大小向上取整，这样空着的slot不会因为取整被漏掉
+static uint32_t RoundSlotSize(uint32_t slot_size) {
+  return (slot_size + FreeSpaceMapPage::CLASS_UNIT - 1) / FreeSpaceMapPage::CLASS_UNIT * FreeSpaceMapPage::CLASS_UNIT;
+}
+
+void PaxPage::Init(page_id_t page_id, page_id_t prev_id, Schema *schema, LogManager * /*log_mgr*/, Txn * /*txn*/) {
+  memcpy(GetData(), &page_id, sizeof(page_id));
+  SetPrevPageId(prev_id);
+  SetNextPageId(INVALID_PAGE_ID);
+  SetHeader(OFFSET_FREE_SPACE, PAX_MARK);
+  uint32_t column_count = schema->GetColumnCount();
+  // 每个slot固定占的bit数，以及一行char平均和最多要的heap空间；更长的char值TableHeap会放到overflow page里
+  uint32_t slot_bits = 8;
+  uint32_t average_heap_size = 0;
+  uint32_t max_heap_size = 0;
+  for (auto column : schema->GetColumns()) {
+    slot_bits += 1 + 8 * ValueSize(column->GetType());
+    if (column->GetType() == TypeId::kTypeChar) {
+      uint32_t len = std::min(column->GetLength(), static_cast<uint32_t>(ROW_INLINE_SIZE));
+      average_heap_size += len / 2;
+      max_heap_size += len;
+    }
+  }
+  max_heap_size = std::min(max_heap_size, static_cast<uint32_t>(ROW_INLINE_SIZE));
+  uint32_t space = PAGE_SIZE - OFFSET_COLUMNS - SIZE_COLUMN * column_count;
+  auto layout_size = [&](uint32_t slot_count) {
+    uint32_t size = slot_count;
+    for (auto column : schema->GetColumns()) {
+      size += (slot_count + 7) / 8 + slot_count * ValueSize(column->GetType());
+    }
+    return size;
+  };
+  // slot数按平均长度的行估计，但是heap至少要放得下一个最长的行
+  uint32_t slot_count = std::max(8 * space / (slot_bits + 8 * average_heap_size), 1U);
+  while (slot_count > 1 && (layout_size(slot_count) + slot_count * average_heap_size > space ||
+                            layout_size(slot_count) + max_heap_size > space)) {
+    slot_count--;
+  }
+  SetHeader(OFFSET_SLOT_COUNT, slot_count);
+  SetHeader(OFFSET_ROW_COUNT, 0);
+  SetHeader(OFFSET_COLUMN_COUNT, column_count);
+  uint32_t offset = OFFSET_COLUMNS + SIZE_COLUMN * column_count + slot_count;
+  for (uint32_t i = 0; i < column_count; i++) {
+    TypeId type = schema->GetColumn(i)->GetType();
+    SetHeader(OFFSET_COLUMNS + SIZE_COLUMN * i, type);
+    SetHeader(OFFSET_COLUMNS + SIZE_COLUMN * i + 4, offset);
+    offset += (slot_count + 7) / 8 + slot_count * ValueSize(type);
+  }
+  // slot的标记和null bitmap都清零
+  uint32_t flags_offset = OFFSET_COLUMNS + SIZE_COLUMN * column_count;
+  memset(GetData() + flags_offset, 0, offset - flags_offset);
+  SetHeader(OFFSET_HEAP_BEGIN, offset);
+  SetHeader(OFFSET_HEAP_POINTER, PAGE_SIZE);
+  SetHeader(OFFSET_HEAP_GARBAGE, 0);
+}
+
+uint32_t PaxPage::GetFreeSpaceForRow() {
+  if (GetHeader(OFFSET_ROW_COUNT) >= GetSlotCount()) return 0;
+  // 和GetRowSize一样算上一个slot在minipage里的宽度，没有char列的表空出的slot才会被找到
+  uint32_t slot_size = 0;
+  for (uint32_t i = 0; i < GetColumnCount(); i++) {
+    slot_size += ValueSize(GetColumnType(i));
+  }
+  return RoundSlotSize(slot_size) + GetHeader(OFFSET_HEAP_POINTER) - GetHeader(OFFSET_HEAP_BEGIN) +
+         GetHeader(OFFSET_HEAP_GARBAGE);
+}
+
+uint32_t PaxPage::GetRowSize(const Row &row, Schema *schema) {
+  uint32_t slot_size = 0;
+  for (auto column : schema->GetColumns()) {
+    slot_size += ValueSize(column->GetType());
+  }
+  return RoundSlotSize(slot_size) + GetHeapSize(row, schema);
+}
+
+void PaxPage::SetNull(uint32_t slot_num, uint32_t column, bool is_null) {
+  char *bitmap = GetMinipage(column);
+  if (is_null) {
+    bitmap[slot_num / 8] |= static_cast<char>(1 << (7 - slot_num % 8));
+  } else {
+    bitmap[slot_num / 8] &= static_cast<char>(~(1 << (7 - slot_num % 8)));
+  }
+}
+
+uint32_t PaxPage::GetHeapSize(const Row &row, Schema *schema) {
+  uint32_t size = 0;
+  for (uint32_t i = 0; i < row.GetFieldCount(); i++) {
+    Field *field = row.GetField(i);
+    if (schema->GetColumn(i)->GetType() == TypeId::kTypeChar && !field->IsNull() && !field->IsOverflow()) {
+      size += field->GetLength();
+    }
+  }
+  return size;
+}
+
+uint32_t PaxPage::GetHeapSize(uint32_t slot_num) {
+  uint32_t size = 0;
+  for (uint32_t i = 0; i < GetColumnCount(); i++) {
+    if (GetColumnType(i) == TypeId::kTypeChar && !IsNull(slot_num, i)) {
+      uint32_t len = MACH_READ_UINT32(GetValue(slot_num, i) + sizeof(uint32_t));
+      // 在overflow page里的值不占heap
+      if ((len & CHAR_OVERFLOW_FLAG) == 0) size += len;
+    }
+  }
+  return size;
+}
+
+bool PaxPage::ReserveHeap(uint32_t size) {
+  uint32_t heap_pointer = GetHeader(OFFSET_HEAP_POINTER);
+  uint32_t heap_free = heap_pointer - GetHeader(OFFSET_HEAP_BEGIN);
+  if (size <= heap_free) return true;
+  if (size > heap_free + GetHeader(OFFSET_HEAP_GARBAGE)) return false;
+  // 删除和更新留下的垃圾加起来才够，把还在用的char值紧凑地重新排到page末尾
+  std::vector<char> heap(PAGE_SIZE);
+  heap_pointer = PAGE_SIZE;
+  uint8_t *flags = GetSlotFlags();
+  for (uint32_t slot_num = 0; slot_num < GetSlotCount(); slot_num++) {
+    if (flags[slot_num] == SLOT_FREE) continue;
+    for (uint32_t i = 0; i < GetColumnCount(); i++) {
+      if (GetColumnType(i) != TypeId::kTypeChar || IsNull(slot_num, i)) continue;
+      char *value = GetValue(slot_num, i);
+      uint32_t len = MACH_READ_UINT32(value + sizeof(uint32_t));
+      if ((len & CHAR_OVERFLOW_FLAG) != 0) continue;
+      heap_pointer -= len;
+      memcpy(heap.data() + heap_pointer, GetData() + MACH_READ_UINT32(value), len);
+      MACH_WRITE_UINT32(value, heap_pointer);
+    }
+  }
+  memcpy(GetData() + heap_pointer, heap.data() + heap_pointer, PAGE_SIZE - heap_pointer);
+  SetHeader(OFFSET_HEAP_POINTER, heap_pointer);
+  SetHeader(OFFSET_HEAP_GARBAGE, 0);
+  return true;
+}
+
+void PaxPage::WriteRow(uint32_t slot_num, const Row &row) {
+  ASSERT(row.GetFieldCount() == GetColumnCount(), "Fields size do not match the columns of the page.");
+  uint32_t heap_pointer = GetHeader(OFFSET_HEAP_POINTER);
+  for (uint32_t i = 0; i < GetColumnCount(); i++) {
+    Field *field = row.GetField(i);
+    SetNull(slot_num, i, field->IsNull());
+    if (field->IsNull()) continue;
+    char *value = GetValue(slot_num, i);
+    if (GetColumnType(i) == TypeId::kTypeChar && field->IsOverflow()) {
+      // 不占heap，offset的位置记下第一个overflow page
+      MACH_WRITE_TO(page_id_t, value, field->GetOverflowPageId());
+      MACH_WRITE_UINT32(value + sizeof(uint32_t), field->GetLength() | CHAR_OVERFLOW_FLAG);
+    } else if (GetColumnType(i) == TypeId::kTypeChar) {
+      uint32_t len = field->GetLength();
+      heap_pointer -= len;
+      memcpy(GetData() + heap_pointer, field->GetData(), len);
+      MACH_WRITE_UINT32(value, heap_pointer);
+      MACH_WRITE_UINT32(value + sizeof(uint32_t), len);
+    } else {
+      field->SerializeTo(value);
+    }
+  }
+  SetHeader(OFFSET_HEAP_POINTER, heap_pointer);
+}
+
+Field PaxPage::GetField(uint32_t slot_num, uint32_t column, bool copy) {
+  TypeId type = GetColumnType(column);
+  if (IsNull(slot_num, column)) {
+    return Field(type);
+  }
+  char *value = GetValue(slot_num, column);
+  switch (type) {
+    case TypeId::kTypeInt:
+      return Field(type, MACH_READ_FROM(int32_t, value));
+    case TypeId::kTypeFloat:
+      return Field(type, MACH_READ_FROM(float, value));
+    default: {
+      uint32_t len = MACH_READ_UINT32(value + sizeof(uint32_t));
+      if ((len & CHAR_OVERFLOW_FLAG) != 0) {
+        return Field(type, len & ~CHAR_OVERFLOW_FLAG, MACH_READ_FROM(page_id_t, value));
+      }
+      return Field(type, GetData() + MACH_READ_UINT32(value), len, copy);
+    }
+  }
+}
+
+void PaxPage::ReadRow(uint32_t slot_num, Row *row) {
+  row->destroy();
+  for (uint32_t i = 0; i < GetColumnCount(); i++) {
+    row->GetFields().push_back(new Field(GetField(slot_num, i, true)));
+  }
+  row->SetRowId(RowId(GetTablePageId(), slot_num));
+}
+
+bool PaxPage::InsertTuple(Row &row, Schema *schema, Txn * /*txn*/, LockManager * /*lock_manager*/,
+                          LogManager * /*log_manager*/) {
+  if (GetHeader(OFFSET_ROW_COUNT) >= GetSlotCount() || !ReserveHeap(GetHeapSize(row, schema))) {
+    return false;
+  }
+  // 有空闲的slot就一定能找到
+  uint8_t *flags = GetSlotFlags();
+  uint32_t slot_num = 0;
+  while (flags[slot_num] != SLOT_FREE) {
+    slot_num++;
+  }
+  WriteRow(slot_num, row);
+  flags[slot_num] = SLOT_USED;
+  SetHeader(OFFSET_ROW_COUNT, GetHeader(OFFSET_ROW_COUNT) + 1);
+  row.SetRowId(RowId(GetTablePageId(), slot_num));
+  return true;
+}
+
+size_t PaxPage::InsertTuples(std::vector<Row> &rows, size_t begin, Schema *schema) {
+  size_t i = begin;
+  while (i < rows.size() && InsertTuple(rows[i], schema, nullptr, nullptr, nullptr)) {
+    i++;
+  }
+  return i;
+}
+
+bool PaxPage::MarkDelete(const RowId &rid, Txn * /*txn*/, LockManager * /*lock_manager*/,
+                         LogManager * /*log_manager*/) {
+  if (!IsLive(rid.GetSlotNum())) {
+    return false;
+  }
+  GetSlotFlags()[rid.GetSlotNum()] = SLOT_DELETED;
+  return true;
+}
+
+int PaxPage::UpdateTuple(const Row &new_row, Row *old_row, Schema *schema, Txn * /*txn*/,
+                         LockManager * /*lock_manager*/, LogManager * /*log_manager*/) {
+  ASSERT(old_row != nullptr && old_row->GetRowId().Get() != INVALID_ROWID.Get(), "invalid old row.");
+  uint32_t slot_num = old_row->GetRowId().GetSlotNum();
+  if (!IsLive(slot_num)) {
+    return 2;
+  }
+  uint32_t old_size = GetHeapSize(slot_num);
+  uint32_t heap_free = GetHeader(OFFSET_HEAP_POINTER) - GetHeader(OFFSET_HEAP_BEGIN) + GetHeader(OFFSET_HEAP_GARBAGE);
+  uint32_t new_size = GetHeapSize(new_row, schema);
+  if (heap_free + old_size < new_size) {
+    return 1;
+  }
+  ReadRow(slot_num, old_row);
+  // 旧的char值变成垃圾，整理heap的时候这个slot先当作空闲的
+  SetHeader(OFFSET_HEAP_GARBAGE, GetHeader(OFFSET_HEAP_GARBAGE) + old_size);
+  GetSlotFlags()[slot_num] = SLOT_FREE;
+  bool __attribute__((unused)) reserved = ReserveHeap(new_size);
+  ASSERT(reserved, "Unexpected behavior in heap compaction.");
+  WriteRow(slot_num, new_row);
+  GetSlotFlags()[slot_num] = SLOT_USED;
+  return 0;
+}
+
+void PaxPage::ApplyDelete(const RowId &rid, Txn * /*txn*/, LogManager * /*log_manager*/) {
+  uint32_t slot_num = rid.GetSlotNum();
+  ASSERT(slot_num < GetSlotCount(), "Cannot have more slots than tuples.");
+  uint8_t *flags = GetSlotFlags();
+  if (flags[slot_num] == SLOT_FREE) return;
+  SetHeader(OFFSET_HEAP_GARBAGE, GetHeader(OFFSET_HEAP_GARBAGE) + GetHeapSize(slot_num));
+  flags[slot_num] = SLOT_FREE;
+  SetHeader(OFFSET_ROW_COUNT, GetHeader(OFFSET_ROW_COUNT) - 1);
+}
+
+void PaxPage::RollbackDelete(const RowId &rid, Txn * /*txn*/, LogManager * /*log_manager*/) {
+  uint32_t slot_num = rid.GetSlotNum();
+  ASSERT(slot_num < GetSlotCount(), "We can't have more slots than tuples.");
+  if (GetSlotFlags()[slot_num] == SLOT_DELETED) {
+    GetSlotFlags()[slot_num] = SLOT_USED;
+  }
+}
+
+bool PaxPage::GetTuple(Row *row, Schema * /*schema*/, Txn * /*txn*/, LockManager * /*lock_manager*/) {
+  ASSERT(row != nullptr && row->GetRowId().Get() != INVALID_ROWID.Get(), "Invalid row.");
+  if (!IsLive(row->GetRowId().GetSlotNum())) {
+    return false;
+  }
+  ReadRow(row->GetRowId().GetSlotNum(), row);
+  return true;
+}
+
+bool PaxPage::GetFirstTupleRid(RowId *first_rid) {
+  for (uint32_t i = 0; i < GetSlotCount(); i++) {
+    if (IsLive(i)) {
+      first_rid->Set(GetTablePageId(), i);
+      return true;
+    }
+  }
+  first_rid->Set(INVALID_PAGE_ID, 0);
+  return false;
+}
+
+bool PaxPage::GetNextTupleRid(const RowId &cur_rid, RowId *next_rid) {
+  ASSERT(cur_rid.GetPageId() == GetTablePageId(), "Wrong table!");
+  for (auto i = cur_rid.GetSlotNum() + 1; i < GetSlotCount(); i++) {
+    if (IsLive(i)) {
+      next_rid->Set(GetTablePageId(), i);
+      return true;
+    }
+  }
+  next_rid->Set(INVALID_PAGE_ID, 0);
+  return false;
+}
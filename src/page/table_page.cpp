@@ -1,5 +1,7 @@
 #include "page/table_page.h"
 
+#include "page/pax_page.h"
+
 // TODO: Update interface implementation if apply recovery
 
 void TablePage::Init(page_id_t page_id, page_id_t prev_id, LogManager *log_mgr, Txn *txn) {
@@ -10,7 +12,23 @@ void TablePage::Init(page_id_t page_id, page_id_t prev_id, LogManager *log_mgr,
   SetTupleCount(0); // 一开始TupleCount为0
 }
 
+void TablePage::Init(page_id_t page_id, page_id_t prev_id, TableFormat format, Schema *schema, LogManager *log_mgr,
+                     Txn *txn) {
+  if (format == TableFormat::kPaxFormat) {
+    AsPax()->Init(page_id, prev_id, schema, log_mgr, txn);
+  } else {
+    Init(page_id, prev_id, log_mgr, txn);
+  }
+}
+
+uint32_t TablePage::GetFreeSpaceForRow() {
+  if (IsPax()) return AsPax()->GetFreeSpaceForRow();
+  uint32_t free_space = GetFreeSpaceRemaining();
+  return free_space > SIZE_TUPLE ? free_space - SIZE_TUPLE : 0;
+}
+
 bool TablePage::InsertTuple(Row &row, Schema *schema, Txn *txn, LockManager *lock_manager, LogManager *log_manager) {
+  if (IsPax()) return AsPax()->InsertTuple(row, schema, txn, lock_manager, log_manager);
   uint32_t serialized_size = row.GetSerializedSize(schema);
   ASSERT(serialized_size > 0, "Can not have empty row.");
 	// 记录一条数据需要数据本身的空间加上Tuple
@@ -45,7 +63,32 @@ bool TablePage::InsertTuple(Row &row, Schema *schema, Txn *txn, LockManager *loc
   return true;
 }
 
+size_t TablePage::InsertTuples(std::vector<Row> &rows, const std::vector<uint32_t> &sizes, size_t begin,
+                               Schema *schema) {
+  if (IsPax()) return AsPax()->InsertTuples(rows, begin, schema);
+  uint32_t free_space_pointer = GetFreeSpacePointer();
+  uint32_t tuple_count = GetTupleCount();
+  size_t i = begin;
+  // 头部的字段最后一次写回，每行只写数据和slot
+  for (; i < rows.size(); i++) {
+    if (free_space_pointer - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE * tuple_count < sizes[i] + SIZE_TUPLE) {
+      break;
+    }
+    free_space_pointer -= sizes[i];
+    uint32_t __attribute__((unused)) write_bytes = rows[i].SerializeTo(GetData() + free_space_pointer, schema);
+    ASSERT(write_bytes == sizes[i], "Unexpected behavior in row serialize.");
+    SetTupleOffsetAtSlot(tuple_count, free_space_pointer);
+    SetTupleSize(tuple_count, sizes[i]);
+    rows[i].SetRowId(RowId(GetTablePageId(), tuple_count));
+    tuple_count++;
+  }
+  SetFreeSpacePointer(free_space_pointer);
+  SetTupleCount(tuple_count);
+  return i;
+}
+
 bool TablePage::MarkDelete(const RowId &rid, Txn *txn, LockManager *lock_manager, LogManager *log_manager) {
+  if (IsPax()) return AsPax()->MarkDelete(rid, txn, lock_manager, log_manager);
   uint32_t slot_num = rid.GetSlotNum();
   // If the slot number is invalid, abort.
   if (slot_num >= GetTupleCount()) {
@@ -65,6 +108,7 @@ bool TablePage::MarkDelete(const RowId &rid, Txn *txn, LockManager *lock_manager
 
 int TablePage::UpdateTuple(const Row &new_row, Row *old_row, Schema *schema, Txn *txn, LockManager *lock_manager,
                             LogManager *log_manager) {
+  if (IsPax()) return AsPax()->UpdateTuple(new_row, old_row, schema, txn, lock_manager, log_manager);
   ASSERT(old_row != nullptr && old_row->GetRowId().Get() != INVALID_ROWID.Get(), "invalid old row.");
   uint32_t serialized_size = new_row.GetSerializedSize(schema);
   ASSERT(serialized_size > 0, "Can not have empty row.");
@@ -105,6 +149,10 @@ int TablePage::UpdateTuple(const Row &new_row, Row *old_row, Schema *schema, Txn
 }
 
 void TablePage::ApplyDelete(const RowId &rid, Txn *txn, LogManager *log_manager) {
+  if (IsPax()) {
+    AsPax()->ApplyDelete(rid, txn, log_manager);
+    return;
+  }
   uint32_t slot_num = rid.GetSlotNum();
   ASSERT(slot_num < GetTupleCount(), "Cannot have more slots than tuples.");
 
@@ -136,6 +184,10 @@ void TablePage::ApplyDelete(const RowId &rid, Txn *txn, LogManager *log_manager)
 }
 
 void TablePage::RollbackDelete(const RowId &rid, Txn *txn, LogManager *log_manager) {
+  if (IsPax()) {
+    AsPax()->RollbackDelete(rid, txn, log_manager);
+    return;
+  }
   uint32_t slot_num = rid.GetSlotNum();
   ASSERT(slot_num < GetTupleCount(), "We can't have more slots than tuples.");
   uint32_t tuple_size = GetTupleSize(slot_num);
@@ -147,6 +199,7 @@ void TablePage::RollbackDelete(const RowId &rid, Txn *txn, LogManager *log_manag
 }
 
 bool TablePage::GetTuple(Row *row, Schema *schema, Txn *txn, LockManager *lock_manager) {
+  if (IsPax()) return AsPax()->GetTuple(row, schema, txn, lock_manager);
   ASSERT(row != nullptr && row->GetRowId().Get() != INVALID_ROWID.Get(), "Invalid row.");
   // Get the current slot number.
   uint32_t slot_num = row->GetRowId().GetSlotNum();
@@ -167,7 +220,28 @@ bool TablePage::GetTuple(Row *row, Schema *schema, Txn *txn, LockManager *lock_m
   return true;
 }
 
+char *TablePage::GetTupleData(const RowId &rid) {
+  if (IsPax()) return nullptr;
+  uint32_t slot_num = rid.GetSlotNum();
+  if (slot_num >= GetTupleCount() || IsDeleted(GetTupleSize(slot_num))) {
+    return nullptr;
+  }
+  return GetData() + GetTupleOffsetAtSlot(slot_num);
+}
+
+bool TablePage::HasTuple(const RowId &rid) {
+  if (IsPax()) return AsPax()->HasTuple(rid.GetSlotNum());
+  return rid.GetSlotNum() < GetTupleCount() && GetTupleSize(rid.GetSlotNum()) != 0;
+}
+
+RowView TablePage::GetRowView(const RowId &rid, const Schema *schema) {
+  if (IsPax()) return RowView(AsPax(), rid.GetSlotNum(), schema, rid);
+  // 标记删除了的tuple也可以读，ApplyDelete要找它存在overflow page里的值
+  return RowView(GetData() + GetTupleOffsetAtSlot(rid.GetSlotNum()), schema, rid);
+}
+
 bool TablePage::GetFirstTupleRid(RowId *first_rid) {
+  if (IsPax()) return AsPax()->GetFirstTupleRid(first_rid);
   // Find and return the first valid tuple.
   for (uint32_t i = 0; i < GetTupleCount(); i++) {
 		// 因为有些记录被删除了，所以需要通过循环来挨个找
@@ -181,6 +255,7 @@ bool TablePage::GetFirstTupleRid(RowId *first_rid) {
 }
 
 bool TablePage::GetNextTupleRid(const RowId &cur_rid, RowId *next_rid) {
+  if (IsPax()) return AsPax()->GetNextTupleRid(cur_rid, next_rid);
   ASSERT(cur_rid.GetPageId() == GetTablePageId(), "Wrong table!");
   // Find and return the first valid tuple after our current slot number.
   for (auto i = cur_rid.GetSlotNum() + 1; i < GetTupleCount(); i++) {
@@ -170,6 +170,12 @@ const char *GetSyntaxNodeTypeStr(SyntaxNodeType type) {
       return "kNodeTrxCommit";
     case kNodeTrxRollback:
       return "kNodeTrxRollback";
+    case kNodeShowStatus:
+      return "kNodeShowStatus";
+    case kNodeSetVariable:
+      return "kNodeSetVariable";
+    case kNodeTableFormat:
+      return "kNodeTableFormat";
     default:
       return "error type";
   }
@@ -0,0 +1,88 @@
+#include "record/row_view.h"
+
+#include "page/pax_page.h"
+#include "storage/table_heap.h"
+
+bool RowView::IsNull(uint32_t idx) const {
+  if (pax_page_ != nullptr) return pax_page_->IsNull(slot_num_, idx);
+  return (data_[sizeof(uint32_t) + idx / 8] & (1 << (7 - idx % 8))) != 0;
+}
+
+char *RowView::GetFieldData(uint32_t idx) const {
+  uint32_t field_count = GetFieldCount();
+  char *field_data = data_ + sizeof(uint32_t) + (field_count + 7) / 8;
+  // null的field不占空间，char要读出长度才知道跳过多少
+  for (uint32_t i = 0; i < idx; i++) {
+    if (IsNull(i)) continue;
+    if (schema_->GetColumn(i)->GetType() == TypeId::kTypeChar) {
+      // 存在overflow page里的值，行里只有第一个overflow page
+      uint32_t len = MACH_READ_UINT32(field_data);
+      field_data += sizeof(uint32_t) + ((len & CHAR_OVERFLOW_FLAG) != 0 ? sizeof(page_id_t) : len);
+    } else {
+      field_data += Type::GetTypeSize(schema_->GetColumn(i)->GetType());
+    }
+  }
+  return field_data;
+}
+
+Field RowView::GetField(uint32_t idx) const {
+  ASSERT(idx < GetFieldCount(), "Failed to access field");
+  if (pax_page_ != nullptr) {
+    Field field = pax_page_->GetField(slot_num_, idx);
+    if (field.IsOverflow() && table_heap_ != nullptr) return table_heap_->ReadOverflow(field);
+    return Field(field);
+  }
+  TypeId type = schema_->GetColumn(idx)->GetType();
+  if (IsNull(idx)) {
+    return Field(type);
+  }
+  char *field_data = GetFieldData(idx);
+  switch (type) {
+    case TypeId::kTypeInt:
+      return Field(type, MACH_READ_FROM(int32_t, field_data));
+    case TypeId::kTypeFloat:
+      return Field(type, MACH_READ_FROM(float, field_data));
+    default: {
+      uint32_t len = MACH_READ_UINT32(field_data);
+      if ((len & CHAR_OVERFLOW_FLAG) != 0) {
+        // 存在overflow page里的值用到时才读出来
+        Field field(type, len & ~CHAR_OVERFLOW_FLAG, MACH_READ_FROM(page_id_t, field_data + sizeof(uint32_t)));
+        return table_heap_ != nullptr ? table_heap_->ReadOverflow(field) : Field(field);
+      }
+      // 不拷贝，直接指向行里的数据
+      return Field(type, field_data + sizeof(uint32_t), len, false);
+    }
+  }
+}
+
+void RowView::ToRow(Row *row) const {
+  row->destroy();
+  if (pax_page_ != nullptr) {
+    std::vector<uint32_t> column_ids(GetFieldCount());
+    for (uint32_t i = 0; i < column_ids.size(); i++) {
+      column_ids[i] = i;
+    }
+    ToRow(column_ids, row);
+    return;
+  }
+  row->DeserializeFrom(data_, const_cast<Schema *>(schema_));
+  row->SetRowId(rid_);
+  if (table_heap_ != nullptr) table_heap_->ReadOverflow(row);
+}
+
+void RowView::ToRow(const std::vector<uint32_t> &column_ids, Row *row) const {
+  row->destroy();
+  row->SetRowId(rid_);
+  for (auto column_id : column_ids) {
+    if (pax_page_ != nullptr) {
+      row->GetFields().push_back(new Field(pax_page_->GetField(slot_num_, column_id, true)));
+      continue;
+    }
+    Field *field;
+    Field::DeserializeFrom(GetFieldData(column_id), schema_->GetColumn(column_id)->GetType(), &field,
+                           IsNull(column_id));
+    row->GetFields().push_back(field);
+  }
+  // 只读出要的列在overflow page里的值
+  if (table_heap_ != nullptr) table_heap_->ReadOverflow(row);
+}
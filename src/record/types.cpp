@@ -235,6 +235,13 @@ CmpBool TypeFloat::CompareGreaterThanEquals(const Field &left, const Field &righ
 uint32_t TypeChar::SerializeTo(const Field &field, char *buf) const {
   if (!field.IsNull()) {
     uint32_t len = GetLength(field);
+    if (field.IsOverflow()) {
+			// 内存:  len | CHAR_OVERFLOW_FLAG	 overflow page id
+			//        uint32_t                 page_id_t
+      MACH_WRITE_UINT32(buf, len | CHAR_OVERFLOW_FLAG);
+      MACH_WRITE_TO(page_id_t, buf + sizeof(uint32_t), field.GetOverflowPageId());
+      return sizeof(uint32_t) + sizeof(page_id_t);
+    }
 		// 内存:  len				data
 		//        uint32_t  char[len]
     memcpy(buf, &len, sizeof(uint32_t));
@@ -250,6 +257,11 @@ uint32_t TypeChar::DeserializeFrom(char *storage, Field **field, bool is_null) c
     return 0;
   }
   uint32_t len = MACH_READ_UINT32(storage);
+  if ((len & CHAR_OVERFLOW_FLAG) != 0) {
+    *field = new Field(TypeId::kTypeChar, len & ~CHAR_OVERFLOW_FLAG,
+                       MACH_READ_FROM(page_id_t, storage + sizeof(uint32_t)));
+    return sizeof(uint32_t) + sizeof(page_id_t);
+  }
 	// 在Field构造函数中从内存中读取数据
   *field = new Field(TypeId::kTypeChar, storage + sizeof(uint32_t), len, true);
   return len + sizeof(uint32_t);
@@ -259,6 +271,9 @@ uint32_t TypeChar::GetSerializedSize(const Field &field, bool is_null) const {
   if (is_null) {
     return 0;
   }
+  if (field.IsOverflow()) {
+    return sizeof(uint32_t) + sizeof(page_id_t);
+  }
   uint32_t len = GetLength(field);
   return len + sizeof(uint32_t);
 }
@@ -0,0 +1,264 @@
+#include "storage/async_io.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#endif
+
+#include "glog/logging.h"
+
+/**
+ * 读写到完成为止：处理被信号打断和部分完成的情况，到文件末尾时提前返回
+ * @return 传输的字节数，出错时返回-errno
+ */
+static ssize_t TransferAll(int fd, bool write, std::vector<iovec> iov, off_t offset) {
+  ssize_t total = 0;
+  size_t first = 0;
+  while (first < iov.size()) {
+    int count = static_cast<int>(std::min(iov.size() - first, static_cast<size_t>(IOV_MAX)));
+    ssize_t rc = write ? pwritev(fd, iov.data() + first, count, offset + total)
+                       : preadv(fd, iov.data() + first, count, offset + total);
+    if (rc < 0 && errno == EINTR) continue;
+    if (rc < 0) return -errno;
+    if (rc == 0) break;
+    total += rc;
+    // 跳过已经完成的iovec
+    while (rc > 0 && first < iov.size()) {
+      size_t done = std::min(static_cast<size_t>(rc), iov[first].iov_len);
+      iov[first].iov_base = static_cast<char *>(iov[first].iov_base) + done;
+      iov[first].iov_len -= done;
+      rc -= done;
+      if (iov[first].iov_len == 0) first++;
+    }
+  }
+  return total;
+}
+
+std::unique_ptr<AsyncIO> AsyncIO::Create(int fd, size_t queue_depth) {
+  std::unique_ptr<AsyncIO> engine = UringAsyncIO::Create(fd, queue_depth);
+  if (engine == nullptr) {
+    LOG(WARNING) << "io_uring is not available, using a thread pool for asynchronous I/O";
+    engine = std::make_unique<ThreadPoolAsyncIO>(fd, queue_depth);
+  }
+  return engine;
+}
+
+/*------------------------------------------------------------------------------------------------------------------*/
+
+std::unique_ptr<UringAsyncIO> UringAsyncIO::Create(int fd, size_t queue_depth) {
+#if defined(__linux__) && defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, static_cast<unsigned>(queue_depth), &params));
+  if (ring_fd < 0) return nullptr;
+  std::unique_ptr<UringAsyncIO> engine(new UringAsyncIO());
+  engine->fd_ = fd;
+  engine->ring_fd_ = ring_fd;
+  // 完成队列至少是提交队列的两倍大，在途请求不超过提交队列长度，完成队列就不会溢出
+  engine->queue_depth_ = params.sq_entries;
+  engine->sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  engine->cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single_mmap) {
+    engine->sq_ring_size_ = engine->cq_ring_size_ = std::max(engine->sq_ring_size_, engine->cq_ring_size_);
+  }
+  engine->sq_ring_ = mmap(nullptr, engine->sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+                          IORING_OFF_SQ_RING);
+  if (engine->sq_ring_ == MAP_FAILED) {
+    engine->sq_ring_ = nullptr;
+    return nullptr;
+  }
+  if (single_mmap) {
+    engine->cq_ring_ = engine->sq_ring_;
+  } else {
+    engine->cq_ring_ = mmap(nullptr, engine->cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            ring_fd, IORING_OFF_CQ_RING);
+    if (engine->cq_ring_ == MAP_FAILED) {
+      engine->cq_ring_ = nullptr;
+      return nullptr;
+    }
+  }
+  engine->sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  engine->sqes_ = mmap(nullptr, engine->sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+                       IORING_OFF_SQES);
+  if (engine->sqes_ == MAP_FAILED) {
+    engine->sqes_ = nullptr;
+    return nullptr;
+  }
+  auto *sq = static_cast<char *>(engine->sq_ring_);
+  auto *cq = static_cast<char *>(engine->cq_ring_);
+  engine->sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  engine->sq_mask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  engine->sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  engine->cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  engine->cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  engine->cq_mask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  engine->cqes_ = cq + params.cq_off.cqes;
+  engine->completion_thread_ = std::thread(&UringAsyncIO::CompletionLoop, engine.get());
+  return engine;
+#else
+  return nullptr;
+#endif
+}
+
+UringAsyncIO::~UringAsyncIO() {
+#ifdef __linux__
+  if (completion_thread_.joinable()) {
+    std::unique_lock<std::mutex> lock(latch_);
+    completed_.wait(lock, [this] { return in_flight_ == 0; });
+    // user_data为空的NOP让完成线程退出
+    PushEntry(IORING_OP_NOP, nullptr);
+    lock.unlock();
+    completion_thread_.join();
+  }
+#endif
+  if (sqes_ != nullptr) munmap(sqes_, sqes_size_);
+  if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) munmap(cq_ring_, cq_ring_size_);
+  if (sq_ring_ != nullptr) munmap(sq_ring_, sq_ring_size_);
+  if (ring_fd_ >= 0) close(ring_fd_);
+}
+
+void UringAsyncIO::Submit(bool write, const iovec *iov, int iovcnt, off_t offset, IOCallback callback) {
+#ifdef __linux__
+  uint8_t opcode = write ? IORING_OP_WRITEV : IORING_OP_READV;
+  auto *request = new Request{opcode, std::vector<iovec>(iov, iov + iovcnt), offset, std::move(callback)};
+  std::unique_lock<std::mutex> lock(latch_);
+  completed_.wait(lock, [this] { return in_flight_ < queue_depth_; });
+  in_flight_++;
+  PushEntry(opcode, request);
+#endif
+}
+
+void UringAsyncIO::PushEntry(uint8_t opcode, Request *request) {
+#ifdef __linux__
+  // 只有持有latch_的线程会写提交队列，tail不需要原子读
+  unsigned tail = *sq_tail_;
+  unsigned index = tail & *sq_mask_;
+  io_uring_sqe *sqe = static_cast<io_uring_sqe *>(sqes_) + index;
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = opcode;
+  sqe->fd = fd_;
+  if (request != nullptr) {
+    sqe->addr = reinterpret_cast<uint64_t>(request->iov_.data() + request->first_);
+    sqe->len = static_cast<uint32_t>(std::min(request->iov_.size() - request->first_, static_cast<size_t>(IOV_MAX)));
+    sqe->off = static_cast<uint64_t>(request->offset_ + request->transferred_);
+  }
+  sqe->user_data = reinterpret_cast<uint64_t>(request);
+  sq_array_[index] = index;
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  while (syscall(__NR_io_uring_enter, ring_fd_, 1, 0, 0, nullptr, 0) < 0) {
+    if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+      LOG(ERROR) << "io_uring_enter failed: " << strerror(errno);
+      break;
+    }
+  }
+#endif
+}
+
+bool UringAsyncIO::Resubmit(Request *request, int res) {
+#ifdef __linux__
+  if (res == -EINTR || res == -EAGAIN) {
+    std::lock_guard<std::mutex> guard(latch_);
+    PushEntry(request->opcode_, request);
+    return true;
+  }
+  // 出错或者到了文件末尾
+  if (res <= 0) return false;
+  request->transferred_ += res;
+  // 跳过已经完成的iovec，和TransferAll一样
+  size_t rest = static_cast<size_t>(res);
+  std::vector<iovec> &iov = request->iov_;
+  while (rest > 0 && request->first_ < iov.size()) {
+    size_t done = std::min(rest, iov[request->first_].iov_len);
+    iov[request->first_].iov_base = static_cast<char *>(iov[request->first_].iov_base) + done;
+    iov[request->first_].iov_len -= done;
+    rest -= done;
+    if (iov[request->first_].iov_len == 0) request->first_++;
+  }
+  if (request->first_ == iov.size()) return false;
+  // 只完成了一部分，剩下的部分重新提交，不占用新的在途名额
+  std::lock_guard<std::mutex> guard(latch_);
+  PushEntry(request->opcode_, request);
+  return true;
+#else
+  return false;
+#endif
+}
+
+void UringAsyncIO::CompletionLoop() {
+#ifdef __linux__
+  while (true) {
+    unsigned head = *cq_head_;
+    if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+      syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+      continue;
+    }
+    io_uring_cqe cqe = static_cast<io_uring_cqe *>(cqes_)[head & *cq_mask_];
+    __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+    if (cqe.user_data == 0) return;
+    auto *request = reinterpret_cast<Request *>(cqe.user_data);
+    if (Resubmit(request, cqe.res)) continue;
+    request->callback_(cqe.res < 0 ? cqe.res : request->transferred_);
+    delete request;
+    {
+      std::lock_guard<std::mutex> guard(latch_);
+      in_flight_--;
+    }
+    completed_.notify_all();
+  }
+#endif
+}
+
+/*------------------------------------------------------------------------------------------------------------------*/
+
+ThreadPoolAsyncIO::ThreadPoolAsyncIO(int fd, size_t queue_depth, size_t num_threads)
+    : fd_(fd), queue_depth_(queue_depth) {
+  for (size_t i = 0; i < num_threads; i++) {
+    workers_.emplace_back(&ThreadPoolAsyncIO::WorkerLoop, this);
+  }
+}
+
+ThreadPoolAsyncIO::~ThreadPoolAsyncIO() {
+  {
+    std::unique_lock<std::mutex> lock(latch_);
+    completed_.wait(lock, [this] { return in_flight_ == 0; });
+    stopped_ = true;
+  }
+  wakeup_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+void ThreadPoolAsyncIO::Submit(bool write, const iovec *iov, int iovcnt, off_t offset, IOCallback callback) {
+  {
+    std::unique_lock<std::mutex> lock(latch_);
+    completed_.wait(lock, [this] { return in_flight_ < queue_depth_; });
+    in_flight_++;
+    queue_.push_back({write, std::vector<iovec>(iov, iov + iovcnt), offset, std::move(callback)});
+  }
+  wakeup_.notify_one();
+}
+
+void ThreadPoolAsyncIO::WorkerLoop() {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (true) {
+    wakeup_.wait(lock, [this] { return stopped_ || !queue_.empty(); });
+    if (queue_.empty()) return;
+    Request request = std::move(queue_.front());
+    queue_.pop_front();
+    lock.unlock();
+    request.callback_(TransferAll(fd_, request.write_, std::move(request.iov_), request.offset_));
+    lock.lock();
+    in_flight_--;
+    completed_.notify_all();
+  }
+}
@@ -1,38 +1,136 @@
 #include "storage/disk_manager.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
 #include <filesystem>
+#include <new>
 #include <stdexcept>
 
 #include "glog/logging.h"
 #include "page/bitmap_page.h"
+#include "storage/page_compressor.h"
 
-DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
+/**
+ * O_DIRECT要求缓冲区按页对齐，不对齐的缓冲区换成对齐的临时页
+ */
+static bool IsAligned(const char *page_data) { return reinterpret_cast<uintptr_t>(page_data) % PAGE_SIZE == 0; }
+
+/**
+ * 压缩页里记录的未压缩页的校验和(FNV-1a)
+ */
+static uint32_t PageChecksum(const char *page_data) {
+  uint32_t hash = 2166136261U;
+  for (size_t i = 0; i < PAGE_SIZE; i++) {
+    hash = (hash ^ static_cast<uint8_t>(page_data[i])) * 16777619U;
+  }
+  return hash;
+}
+
+DiskManager::DiskManager(const std::string &db_file, bool direct_io, bool read_only)
+    : file_name_(db_file), direct_io_(direct_io && !read_only), read_only_(read_only) {
   std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    std::filesystem::path p = db_file;
-    if (p.has_parent_path()) std::filesystem::create_directories(p.parent_path());
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-    if (!db_io_.is_open()) {
-      throw std::exception();
-    }
+  compressed_pages_ = std::make_unique<std::atomic<std::atomic<uint64_t> *>[]>(MAX_EXTENTS);
+  if (read_only_) {
+    OpenMapping();
+  } else {
+    OpenFile();
   }
   ReadPhysicalPage(META_PAGE_ID, meta_data_);
+  CheckMetaPage();
+  // 根据meta page中每个extent的已用页数建立空闲extent的摘要
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  bitmaps_.resize(MAX_EXTENTS);
+  non_full_extents_.assign((MAX_EXTENTS + 63) / 64, 0);
+  for (uint32_t i = 0; i < MAX_EXTENTS; i++) {
+    SetExtentFull(i, meta_page->extent_used_page_[i] >= BITMAP_SIZE);
+  }
+}
+
+void DiskManager::CheckMetaPage() {
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  std::string error;
+  if (meta_page->HasMagicNum()) {
+    if (meta_page->GetPageSize() != PAGE_SIZE) {
+      error = file_name_ + " was created with " + std::to_string(meta_page->GetPageSize()) + " byte pages";
+    }
+  } else if (file_size_ == 0) {
+    // 新文件直接写上页大小
+    meta_page->Init();
+  } else if (PAGE_SIZE != 4096 || !meta_page->UpgradeLegacy()) {
+    // 没有magic number的旧文件都是4KB的页
+    error = file_name_ + " is a legacy database file with 4096 byte pages";
+  }
+  if (!error.empty()) {
+    if (mapping_ != nullptr) munmap(mapping_, mapping_size_);
+    close(fd_);
+    throw std::runtime_error(error + ", this build uses " + std::to_string(PAGE_SIZE) + " byte pages");
+  }
+}
+
+void DiskManager::OpenFile() {
+  // directory does not exist
+  std::filesystem::path p = file_name_;
+  if (p.has_parent_path()) std::filesystem::create_directories(p.parent_path());
+  const std::string &db_file = file_name_;
+  int flags = O_RDWR | O_CREAT;
+#ifdef O_DIRECT
+  if (direct_io_) {
+    fd_ = open(db_file.c_str(), flags | O_DIRECT, 0644);
+    // tmpfs等文件系统不支持O_DIRECT，退回到普通I/O
+    if (fd_ < 0 && errno == EINVAL) {
+      LOG(WARNING) << "O_DIRECT is not supported for " << db_file << ", using buffered I/O";
+      direct_io_ = false;
+    }
+  }
+#else
+  direct_io_ = false;
+#endif
+  if (fd_ < 0) fd_ = open(db_file.c_str(), flags, 0644);
+  if (fd_ < 0) {
+    throw std::runtime_error("Cannot open " + db_file + ": " + strerror(errno));
+  }
+  struct stat stat_buf;
+  file_size_ = fstat(fd_, &stat_buf) == 0 ? stat_buf.st_size : 0;
+  preallocated_end_ = file_size_;
+}
+
+void DiskManager::OpenMapping() {
+  fd_ = open(file_name_.c_str(), O_RDONLY);
+  if (fd_ < 0) {
+    throw std::runtime_error("Cannot open " + file_name_ + ": " + strerror(errno));
+  }
+  struct stat stat_buf;
+  file_size_ = fstat(fd_, &stat_buf) == 0 ? stat_buf.st_size : 0;
+  // 只映射完整的页，文件末尾不满一页的部分按文件末尾之后处理
+  mapping_size_ = file_size_ / PAGE_SIZE * PAGE_SIZE;
+  if (mapping_size_ == 0) return;
+  void *mapping = mmap(nullptr, mapping_size_, PROT_READ, MAP_SHARED, fd_, 0);
+  if (mapping == MAP_FAILED) {
+    close(fd_);
+    throw std::runtime_error("Cannot map " + file_name_ + ": " + strerror(errno));
+  }
+  mapping_ = static_cast<char *>(mapping);
 }
 
 void DiskManager::Close() {
   std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
-  WritePhysicalPage(META_PAGE_ID, meta_data_);
   if (!closed) {
-    db_io_.close();
+    // 先等所有异步请求完成
+    async_io_.reset();
+    Sync();
+    if (mapping_ != nullptr) {
+      munmap(mapping_, mapping_size_);
+      mapping_ = nullptr;
+    }
+    close(fd_);
     closed = true;
   }
 }
@@ -40,86 +138,426 @@ void DiskManager::Close() {
 void DiskManager::ReadPage(page_id_t logical_page_id, char *page_data) {
   ASSERT(logical_page_id >= 0, "Invalid page id.");
   ReadPhysicalPage(MapPageId(logical_page_id), page_data);
+  DecompressPage(logical_page_id, page_data, page_data);
 }
 
 void DiskManager::WritePage(page_id_t logical_page_id, const char *page_data) {
   ASSERT(logical_page_id >= 0, "Invalid page id.");
+  if (IsPageCompressed(logical_page_id) && WriteCompressedPage(logical_page_id, page_data)) {
+    return;
+  }
   WritePhysicalPage(MapPageId(logical_page_id), page_data);
 }
 
-/**
- * TODO: Student Implement
- */
-page_id_t DiskManager::AllocatePage() {
-  uint32_t i;
-  char buf[PAGE_SIZE];
-  page_id_t physical_page_id;
-  BitmapPage<PAGE_SIZE> *bitmap;
-  uint32_t page_offset;
-  DiskFileMetaPage *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
-  if(meta_page->GetAllocatedPages() >= MAX_VALID_PAGE_ID){
-      //LOG(WARNING) << "this disk is full" << std::endl;
+void DiskManager::ReadPages(const std::vector<page_id_t> &logical_page_ids, const std::vector<char *> &page_data) {
+  ASSERT(logical_page_ids.size() == page_data.size(), "Page ids and buffers do not match.");
+  // 按物理页号排序，磁盘上相邻的页合并成一次preadv
+  std::vector<std::pair<page_id_t, char *>> pages;
+  for (size_t i = 0; i < logical_page_ids.size(); i++) {
+    ASSERT(logical_page_ids[i] >= 0, "Invalid page id.");
+    pages.emplace_back(MapPageId(logical_page_ids[i]), page_data[i]);
+  }
+  std::sort(pages.begin(), pages.end(),
+            [](const std::pair<page_id_t, char *> &a, const std::pair<page_id_t, char *> &b) { return a.first < b.first; });
+  std::vector<char *> run;
+  std::vector<std::future<void>> runs;
+  for (size_t i = 0; i < pages.size(); i++) {
+    run.push_back(pages[i].second);
+    if (i + 1 == pages.size() || pages[i + 1].first != pages[i].first + 1 || run.size() == IOV_MAX) {
+      auto done = std::make_shared<std::promise<void>>();
+      runs.push_back(done->get_future());
+      SubmitPhysicalPages(false, pages[i].first - static_cast<page_id_t>(run.size()) + 1, run.data(), run.size(),
+                          [done](bool) { done->set_value(); });
+      run.clear();
+    }
+  }
+  for (auto &finished : runs) {
+    finished.wait();
+  }
+  for (size_t i = 0; i < logical_page_ids.size(); i++) {
+    DecompressPage(logical_page_ids[i], page_data[i], page_data[i]);
+  }
+}
+
+bool DiskManager::WritePages(const std::vector<page_id_t> &logical_page_ids,
+                             const std::vector<const char *> &page_data) {
+  ASSERT(logical_page_ids.size() == page_data.size(), "Page ids and buffers do not match.");
+  std::vector<std::pair<page_id_t, const char *>> pages;
+  for (size_t i = 0; i < logical_page_ids.size(); i++) {
+    ASSERT(logical_page_ids[i] >= 0, "Invalid page id.");
+    // 压缩的页单独写，只写压缩后的几个块
+    if (IsPageCompressed(logical_page_ids[i]) && WriteCompressedPage(logical_page_ids[i], page_data[i])) {
+      continue;
+    }
+    pages.emplace_back(MapPageId(logical_page_ids[i]), page_data[i]);
+  }
+  std::sort(pages.begin(), pages.end(),
+            [](const std::pair<page_id_t, const char *> &a, const std::pair<page_id_t, const char *> &b) {
+              return a.first < b.first;
+            });
+  std::vector<char *> run;
+  std::vector<std::future<bool>> runs;
+  for (size_t i = 0; i < pages.size(); i++) {
+    run.push_back(const_cast<char *>(pages[i].second));
+    if (i + 1 == pages.size() || pages[i + 1].first != pages[i].first + 1 || run.size() == IOV_MAX) {
+      auto done = std::make_shared<std::promise<bool>>();
+      runs.push_back(done->get_future());
+      SubmitPhysicalPages(true, pages[i].first - static_cast<page_id_t>(run.size()) + 1, run.data(), run.size(),
+                          [done](bool ok) { done->set_value(ok); });
+      run.clear();
+    }
+  }
+  // 每个请求都要等完，不能在第一个失败时就返回，缓冲区还在被使用
+  bool is_success = true;
+  for (auto &finished : runs) {
+    is_success = finished.get() && is_success;
+  }
+  return is_success;
+}
+
+std::future<void> DiskManager::ReadPageAsync(page_id_t logical_page_id, char *page_data) {
+  ASSERT(logical_page_id >= 0, "Invalid page id.");
+  auto done = std::make_shared<std::promise<void>>();
+  std::future<void> finished = done->get_future();
+  SubmitPhysicalPages(false, MapPageId(logical_page_id), &page_data, 1,
+                      [this, logical_page_id, page_data, done](bool) {
+                        DecompressPage(logical_page_id, page_data, page_data);
+                        done->set_value();
+                      });
+  return finished;
+}
+
+std::future<void> DiskManager::WritePageAsync(page_id_t logical_page_id, const char *page_data) {
+  ASSERT(logical_page_id >= 0, "Invalid page id.");
+  auto done = std::make_shared<std::promise<void>>();
+  std::future<void> finished = done->get_future();
+  if (IsPageCompressed(logical_page_id) && WriteCompressedPage(logical_page_id, page_data)) {
+    done->set_value();
+    return finished;
+  }
+  char *data = const_cast<char *>(page_data);
+  SubmitPhysicalPages(true, MapPageId(logical_page_id), &data, 1, [this, logical_page_id, done](bool ok) {
+    if (ok) {
+      done->set_value();
+    } else {
+      done->set_exception(std::make_exception_ptr(
+          std::runtime_error("Failed to write page " + std::to_string(logical_page_id) + " of " + file_name_)));
+    }
+  });
+  return finished;
+}
+
+void DiskManager::Sync() {
+  if (read_only_) {
+    return;
+  }
+  {
+    std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+    FlushBitmaps();
+    WritePhysicalPage(META_PAGE_ID, meta_data_);
+  }
+  if (fdatasync(fd_) != 0) {
+    LOG(ERROR) << "I/O error while syncing " << file_name_ << ": " << strerror(errno);
+  }
+}
+
+page_id_t DiskManager::AllocatePage(PageRun *run) {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  if (read_only_ || meta_page->GetAllocatedPages() >= MAX_VALID_PAGE_ID) {
+    return INVALID_PAGE_ID;
+  }
+  page_id_t page_id = run == nullptr ? INVALID_PAGE_ID : AllocateFromRun(run);
+  // 没有整段的空闲页可以预留时退回到普通分配
+  if (page_id == INVALID_PAGE_ID) {
+    page_id = AllocateUnreserved();
+  }
+  if (page_id != INVALID_PAGE_ID) {
+    Preallocate(page_id);
+    SetPageCompressed(page_id, run != nullptr && run->compress_);
+  }
+  return page_id;
+}
+
+void DiskManager::ReleasePageRun(PageRun *run) {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  if (run->end_ != INVALID_PAGE_ID) {
+    page_id_t first = run->end_ - static_cast<page_id_t>(PAGE_RUN_SIZE);
+    GetBitmap(first / BITMAP_SIZE)->SetReserved(first % BITMAP_SIZE, false);
+  }
+  run->next_ = run->end_ = INVALID_PAGE_ID;
+}
+
+page_id_t DiskManager::TakePage(uint32_t extent_id, uint32_t page_offset) {
+  CachedBitmap *bitmap = GetBitmap(extent_id);
+  if (!bitmap->GetPage()->AllocatePageAt(page_offset)) {
+    return INVALID_PAGE_ID;
+  }
+  bitmap->dirty_ = true;
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  meta_page->num_allocated_pages_++;
+  if (++meta_page->extent_used_page_[extent_id] == 1) {
+    meta_page->num_extents_++;
+  }
+  if (meta_page->extent_used_page_[extent_id] >= BITMAP_SIZE) {
+    SetExtentFull(extent_id, true);
+  }
+  return static_cast<page_id_t>(extent_id * BITMAP_SIZE + page_offset);
+}
+
+page_id_t DiskManager::AllocateFromRun(PageRun *run) {
+  while (true) {
+    // run中已经被别人释放后又占用的页跳过
+    while (run->next_ != INVALID_PAGE_ID && run->next_ < run->end_) {
+      page_id_t page_id = run->next_++;
+      if (TakePage(page_id / BITMAP_SIZE, page_id % BITMAP_SIZE) != INVALID_PAGE_ID) {
+        return page_id;
+      }
+    }
+    if (!ReservePageRun(run)) {
       return INVALID_PAGE_ID;
+    }
+  }
+}
+
+page_id_t DiskManager::AllocateUnreserved() {
+  uint32_t fallback_extent = MAX_EXTENTS;
+  for (size_t i = 0; i < non_full_extents_.size(); i++) {
+    for (uint64_t extents = non_full_extents_[i]; extents != 0; extents &= extents - 1) {
+      auto extent_id = static_cast<uint32_t>(i * 64 + __builtin_ctzll(extents));
+      if (fallback_extent == MAX_EXTENTS) fallback_extent = extent_id;
+      CachedBitmap *bitmap = GetBitmap(extent_id);
+      uint32_t page_offset = bitmap->GetPage()->FirstFreePage();
+      while (page_offset < BITMAP_SIZE && bitmap->IsReserved(page_offset)) {
+        // 跳过整段被预留的页
+        page_offset = bitmap->GetPage()->FindFreePage((page_offset / PAGE_RUN_SIZE + 1) * PAGE_RUN_SIZE);
+      }
+      if (page_offset < BITMAP_SIZE) {
+        return TakePage(extent_id, page_offset);
+      }
+    }
+  }
+  // 空闲页都被预留了，从预留的页里拿一个
+  if (fallback_extent == MAX_EXTENTS) {
+    return INVALID_PAGE_ID;
   }
-  for(i = 0;i < meta_page->GetExtentNums();i++){
-      if(meta_page->GetExtentUsedPage(i) < BitmapPage<PAGE_SIZE>::GetMaxSupportedSize()){
-          meta_page->num_allocated_pages_++;
-          meta_page->extent_used_page_[i]++;
-          if(meta_page->extent_used_page_[i] == 1)
-              meta_page->num_extents_++;
-          physical_page_id = i * (BITMAP_SIZE+1) + 1;
-          ReadPhysicalPage(physical_page_id, buf);
-          bitmap = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(buf);
-          if(!bitmap->AllocatePage(page_offset)){
-              LOG(ERROR) << "allocate page failed in DiskManager" << std::endl;
-          }
-          WritePhysicalPage(physical_page_id,buf);
-          return i * BITMAP_SIZE + page_offset;
+  uint32_t page_offset = GetBitmap(fallback_extent)->GetPage()->FirstFreePage();
+  if (page_offset >= BITMAP_SIZE) {
+    LOG(ERROR) << "allocate page failed in DiskManager" << std::endl;
+    SetExtentFull(fallback_extent, true);
+    return INVALID_PAGE_ID;
+  }
+  return TakePage(fallback_extent, page_offset);
+}
+
+bool DiskManager::ReservePageRun(PageRun *run) {
+  page_id_t last_end = run->end_;
+  ReleasePageRun(run);
+  uint32_t extent_id = MAX_EXTENTS;
+  uint32_t page_offset = BITMAP_SIZE;
+  // 紧接着上一段的页都空闲的话，接着用，这样整个表在磁盘上是连续的
+  if (last_end != INVALID_PAGE_ID && last_end % BITMAP_SIZE != 0) {
+    CachedBitmap *bitmap = GetBitmap(last_end / BITMAP_SIZE);
+    uint32_t next_offset = last_end % BITMAP_SIZE;
+    if (!bitmap->IsReserved(next_offset) && bitmap->GetPage()->FindFreeRun(next_offset) == next_offset) {
+      extent_id = last_end / BITMAP_SIZE;
+      page_offset = next_offset;
+    }
+  }
+  for (size_t i = 0; i < non_full_extents_.size() && extent_id == MAX_EXTENTS; i++) {
+    for (uint64_t extents = non_full_extents_[i]; extents != 0 && extent_id == MAX_EXTENTS; extents &= extents - 1) {
+      auto candidate = static_cast<uint32_t>(i * 64 + __builtin_ctzll(extents));
+      CachedBitmap *bitmap = GetBitmap(candidate);
+      uint32_t offset = bitmap->GetPage()->FindFreeRun(bitmap->GetPage()->FirstFreePage());
+      while (offset < BITMAP_SIZE && bitmap->IsReserved(offset)) {
+        offset = bitmap->GetPage()->FindFreeRun(offset + PAGE_RUN_SIZE);
+      }
+      if (offset < BITMAP_SIZE) {
+        extent_id = candidate;
+        page_offset = offset;
       }
+    }
   }
-  meta_page->num_allocated_pages_++;
-  meta_page->extent_used_page_[i]=1;
-  meta_page->num_extents_++;
-  physical_page_id = i * (BITMAP_SIZE+1) + 1;
-  ReadPhysicalPage(physical_page_id, buf);
-  bitmap = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(buf);
-  if(!bitmap->AllocatePage(page_offset)){
-      LOG(ERROR) << "allocate page failed in DiskManager" << std::endl;
+  if (extent_id == MAX_EXTENTS) {
+    return false;
   }
-  WritePhysicalPage(physical_page_id,buf);
-  return i * BITMAP_SIZE + page_offset;
+  GetBitmap(extent_id)->SetReserved(page_offset, true);
+  run->next_ = static_cast<page_id_t>(extent_id * BITMAP_SIZE + page_offset);
+  run->end_ = run->next_ + static_cast<page_id_t>(PAGE_RUN_SIZE);
+  return true;
+}
+
+void DiskManager::Preallocate(page_id_t logical_page_id) {
+#ifdef FALLOC_FL_KEEP_SIZE
+  size_t end = (static_cast<size_t>(MapPageId(logical_page_id)) + 1) * PAGE_SIZE;
+  if (!preallocate_ || end <= preallocated_end_) {
+    return;
+  }
+  // 一次多分配一些，文件不用一页一页地变大
+  size_t new_end = end + static_cast<size_t>(FILE_PREALLOCATE_PAGES - 1) * PAGE_SIZE;
+  // KEEP_SIZE只分配磁盘空间，不改变文件大小，读超出文件末尾的页仍然不需要I/O
+  if (fallocate(fd_, FALLOC_FL_KEEP_SIZE, preallocated_end_, new_end - preallocated_end_) != 0) {
+    if (errno == EOPNOTSUPP || errno == ENOSYS) {
+      preallocate_ = false;
+    } else {
+      LOG(WARNING) << "Cannot preallocate " << file_name_ << ": " << strerror(errno);
+    }
+    return;
+  }
+  preallocated_end_ = new_end;
+#else
+  (void)logical_page_id;
+#endif
 }
 
-/**
- * TODO: Student Implement
- */
 void DiskManager::DeAllocatePage(page_id_t logical_page_id) {
-  char temp[PAGE_SIZE];
-  page_id_t block_id=logical_page_id/BITMAP_SIZE;
-  page_id_t physic_page_id=block_id*(BITMAP_SIZE+1)+1;
-  ReadPhysicalPage(physic_page_id,temp);
-  uint32_t page_offset=MapPageId(logical_page_id)-physic_page_id-1;
-  BitmapPage<PAGE_SIZE>* bitmap=reinterpret_cast<BitmapPage<PAGE_SIZE>*>(temp);
-  if(bitmap->DeAllocatePage(page_offset)){
-    DiskFileMetaPage* meta_page=reinterpret_cast<DiskFileMetaPage*>(meta_data_);
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  uint32_t extent_id = logical_page_id / BITMAP_SIZE;
+  if (read_only_ || logical_page_id < 0 || extent_id >= MAX_EXTENTS) {
+    return;
+  }
+  if (GetBitmap(extent_id)->GetPage()->DeAllocatePage(logical_page_id % BITMAP_SIZE)) {
+    bitmaps_[extent_id]->dirty_ = true;
+    SetPageCompressed(logical_page_id, false);
+    auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
     meta_page->num_allocated_pages_--;
-    if(!(--meta_page->extent_used_page_[block_id])){
+    if (--meta_page->extent_used_page_[extent_id] == 0) {
       meta_page->num_extents_--;
     }
-    WritePhysicalPage(physic_page_id,temp);
+    SetExtentFull(extent_id, false);
   }
 }
 
-/**
- * TODO: Student Implement
- */
 bool DiskManager::IsPageFree(page_id_t logical_page_id) {
-  char buf[PAGE_SIZE];
-  page_id_t physical_page_id = (logical_page_id/BITMAP_SIZE) * (BITMAP_SIZE+1)+1;
-  ReadPhysicalPage(physical_page_id, buf);
-  BitmapPage<PAGE_SIZE> *bitmap = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(buf);
-  uint32_t page_offset = MapPageId(logical_page_id) - physical_page_id - 1;
-  return bitmap->IsPageFree(page_offset);
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  uint32_t extent_id = logical_page_id / BITMAP_SIZE;
+  if (logical_page_id < 0 || extent_id >= MAX_EXTENTS) {
+    return true;
+  }
+  return GetBitmap(extent_id)->GetPage()->IsPageFree(logical_page_id % BITMAP_SIZE);
+}
+
+DiskManager::CachedBitmap *DiskManager::GetBitmap(uint32_t extent_id) {
+  std::unique_ptr<CachedBitmap> &bitmap = bitmaps_[extent_id];
+  if (bitmap == nullptr) {
+    bitmap = std::make_unique<CachedBitmap>();
+    ReadPhysicalPage(static_cast<page_id_t>(extent_id * (BITMAP_SIZE + 1) + 1), bitmap->data_);
+  }
+  return bitmap.get();
+}
+
+void DiskManager::FlushBitmaps() {
+  for (uint32_t i = 0; i < bitmaps_.size(); i++) {
+    if (bitmaps_[i] == nullptr || !bitmaps_[i]->dirty_) continue;
+    WritePhysicalPage(static_cast<page_id_t>(i * (BITMAP_SIZE + 1) + 1), bitmaps_[i]->data_);
+    bitmaps_[i]->dirty_ = false;
+  }
+}
+
+char *DiskManager::GetMappedPage(page_id_t logical_page_id) {
+  if (mapping_ == nullptr || logical_page_id < 0) return nullptr;
+  size_t offset = static_cast<size_t>(MapPageId(logical_page_id)) * PAGE_SIZE;
+  return offset + PAGE_SIZE <= mapping_size_ ? mapping_ + offset : nullptr;
+}
+
+bool DiskManager::DecompressPage(page_id_t logical_page_id, const char *stored, char *page_data) {
+  CompressedPageHeader header;
+  memcpy(&header, stored, sizeof(header));
+  if (header.magic_ != COMPRESSED_PAGE_MAGIC || header.page_id_ != logical_page_id ||
+      header.size_ > PAGE_SIZE - sizeof(header)) {
+    return false;
+  }
+  // 先解压到临时页，校验和对上了才算是压缩页，stored和page_data可能是同一块内存
+  alignas(PAGE_SIZE) char buffer[PAGE_SIZE];
+  if (!PageCompressor::Decompress(stored + sizeof(header), header.size_, buffer, PAGE_SIZE) ||
+      PageChecksum(buffer) != header.checksum_) {
+    return false;
+  }
+  memcpy(page_data, buffer, PAGE_SIZE);
+  SetPageCompressed(logical_page_id, true);
+  return true;
+}
+
+void DiskManager::SetPageCompressed(page_id_t logical_page_id, bool compressed) {
+  uint32_t extent_id = logical_page_id / BITMAP_SIZE;
+  if (logical_page_id < 0 || extent_id >= MAX_EXTENTS) return;
+  std::atomic<uint64_t> *bits = GetCompressedBits(extent_id, compressed);
+  if (bits == nullptr) return;
+  uint32_t page_offset = logical_page_id % BITMAP_SIZE;
+  if (compressed) {
+    bits[page_offset / 64].fetch_or(1ULL << (page_offset % 64), std::memory_order_relaxed);
+  } else {
+    bits[page_offset / 64].fetch_and(~(1ULL << (page_offset % 64)), std::memory_order_relaxed);
+  }
+}
+
+bool DiskManager::IsPageCompressed(page_id_t logical_page_id) {
+  uint32_t extent_id = logical_page_id / BITMAP_SIZE;
+  if (logical_page_id < 0 || extent_id >= MAX_EXTENTS) return false;
+  std::atomic<uint64_t> *bits = GetCompressedBits(extent_id, false);
+  uint32_t page_offset = logical_page_id % BITMAP_SIZE;
+  return bits != nullptr && (bits[page_offset / 64].load(std::memory_order_relaxed) >> (page_offset % 64)) & 1;
+}
+
+std::atomic<uint64_t> *DiskManager::GetCompressedBits(uint32_t extent_id, bool create) {
+  std::atomic<uint64_t> *bits = compressed_pages_[extent_id].load(std::memory_order_acquire);
+  if (bits != nullptr || !create) return bits;
+  // 读写页的线程不持有db_io_latch_，两个线程同时创建时只留下一个
+  auto *new_bits = new std::atomic<uint64_t>[BITMAP_SIZE / 64]();
+  if (compressed_pages_[extent_id].compare_exchange_strong(bits, new_bits, std::memory_order_acq_rel)) {
+    return new_bits;
+  }
+  delete[] new_bits;
+  return bits;
+}
+
+bool DiskManager::WriteCompressedPage(page_id_t logical_page_id, const char *page_data) {
+  if (read_only_) return false;
+  alignas(PAGE_SIZE) char buffer[PAGE_SIZE];
+  CompressedPageHeader header{COMPRESSED_PAGE_MAGIC, logical_page_id, 0, PageChecksum(page_data)};
+  // 至少要省下一个块才值得压缩
+  header.size_ = static_cast<uint32_t>(PageCompressor::Compress(
+      page_data, PAGE_SIZE, buffer + sizeof(header), PAGE_SIZE - COMPRESSED_BLOCK_SIZE - sizeof(header)));
+  if (header.size_ == 0) {
+    return false;
+  }
+  memcpy(buffer, &header, sizeof(header));
+  size_t stored =
+      (sizeof(header) + header.size_ + COMPRESSED_BLOCK_SIZE - 1) / COMPRESSED_BLOCK_SIZE * COMPRESSED_BLOCK_SIZE;
+  memset(buffer + sizeof(header) + header.size_, 0, stored - sizeof(header) - header.size_);
+  size_t offset = static_cast<size_t>(MapPageId(logical_page_id)) * PAGE_SIZE;
+  size_t end = offset + PAGE_SIZE;
+  // 页在文件末尾之后时先写最后一个块把文件撑到整页，映射和读都按整页算
+  if (end > file_size_.load(std::memory_order_acquire)) {
+    alignas(PAGE_SIZE) static const char zeros[COMPRESSED_BLOCK_SIZE] = {};
+    if (pwrite(fd_, zeros, COMPRESSED_BLOCK_SIZE, end - COMPRESSED_BLOCK_SIZE) != COMPRESSED_BLOCK_SIZE) {
+      return false;
+    }
+    GrowFileSize(end);
+  }
+  size_t written = 0;
+  while (written < stored) {
+    ssize_t rc = pwrite(fd_, buffer + written, stored - written, offset + written);
+    if (rc < 0 && errno == EINTR) continue;
+    // O_DIRECT不接受块大小的写等情况，退回到写整页
+    if (rc <= 0) return false;
+    written += rc;
+  }
+  // 剩下的部分打洞，不占磁盘空间；打不了洞也没关系，解压只看header里记录的长度
+#ifdef FALLOC_FL_PUNCH_HOLE
+  if (punch_holes_.load(std::memory_order_relaxed) &&
+      fallocate(fd_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset + stored, PAGE_SIZE - stored) != 0 &&
+      (errno == EOPNOTSUPP || errno == ENOSYS)) {
+    punch_holes_.store(false, std::memory_order_relaxed);
+  }
+#endif
+  return true;
+}
+
+size_t DiskManager::GetMappedPageCount() const {
+  // 减去meta page和已经开始的extent的bitmap页
+  size_t physical_pages = mapping_size_ / PAGE_SIZE;
+  return physical_pages <= 1 ? 0 : physical_pages - 1 - (physical_pages - 1 + BITMAP_SIZE) / (BITMAP_SIZE + 1);
 }
 
 /**
@@ -129,45 +567,146 @@ page_id_t DiskManager::MapPageId(page_id_t logical_page_id) {
   return logical_page_id/BITMAP_SIZE+2+logical_page_id;
 }
 
-int DiskManager::GetFileSize(const std::string &file_name) {
-  struct stat stat_buf;
-  int rc = stat(file_name.c_str(), &stat_buf);
-  return rc == 0 ? stat_buf.st_size : -1;
-}
-
-void DiskManager::ReadPhysicalPage(page_id_t physical_page_id, char *page_data) {
-  int offset = physical_page_id * PAGE_SIZE;
-  // check if read beyond file length
-  if (offset >= GetFileSize(file_name_)) {
-#ifdef ENABLE_BPM_DEBUG
-    LOG(INFO) << "Read less than a page" << std::endl;
-#endif
-    memset(page_data, 0, PAGE_SIZE);
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
+void DiskManager::ReadPhysicalPages(page_id_t first_physical_page_id, char *const *pages_data, size_t count) {
+  size_t offset = static_cast<size_t>(first_physical_page_id) * PAGE_SIZE;
+  // 文件大小缓存在内存中，超出文件末尾的部分直接填0
+  size_t file_size = file_size_.load(std::memory_order_acquire);
+  size_t readable = offset >= file_size ? 0 : std::min(count, (file_size - offset + PAGE_SIZE - 1) / PAGE_SIZE);
+  char *bounce = nullptr;
+  std::vector<iovec> iov(readable);
+  for (size_t i = 0; i < readable; i++) {
+    iov[i].iov_base = pages_data[i];
+    iov[i].iov_len = PAGE_SIZE;
+    if (direct_io_ && !IsAligned(pages_data[i])) {
+      if (bounce == nullptr) bounce = new (std::align_val_t(PAGE_SIZE)) char[readable * PAGE_SIZE];
+      iov[i].iov_base = bounce + i * PAGE_SIZE;
+    }
+  }
+  size_t read_count = 0;
+  while (read_count < readable * PAGE_SIZE) {
+    // 跳过已经读完的iovec，从断点继续读
+    size_t first = read_count / PAGE_SIZE;
+    size_t skip = read_count % PAGE_SIZE;
+    iov[first].iov_base = static_cast<char *>(iov[first].iov_base) + skip;
+    iov[first].iov_len -= skip;
+    ssize_t rc = preadv(fd_, iov.data() + first, std::min(readable - first, static_cast<size_t>(IOV_MAX)),
+                        offset + read_count);
+    iov[first].iov_base = static_cast<char *>(iov[first].iov_base) - skip;
+    iov[first].iov_len += skip;
+    if (rc < 0 && errno == EINTR) continue;
+    if (rc < 0) LOG(ERROR) << "I/O error while reading " << file_name_ << ": " << strerror(errno);
+    if (rc <= 0) break;
+    read_count += rc;
+  }
+  for (size_t i = 0; i < count; i++) {
+    if (i < readable && iov[i].iov_base != pages_data[i]) memcpy(pages_data[i], iov[i].iov_base, PAGE_SIZE);
+    // 文件在这一页之前就结束了
+    size_t page_begin = i * PAGE_SIZE;
+    if (read_count < page_begin + PAGE_SIZE) {
 #ifdef ENABLE_BPM_DEBUG
       LOG(INFO) << "Read less than a page" << std::endl;
 #endif
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+      size_t valid = read_count > page_begin ? read_count - page_begin : 0;
+      memset(pages_data[i] + valid, 0, PAGE_SIZE - valid);
     }
   }
+  operator delete[](bounce, std::align_val_t(PAGE_SIZE));
 }
 
-void DiskManager::WritePhysicalPage(page_id_t physical_page_id, const char *page_data) {
-  size_t offset = static_cast<size_t>(physical_page_id) * PAGE_SIZE;
-  // set write cursor to offset
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    LOG(ERROR) << "I/O error while writing";
+bool DiskManager::WritePhysicalPages(page_id_t first_physical_page_id, const char *const *pages_data, size_t count) {
+  if (read_only_) {
+    LOG(ERROR) << "Cannot write to " << file_name_ << ": it is opened read-only";
+    return false;
+  }
+  size_t offset = static_cast<size_t>(first_physical_page_id) * PAGE_SIZE;
+  char *bounce = nullptr;
+  std::vector<iovec> iov(count);
+  for (size_t i = 0; i < count; i++) {
+    iov[i].iov_base = const_cast<char *>(pages_data[i]);
+    iov[i].iov_len = PAGE_SIZE;
+    if (direct_io_ && !IsAligned(pages_data[i])) {
+      if (bounce == nullptr) bounce = new (std::align_val_t(PAGE_SIZE)) char[count * PAGE_SIZE];
+      memcpy(bounce + i * PAGE_SIZE, pages_data[i], PAGE_SIZE);
+      iov[i].iov_base = bounce + i * PAGE_SIZE;
+    }
+  }
+  size_t written = 0;
+  while (written < count * PAGE_SIZE) {
+    size_t first = written / PAGE_SIZE;
+    size_t skip = written % PAGE_SIZE;
+    iov[first].iov_base = static_cast<char *>(iov[first].iov_base) + skip;
+    iov[first].iov_len -= skip;
+    ssize_t rc =
+        pwritev(fd_, iov.data() + first, std::min(count - first, static_cast<size_t>(IOV_MAX)), offset + written);
+    iov[first].iov_base = static_cast<char *>(iov[first].iov_base) - skip;
+    iov[first].iov_len += skip;
+    if (rc < 0 && errno == EINTR) continue;
+    // check for I/O error
+    if (rc <= 0) {
+      LOG(ERROR) << "I/O error while writing " << file_name_ << ": " << strerror(errno);
+      break;
+    }
+    written += rc;
+  }
+  operator delete[](bounce, std::align_val_t(PAGE_SIZE));
+  GrowFileSize(offset + written);
+  return written == count * PAGE_SIZE;
+}
+
+void DiskManager::SubmitPhysicalPages(bool write, page_id_t first_physical_page_id, char *const *pages_data,
+                                      size_t count, std::function<void(bool ok)> done) {
+  size_t offset = static_cast<size_t>(first_physical_page_id) * PAGE_SIZE;
+  // O_DIRECT下不对齐的缓冲区要经过同步路径的bounce buffer；整段都在文件末尾之后的读也不必提交
+  bool synchronous = (write && read_only_) || (direct_io_ && !std::all_of(pages_data, pages_data + count, IsAligned));
+  if (synchronous || (!write && offset >= file_size_.load(std::memory_order_acquire))) {
+    bool ok = true;
+    if (write) {
+      ok = WritePhysicalPages(first_physical_page_id, pages_data, count);
+    } else {
+      ReadPhysicalPages(first_physical_page_id, pages_data, count);
+    }
+    done(ok);
     return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
-}
\ No newline at end of file
+  std::vector<iovec> iov(count);
+  for (size_t i = 0; i < count; i++) {
+    iov[i].iov_base = pages_data[i];
+    iov[i].iov_len = PAGE_SIZE;
+  }
+  std::vector<char *> pages(pages_data, pages_data + count);
+  GetAsyncIO()->Submit(write, iov.data(), static_cast<int>(count), offset,
+                       [this, write, offset, pages, done](ssize_t result) {
+                         size_t expected = pages.size() * PAGE_SIZE;
+                         size_t transferred = result > 0 ? static_cast<size_t>(result) : 0;
+                         // 引擎会读写到完成为止，写得不完整就是出错了，要告诉调用者页没有写下去
+                         bool ok = result >= 0 && (!write || transferred == expected);
+                         if (!ok) {
+                           LOG(ERROR) << "I/O error while " << (write ? "writing " : "reading ") << file_name_ << ": "
+                                      << (result < 0 ? strerror(-result) : "short write");
+                         }
+                         if (write) {
+                           GrowFileSize(offset + transferred);
+                         } else {
+                           // 文件提前结束的部分填0
+                           for (size_t i = 0; i < pages.size(); i++) {
+                             size_t page_begin = i * PAGE_SIZE;
+                             if (transferred >= page_begin + PAGE_SIZE) continue;
+                             size_t valid = transferred > page_begin ? transferred - page_begin : 0;
+                             memset(pages[i] + valid, 0, PAGE_SIZE - valid);
+                           }
+                         }
+                         done(ok);
+                       });
+}
+
+AsyncIO *DiskManager::GetAsyncIO() {
+  std::call_once(async_io_created_, [this] { async_io_ = AsyncIO::Create(fd_); });
+  return async_io_.get();
+}
+
+void DiskManager::GrowFileSize(size_t end) {
+  // 缓存的文件大小只会变大
+  size_t file_size = file_size_.load(std::memory_order_relaxed);
+  while (file_size < end && !file_size_.compare_exchange_weak(file_size, end, std::memory_order_release)) {
+  }
+}
@@ -0,0 +1,114 @@
+#include "storage/page_compressor.h"
+
+#include <cstring>
+
+static constexpr size_t MAX_OFFSET = 65535;
+
+static inline uint32_t Load32(const uint8_t *p) {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+/**
+ * 写一个长度的延续字节，value是超出15的部分
+ */
+static inline bool PutLength(size_t value, uint8_t *dst, size_t &op, size_t capacity) {
+  while (value >= 255) {
+    if (op >= capacity) return false;
+    dst[op++] = 255;
+    value -= 255;
+  }
+  if (op >= capacity) return false;
+  dst[op++] = static_cast<uint8_t>(value);
+  return true;
+}
+
+static inline bool GetLength(size_t &value, const uint8_t *src, size_t &ip, size_t size) {
+  uint8_t byte;
+  do {
+    if (ip >= size) return false;
+    byte = src[ip++];
+    value += byte;
+  } while (byte == 255);
+  return true;
+}
+
+/**
+ * 写一个token以及它的literal和match，match_len为0表示最后一个token
+ */
+static bool PutSequence(const uint8_t *literals, size_t literal_len, size_t offset, size_t match_len, uint8_t *dst,
+                        size_t &op, size_t capacity) {
+  size_t match_code = match_len == 0 ? 0 : match_len - PageCompressor::MIN_MATCH;
+  if (op >= capacity) return false;
+  dst[op++] = static_cast<uint8_t>((literal_len < 15 ? literal_len : 15) << 4 | (match_code < 15 ? match_code : 15));
+  if (literal_len >= 15 && !PutLength(literal_len - 15, dst, op, capacity)) return false;
+  if (literal_len > capacity - op) return false;
+  memcpy(dst + op, literals, literal_len);
+  op += literal_len;
+  if (match_len == 0) return true;
+  if (capacity - op < 2) return false;
+  dst[op++] = static_cast<uint8_t>(offset & 0xff);
+  dst[op++] = static_cast<uint8_t>(offset >> 8);
+  return match_code < 15 || PutLength(match_code - 15, dst, op, capacity);
+}
+
+size_t PageCompressor::Compress(const char *src, size_t size, char *dst, size_t capacity) {
+  auto *in = reinterpret_cast<const uint8_t *>(src);
+  auto *out = reinterpret_cast<uint8_t *>(dst);
+  // 哈希表记录每个4字节序列最近出现的位置+1，0表示没有出现过
+  uint32_t table[1 << HASH_BITS] = {};
+  size_t anchor = 0;
+  size_t pos = 0;
+  size_t op = 0;
+  while (pos + MIN_MATCH <= size) {
+    uint32_t sequence = Load32(in + pos);
+    uint32_t hash = (sequence * 2654435761U) >> (32 - HASH_BITS);
+    size_t candidate = table[hash];
+    table[hash] = static_cast<uint32_t>(pos + 1);
+    if (candidate == 0 || pos - (candidate - 1) > MAX_OFFSET || Load32(in + candidate - 1) != sequence) {
+      pos++;
+      continue;
+    }
+    candidate--;
+    size_t match_len = MIN_MATCH;
+    while (pos + match_len < size && in[candidate + match_len] == in[pos + match_len]) {
+      match_len++;
+    }
+    if (!PutSequence(in + anchor, pos - anchor, pos - candidate, match_len, out, op, capacity)) return 0;
+    pos += match_len;
+    anchor = pos;
+  }
+  if (!PutSequence(in + anchor, size - anchor, 0, 0, out, op, capacity)) return 0;
+  return op;
+}
+
+bool PageCompressor::Decompress(const char *src, size_t size, char *dst, size_t dst_size) {
+  auto *in = reinterpret_cast<const uint8_t *>(src);
+  auto *out = reinterpret_cast<uint8_t *>(dst);
+  size_t ip = 0;
+  size_t op = 0;
+  while (ip < size) {
+    uint8_t token = in[ip++];
+    size_t literal_len = token >> 4;
+    if (literal_len == 15 && !GetLength(literal_len, in, ip, size)) return false;
+    if (literal_len > size - ip || literal_len > dst_size - op) return false;
+    memcpy(out + op, in + ip, literal_len);
+    ip += literal_len;
+    op += literal_len;
+    // 最后一个token没有match
+    if (ip == size) break;
+    if (size - ip < 2) return false;
+    size_t offset = in[ip] | static_cast<size_t>(in[ip + 1]) << 8;
+    ip += 2;
+    size_t match_len = token & 15;
+    if (match_len == 15 && !GetLength(match_len, in, ip, size)) return false;
+    match_len += MIN_MATCH;
+    if (offset == 0 || offset > op || match_len > dst_size - op) return false;
+    // match可能和自己重叠（比如一串相同的字节），只能逐字节复制
+    for (size_t i = 0; i < match_len; i++, op++) {
+      out[op] = out[op - offset];
+    }
+  }
+  return op == dst_size;
+}
@@ -0,0 +1,98 @@
+#include "storage/parallel_table_scan.h"
+
+#include <algorithm>
+
+#include "storage/table_heap.h"
+#include "storage/table_scan_cursor.h"
+
+ParallelTableScan::ParallelTableScan(TableHeap *table_heap, Txn *txn, Filter filter, std::vector<uint32_t> column_ids,
+                                     size_t num_threads, std::shared_ptr<BufferAccessStrategy> strategy)
+    : table_heap_(table_heap),
+      txn_(txn),
+      filter_(std::move(filter)),
+      column_ids_(std::move(column_ids)),
+      strategy_(std::move(strategy)) {
+  // 按free space map里page的顺序切分，不需要沿着page链一页页找
+  std::vector<page_id_t> page_ids;
+  if (!table_heap_->GetPageIds(&page_ids)) {
+    // 读不到free space map，整张表作为一个morsel沿着page链扫
+    Morsel morsel;
+    morsel.first_page_id_ = table_heap_->GetFirstPageId();
+    morsel.end_page_id_ = INVALID_PAGE_ID;
+    morsels_.push_back(std::move(morsel));
+  }
+  for (size_t i = 0; i < page_ids.size(); i += PARALLEL_SCAN_MORSEL_PAGES) {
+    Morsel morsel;
+    morsel.first_page_id_ = page_ids[i];
+    morsel.end_page_id_ = i + PARALLEL_SCAN_MORSEL_PAGES < page_ids.size() ? page_ids[i + PARALLEL_SCAN_MORSEL_PAGES]
+                                                                           : INVALID_PAGE_ID;
+    morsels_.push_back(std::move(morsel));
+  }
+  num_threads = std::max(static_cast<size_t>(1), std::min(num_threads, morsels_.size()));
+  window_ = 2 * num_threads;
+  for (size_t i = 0; i < num_threads && !morsels_.empty(); i++) {
+    workers_.emplace_back(&ParallelTableScan::Work, this);
+  }
+}
+
+ParallelTableScan::~ParallelTableScan() {
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    stopped_ = true;
+  }
+  progress_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+void ParallelTableScan::Work() {
+  while (true) {
+    size_t index;
+    {
+      std::unique_lock<std::mutex> lock(latch_);
+      // 不能比正在返回的morsel领先太多，否则保留的行会越来越多
+      progress_.wait(lock, [&] { return stopped_ || next_morsel_ < current_morsel_ + window_; });
+      if (stopped_ || next_morsel_ >= morsels_.size()) return;
+      index = next_morsel_++;
+    }
+    Morsel &morsel = morsels_[index];
+    TableScanCursor cursor(table_heap_, txn_, morsel.first_page_id_, morsel.end_page_id_, strategy_);
+    while (cursor.Next()) {
+      const RowView &row = cursor.GetRow();
+      if (filter_ && !filter_(row)) continue;
+      morsel.rows_.emplace_back();
+      if (column_ids_.empty()) {
+        row.ToRow(&morsel.rows_.back());
+      } else {
+        row.ToRow(column_ids_, &morsel.rows_.back());
+      }
+    }
+    {
+      std::scoped_lock<std::mutex> lock(latch_);
+      morsel.done_ = true;
+    }
+    progress_.notify_all();
+  }
+}
+
+bool ParallelTableScan::Next(Row *row) {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (current_morsel_ < morsels_.size()) {
+    Morsel &morsel = morsels_[current_morsel_];
+    progress_.wait(lock, [&] { return morsel.done_; });
+    if (next_row_ < morsel.rows_.size()) {
+      // 这一行之后不会再用到，直接把field交给row，不用再拷贝一次
+      Row &next = morsel.rows_[next_row_++];
+      row->destroy();
+      row->GetFields().swap(next.GetFields());
+      row->SetRowId(next.GetRowId());
+      return true;
+    }
+    morsel.rows_.clear();
+    current_morsel_++;
+    next_row_ = 0;
+    progress_.notify_all();
+  }
+  return false;
+}
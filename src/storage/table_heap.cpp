@@ -1,57 +1,544 @@
 #include "storage/table_heap.h"
 
+#include <algorithm>
+
+#include "page/pax_page.h"
+
 /**
  * InsertTuple
  */
 bool TableHeap::InsertTuple(Row &row, Txn *txn) {
 	// 获得row序列化所需要的内存空间
 	uint32_t row_size = row.GetSerializedSize(schema_);
+	if (row_size <= ROW_INLINE_SIZE) return InsertStoredTuple(row, row_size, txn);
+	// 太长的行先把长的char值放到overflow page里，插入的是只带着overflow page的拷贝
+	Row stored_row;
+	if (!MoveToOverflow(row, &stored_row)) return false;
+	bool is_success = InsertStoredTuple(stored_row, stored_row.GetSerializedSize(schema_), txn);
+	if (is_success) {
+		row.SetRowId(stored_row.GetRowId());
+	} else {
+		FreeOverflow(stored_row);
+	}
+	return is_success;
+}
+
+bool TableHeap::InsertStoredTuple(Row &row, uint32_t row_size, Txn *txn) {
 	// 如果空间大于row类型支持的最大空间，一定不符合要求
 	if (row_size > TablePage::SIZE_MAX_ROW) return false;
 
-	bool is_success_insert = false;
-	// 定义两个page_id_t，用于循环迭代找到能存入row的page
-	page_id_t cur_page_id = first_page_id_, prev_page_id = INVALID_PAGE_ID;
-	TablePage *page = nullptr;
-	while (1) {
-		page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(cur_page_id));
-		// 想必对于page进行操作的时候都需要加上一个锁 ？？？
+	// 按free space map直接找一个放得下的page，不用从第一页开始一页一页地试
+	while (true) {
+		page_id_t page_id = FindPageWithSpace(row, row_size);
+		if (page_id == INVALID_PAGE_ID) break;
+		auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+		if (page == nullptr) return false;
 		page->WLatch();
 		bool is_success_insert = page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
+		uint32_t free_space = page->GetFreeSpaceForRow();
 		page->WUnlatch();
-		// 如果当前page有足够的空间，则一定会成功插入
-		if (is_success_insert) {
-			// fatch一个page的时候就会将这个页面暂时pin，但是我们对于这个page的使用已经结束
-			// 所以需要unpin，同时这个page已经被修改，所以is_dirty = true
-			buffer_pool_manager_->UnpinPage(cur_page_id, true);
-			return true;
-		}
-		buffer_pool_manager_->UnpinPage(cur_page_id, false);
-		prev_page_id = cur_page_id;
-		cur_page_id = page->GetNextPageId();
-		// 循环出口：table_heap中的当前所有page都无法满足空间需求
-		if (cur_page_id == INVALID_PAGE_ID) 
-			break;
+		buffer_pool_manager_->UnpinPage(page_id, is_success_insert);
+		// 插入成功时更新这一页的空间；失败说明别的线程先用掉了空间，记下实际的空间再找
+		UpdateFreeSpace(page_id, free_space);
+		if (is_success_insert) return true;
 	}
+	// 没有哪一页肯定放得下，放到最后一页或者新的一页
+	return InsertAtTail(row, txn);
+}
 
+bool TableHeap::InsertAtTail(Row &row, Txn *txn) {
+	// 持有fsm_latch_，两个线程不会同时在末尾加页
+	std::scoped_lock<std::mutex> lock(fsm_latch_);
+	if (!LoadFreeSpaceMap() || last_page_id_ == INVALID_PAGE_ID) return false;
+	page_id_t tail_page_id = last_page_id_;
+	auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(tail_page_id));
+	if (page == nullptr) return false;
+	page->WLatch();
+	if (page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_)) {
+		uint32_t free_space = page->GetFreeSpaceForRow();
+		page->WUnlatch();
+		buffer_pool_manager_->UnpinPage(tail_page_id, true);
+		RecordFreeSpace(tail_page_id, free_space);
+		return true;
+	}
 	// 申请一个新page，用于存放tuple
 	page_id_t new_page_id = INVALID_PAGE_ID;
-	TablePage *new_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(new_page_id));
+	auto new_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(new_page_id, &page_run_));
+	if (new_page == nullptr) {
+		page->WUnlatch();
+		buffer_pool_manager_->UnpinPage(tail_page_id, false);
+		return false;
+	}
 	new_page->WLatch();
-	// 新申请的page需要初始化
-	new_page->Init(new_page_id, INVALID_PAGE_ID, log_manager_, txn);
-	// 直接insert，无需担心失败
-	new_page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
+	// 新申请的page需要初始化，和最后一页用同样的格式
+	new_page->Init(new_page_id, INVALID_PAGE_ID, page->GetFormat(), schema_, log_manager_, txn);
+	// 行式的page一定放得下；PAX的page可能连一行都放不下，这时不接到链上
+	if (!new_page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_)) {
+		new_page->WUnlatch();
+		buffer_pool_manager_->UnpinPage(new_page_id, false);
+		buffer_pool_manager_->DeletePage(new_page_id);
+		page->WUnlatch();
+		buffer_pool_manager_->UnpinPage(tail_page_id, false);
+		return false;
+	}
+	uint32_t free_space = new_page->GetFreeSpaceForRow();
 	new_page->WUnlatch();
-	page->WLatch();
+	// 先在free space map里占好位置（可能要申请新的map页），成功了才接到链上，链和map才不会不一致
+	if (!AppendToFreeSpaceMap(new_page_id, free_space)) {
+		buffer_pool_manager_->UnpinPage(new_page_id, false);
+		buffer_pool_manager_->DeletePage(new_page_id);
+		page->WUnlatch();
+		buffer_pool_manager_->UnpinPage(tail_page_id, false);
+		return false;
+	}
 	// 将new_page加到堆表中
 	page->SetNextPageId(new_page_id);
 	page->WUnlatch();
+	buffer_pool_manager_->UnpinPage(tail_page_id, true);
 	// new的新的page初始时，pincount就是1，所以需要unpin一下
 	buffer_pool_manager_->UnpinPage(new_page_id, true);
 	return true;
 }
 
+bool TableHeap::InsertTuples(std::vector<Row> &rows, Txn *txn) {
+	// 每行只算一次序列化的大小；太长的行先把长的char值放到overflow page里，插入时换上只带着overflow page的field
+	std::vector<uint32_t> sizes(rows.size());
+	std::vector<size_t> moved;        // 换了field的行
+	std::vector<Row> original_rows;   // 这些行原来的field
+	original_rows.reserve(rows.size());
+	bool is_checked = true;
+	for (size_t i = 0; i < rows.size() && is_checked; i++) {
+		sizes[i] = rows[i].GetSerializedSize(schema_);
+		if (sizes[i] <= ROW_INLINE_SIZE) continue;
+		original_rows.emplace_back();
+		if (!MoveToOverflow(rows[i], &original_rows.back())) {
+			original_rows.pop_back();
+			is_checked = false;
+			break;
+		}
+		rows[i].GetFields().swap(original_rows.back().GetFields());
+		moved.push_back(i);
+		sizes[i] = rows[i].GetSerializedSize(schema_);
+		// 有一行太大就一行都不插入
+		is_checked = sizes[i] <= TablePage::SIZE_MAX_ROW;
+	}
+	bool is_success = is_checked && InsertStoredTuples(rows, sizes, txn);
+	// 换回原来的field，没插入的行也不再需要它的overflow page
+	for (size_t k = 0; k < moved.size(); k++) {
+		Row &row = rows[moved[k]];
+		row.GetFields().swap(original_rows[k].GetFields());
+		if (!is_checked || row.GetRowId().Get() == INVALID_ROWID.Get()) {
+			FreeOverflow(original_rows[k]);
+		}
+	}
+	return is_success;
+}
+
+bool TableHeap::InsertStoredTuples(std::vector<Row> &rows, const std::vector<uint32_t> &sizes, Txn *txn) {
+	if (rows.empty()) return true;
+	std::scoped_lock<std::mutex> lock(fsm_latch_);
+	if (!LoadFreeSpaceMap() || last_page_id_ == INVALID_PAGE_ID) return false;
+	page_id_t page_id = last_page_id_;
+	auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+	if (page == nullptr) return false;
+	page->WLatch();
+	// 先填满最后一页，再一页一页地接上新页，每一页只pin和加锁一次
+	size_t next = page->InsertTuples(rows, sizes, 0, schema_);
+	bool is_success = true;
+	while (next < rows.size()) {
+		page_id_t new_page_id = INVALID_PAGE_ID;
+		auto new_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(new_page_id, &page_run_));
+		if (new_page == nullptr) {
+			is_success = false;
+			break;
+		}
+		new_page->WLatch();
+		new_page->Init(new_page_id, INVALID_PAGE_ID, page->GetFormat(), schema_, log_manager_, txn);
+		size_t begin = next;
+		next = new_page->InsertTuples(rows, sizes, next, schema_);
+		if (next == begin) {
+			// 空的新页也放不下下一行
+			new_page->WUnlatch();
+			buffer_pool_manager_->UnpinPage(new_page_id, false);
+			buffer_pool_manager_->DeletePage(new_page_id);
+			is_success = false;
+			break;
+		}
+		// 新页填满了，先在free space map里记下，再接到链上，前一页这时才放开
+		if (!AppendToFreeSpaceMap(new_page_id, new_page->GetFreeSpaceForRow())) {
+			new_page->WUnlatch();
+			buffer_pool_manager_->UnpinPage(new_page_id, false);
+			buffer_pool_manager_->DeletePage(new_page_id);
+			next = begin;
+			is_success = false;
+			break;
+		}
+		page->SetNextPageId(new_page_id);
+		uint32_t free_space = page->GetFreeSpaceForRow();
+		page->WUnlatch();
+		buffer_pool_manager_->UnpinPage(page_id, true);
+		RecordFreeSpace(page_id, free_space);
+		page = new_page;
+		page_id = new_page_id;
+	}
+	uint32_t free_space = page->GetFreeSpaceForRow();
+	page->WUnlatch();
+	buffer_pool_manager_->UnpinPage(page_id, true);
+	RecordFreeSpace(page_id, free_space);
+	// 没插入的行不带rid
+	for (; next < rows.size(); next++) {
+		rows[next].SetRowId(INVALID_ROWID);
+	}
+	return is_success;
+}
+
+bool TableHeap::MoveToOverflow(const Row &row, Row *stored_row) {
+	// 从最长的char值开始移走，直到行不超过ROW_INLINE_SIZE；只留overflow page比原来短的值才值得移走
+	std::vector<uint32_t> candidates;
+	for (uint32_t i = 0; i < row.GetFieldCount(); i++) {
+		Field *field = row.GetField(i);
+		if (field->GetTypeId() == TypeId::kTypeChar && !field->IsNull() && !field->IsOverflow() &&
+				field->GetLength() > sizeof(page_id_t)) {
+			candidates.push_back(i);
+		}
+	}
+	std::sort(candidates.begin(), candidates.end(),
+						[&](uint32_t a, uint32_t b) { return row.GetField(a)->GetLength() > row.GetField(b)->GetLength(); });
+	uint32_t row_size = row.GetSerializedSize(schema_);
+	std::vector<bool> is_moved(row.GetFieldCount(), false);
+	for (auto i : candidates) {
+		if (row_size <= ROW_INLINE_SIZE) break;
+		is_moved[i] = true;
+		row_size -= row.GetField(i)->GetLength() - sizeof(page_id_t);
+	}
+	stored_row->destroy();
+	stored_row->SetRowId(row.GetRowId());
+	for (uint32_t i = 0; i < row.GetFieldCount(); i++) {
+		Field *field = row.GetField(i);
+		if (!is_moved[i]) {
+			stored_row->GetFields().push_back(new Field(*field));
+			continue;
+		}
+		page_id_t page_id = WriteOverflow(field->GetData(), field->GetLength());
+		if (page_id == INVALID_PAGE_ID) {
+			// 已经写好的overflow page也不要了
+			for (uint32_t j = 0; j < i; j++) {
+				if (is_moved[j]) FreeOverflow(stored_row->GetField(j)->GetOverflowPageId());
+			}
+			stored_row->destroy();
+			return false;
+		}
+		stored_row->GetFields().push_back(new Field(TypeId::kTypeChar, field->GetLength(), page_id));
+	}
+	return true;
+}
+
+page_id_t TableHeap::WriteOverflow(const char *data, uint32_t len) {
+	// 一页一页往后接，前一页等下一页申请到了才放开；overflow page不占用堆表预留的页
+	page_id_t first_page_id = INVALID_PAGE_ID;
+	page_id_t prev_page_id = INVALID_PAGE_ID;
+	OverflowPage *prev_page = nullptr;
+	for (uint32_t offset = 0; offset < len; offset += OverflowPage::CAPACITY) {
+		page_id_t page_id = INVALID_PAGE_ID;
+		Page *new_page = buffer_pool_manager_->NewPage(page_id);
+		if (new_page == nullptr) {
+			if (prev_page != nullptr) buffer_pool_manager_->UnpinPage(prev_page_id, true);
+			FreeOverflow(first_page_id);
+			return INVALID_PAGE_ID;
+		}
+		auto page = reinterpret_cast<OverflowPage *>(new_page->GetData());
+		uint32_t size = std::min(len - offset, OverflowPage::CAPACITY);
+		page->Init(INVALID_PAGE_ID, size);
+		memcpy(page->GetData(), data + offset, size);
+		if (prev_page != nullptr) {
+			prev_page->SetNextPageId(page_id);
+			buffer_pool_manager_->UnpinPage(prev_page_id, true);
+		} else {
+			first_page_id = page_id;
+		}
+		prev_page = page;
+		prev_page_id = page_id;
+	}
+	if (prev_page != nullptr) buffer_pool_manager_->UnpinPage(prev_page_id, true);
+	return first_page_id;
+}
+
+Field TableHeap::ReadOverflow(const Field &field) {
+	uint32_t len = field.GetLength();
+	std::vector<char> data(len);
+	uint32_t offset = 0;
+	for (page_id_t page_id = field.GetOverflowPageId(); page_id != INVALID_PAGE_ID && offset < len;) {
+		Page *page = buffer_pool_manager_->FetchPage(page_id);
+		ASSERT(page != nullptr, "Failed to fetch overflow page.");
+		auto overflow_page = reinterpret_cast<OverflowPage *>(page->GetData());
+		uint32_t size = std::min(overflow_page->GetSize(), len - offset);
+		memcpy(data.data() + offset, overflow_page->GetData(), size);
+		offset += size;
+		page_id_t next_page_id = overflow_page->GetNextPageId();
+		buffer_pool_manager_->UnpinPage(page_id, false);
+		page_id = next_page_id;
+	}
+	return Field(TypeId::kTypeChar, data.data(), len, true);
+}
+
+void TableHeap::ReadOverflow(Row *row) {
+	for (auto &field : row->GetFields()) {
+		if (!field->IsOverflow()) continue;
+		Field *value = new Field(ReadOverflow(*field));
+		delete field;
+		field = value;
+	}
+}
+
+void TableHeap::FreeOverflow(page_id_t page_id) {
+	while (page_id != INVALID_PAGE_ID) {
+		Page *page = buffer_pool_manager_->FetchPage(page_id);
+		if (page == nullptr) return;
+		page_id_t next_page_id = reinterpret_cast<OverflowPage *>(page->GetData())->GetNextPageId();
+		buffer_pool_manager_->UnpinPage(page_id, false);
+		buffer_pool_manager_->DeletePage(page_id);
+		page_id = next_page_id;
+	}
+}
+
+void TableHeap::FreeOverflow(const Row &row) {
+	for (uint32_t i = 0; i < row.GetFieldCount(); i++) {
+		if (row.GetField(i)->IsOverflow()) FreeOverflow(row.GetField(i)->GetOverflowPageId());
+	}
+}
+
+void TableHeap::FreeTupleOverflow(TablePage *page, const RowId &rid) {
+	if (!page->HasTuple(rid)) return;
+	RowView row = page->GetRowView(rid, schema_);
+	for (uint32_t i = 0; i < schema_->GetColumnCount(); i++) {
+		if (schema_->GetColumn(i)->GetType() != TypeId::kTypeChar || row.IsNull(i)) continue;
+		Field field = row.GetField(i);
+		if (field.IsOverflow()) FreeOverflow(field.GetOverflowPageId());
+	}
+}
+
+void TableHeap::FreePageOverflow(TablePage *page) {
+	// 没有char列的表不会有overflow page
+	bool has_char = false;
+	for (auto column : schema_->GetColumns()) {
+		has_char = has_char || column->GetType() == TypeId::kTypeChar;
+	}
+	if (!has_char) return;
+	RowId rid;
+	bool found = page->GetFirstTupleRid(&rid);
+	while (found) {
+		FreeTupleOverflow(page, rid);
+		RowId next_rid;
+		found = page->GetNextTupleRid(rid, &next_rid);
+		rid = next_rid;
+	}
+}
+
+bool TableHeap::LoadFreeSpaceMap() {
+	if (fsm_loaded_) return true;
+	auto first_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
+	if (first_page == nullptr) return false;
+	// 第一页没有前一页，prev page id记录的是free space map的第一页
+	page_id_t fsm_page_id = first_page->GetPrevPageId();
+	format_ = first_page->GetFormat();
+	buffer_pool_manager_->UnpinPage(first_page_id_, false);
+	if (fsm_page_id == INVALID_PAGE_ID) {
+		// 还没有free space map的旧表，沿着page链建一个
+		std::vector<std::pair<page_id_t, uint32_t>> heap_pages;
+		for (page_id_t page_id = first_page_id_; page_id != INVALID_PAGE_ID;) {
+			auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+			if (page == nullptr) return false;
+			page->RLatch();
+			heap_pages.emplace_back(page_id, page->GetFreeSpaceForRow());
+			page_id_t next_page_id = page->GetNextPageId();
+			page->RUnlatch();
+			buffer_pool_manager_->UnpinPage(page_id, false);
+			page_id = next_page_id;
+		}
+		for (auto &heap_page : heap_pages) {
+			if (!AppendToFreeSpaceMap(heap_page.first, heap_page.second)) {
+				// 建到一半失败了，删掉建好的部分，下次从头再建
+				ClearFreeSpaceMap();
+				return false;
+			}
+		}
+		fsm_loaded_ = true;
+		return true;
+	}
+	while (fsm_page_id != INVALID_PAGE_ID) {
+		Page *page = buffer_pool_manager_->FetchPage(fsm_page_id);
+		if (page == nullptr) {
+			// 只读了一部分，丢掉，下次重新读
+			ResetFreeSpaceMapCache();
+			return false;
+		}
+		auto fsm_page = reinterpret_cast<FreeSpaceMapPage *>(page->GetData());
+		for (uint32_t i = 0; i < fsm_page->GetCount(); i++) {
+			fsm_entries_[fsm_page->GetHeapPageId(i)] = fsm_pages_.size() * FreeSpaceMapPage::CAPACITY + i;
+			last_page_id_ = fsm_page->GetHeapPageId(i);
+		}
+		fsm_pages_.push_back(fsm_page_id);
+		fsm_max_class_.push_back(fsm_page->GetMaxClass());
+		page_id_t next_page_id = fsm_page->GetNextPageId();
+		buffer_pool_manager_->UnpinPage(fsm_page_id, false);
+		fsm_page_id = next_page_id;
+	}
+	fsm_loaded_ = true;
+	return true;
+}
+
+void TableHeap::ResetFreeSpaceMapCache() {
+	fsm_loaded_ = false;
+	fsm_pages_.clear();
+	fsm_max_class_.clear();
+	fsm_entries_.clear();
+	last_page_id_ = INVALID_PAGE_ID;
+}
+
+page_id_t TableHeap::FindPageWithSpace(const Row &row, uint32_t row_size) {
+	std::scoped_lock<std::mutex> lock(fsm_latch_);
+	if (!LoadFreeSpaceMap()) return INVALID_PAGE_ID;
+	// PAX page记的是空闲slot的宽度加上heap里的空间，要按这一行在PAX page里占的空间找
+	uint32_t size = format_ == TableFormat::kPaxFormat ? PaxPage::GetRowSize(row, schema_) : row_size;
+	uint32_t space_class = FreeSpaceMapPage::ClassFor(size);
+	if (space_class >= FreeSpaceMapPage::CLASS_COUNT) return INVALID_PAGE_ID;
+	// 先看内存里每个map页的最大class，只取可能有结果的map页
+	for (size_t i = 0; i < fsm_pages_.size(); i++) {
+		if (fsm_max_class_[i] < space_class) continue;
+		Page *page = buffer_pool_manager_->FetchPage(fsm_pages_[i]);
+		if (page == nullptr) return INVALID_PAGE_ID;
+		auto fsm_page = reinterpret_cast<FreeSpaceMapPage *>(page->GetData());
+		uint32_t index = fsm_page->FindPage(space_class);
+		page_id_t page_id = index < fsm_page->GetCount() ? fsm_page->GetHeapPageId(index) : INVALID_PAGE_ID;
+		buffer_pool_manager_->UnpinPage(fsm_pages_[i], false);
+		if (page_id != INVALID_PAGE_ID) return page_id;
+	}
+	return INVALID_PAGE_ID;
+}
+
+bool TableHeap::GetPageIds(std::vector<page_id_t> *page_ids) {
+	std::scoped_lock<std::mutex> lock(fsm_latch_);
+	page_ids->clear();
+	if (!LoadFreeSpaceMap()) return false;
+	// 按在map里的位置排序，就是page链的顺序
+	std::vector<std::pair<uint32_t, page_id_t>> entries;
+	entries.reserve(fsm_entries_.size());
+	for (auto &entry : fsm_entries_) {
+		entries.emplace_back(entry.second, entry.first);
+	}
+	std::sort(entries.begin(), entries.end());
+	for (auto &entry : entries) {
+		page_ids->push_back(entry.second);
+	}
+	return true;
+}
+
+void TableHeap::UpdateFreeSpace(page_id_t page_id, uint32_t free_space) {
+	std::scoped_lock<std::mutex> lock(fsm_latch_);
+	if (!LoadFreeSpaceMap()) return;
+	RecordFreeSpace(page_id, free_space);
+}
+
+void TableHeap::RecordFreeSpace(page_id_t page_id, uint32_t free_space) {
+	auto entry = fsm_entries_.find(page_id);
+	if (entry == fsm_entries_.end()) return;
+	uint32_t map_index = entry->second / FreeSpaceMapPage::CAPACITY;
+	uint32_t index = entry->second % FreeSpaceMapPage::CAPACITY;
+	uint8_t space_class = FreeSpaceMapPage::ToClass(free_space);
+	// 取不到map页就不记了，map里的空间只是提示，插入时会按实际的空间再修正
+	Page *page = buffer_pool_manager_->FetchPage(fsm_pages_[map_index]);
+	if (page == nullptr) return;
+	auto fsm_page = reinterpret_cast<FreeSpaceMapPage *>(page->GetData());
+	uint8_t old_class = fsm_page->GetClass(index);
+	if (old_class != space_class) {
+		fsm_page->SetClass(index, space_class);
+		// 最大的class变小了才需要重新算
+		if (space_class > fsm_max_class_[map_index]) {
+			fsm_max_class_[map_index] = space_class;
+		} else if (old_class == fsm_max_class_[map_index]) {
+			fsm_max_class_[map_index] = fsm_page->GetMaxClass();
+		}
+	}
+	buffer_pool_manager_->UnpinPage(fsm_pages_[map_index], old_class != space_class);
+}
+
+bool TableHeap::AppendToFreeSpaceMap(page_id_t page_id, uint32_t free_space) {
+	uint8_t space_class = FreeSpaceMapPage::ToClass(free_space);
+	FreeSpaceMapPage *fsm_page = nullptr;
+	if (!fsm_pages_.empty()) {
+		Page *page = buffer_pool_manager_->FetchPage(fsm_pages_.back());
+		if (page == nullptr) return false;
+		fsm_page = reinterpret_cast<FreeSpaceMapPage *>(page->GetData());
+	}
+	if (fsm_page == nullptr || fsm_page->IsFull()) {
+		// 最后一个map页满了，接上一个新的map页；map页不占用堆表预留的页
+		page_id_t new_fsm_page_id = INVALID_PAGE_ID;
+		Page *new_page = buffer_pool_manager_->NewPage(new_fsm_page_id);
+		if (new_page == nullptr) {
+			if (fsm_page != nullptr) buffer_pool_manager_->UnpinPage(fsm_pages_.back(), false);
+			return false;
+		}
+		auto new_fsm_page = reinterpret_cast<FreeSpaceMapPage *>(new_page->GetData());
+		new_fsm_page->Init();
+		if (fsm_page != nullptr) {
+			fsm_page->SetNextPageId(new_fsm_page_id);
+			buffer_pool_manager_->UnpinPage(fsm_pages_.back(), true);
+		} else {
+			auto first_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
+			if (first_page == nullptr) {
+				buffer_pool_manager_->UnpinPage(new_fsm_page_id, false);
+				buffer_pool_manager_->DeletePage(new_fsm_page_id);
+				return false;
+			}
+			first_page->WLatch();
+			first_page->SetPrevPageId(new_fsm_page_id);
+			first_page->WUnlatch();
+			buffer_pool_manager_->UnpinPage(first_page_id_, true);
+		}
+		fsm_pages_.push_back(new_fsm_page_id);
+		fsm_max_class_.push_back(0);
+		fsm_page = new_fsm_page;
+	}
+	fsm_entries_[page_id] = (fsm_pages_.size() - 1) * FreeSpaceMapPage::CAPACITY + fsm_page->GetCount();
+	fsm_page->Append(page_id, space_class);
+	fsm_max_class_.back() = std::max(fsm_max_class_.back(), space_class);
+	last_page_id_ = page_id;
+	buffer_pool_manager_->UnpinPage(fsm_pages_.back(), true);
+	return true;
+}
+
+void TableHeap::DeleteFreeSpaceMap() {
+	std::scoped_lock<std::mutex> lock(fsm_latch_);
+	ClearFreeSpaceMap();
+}
+
+void TableHeap::ClearFreeSpaceMap() {
+	auto first_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
+	if (first_page == nullptr) return;
+	page_id_t fsm_page_id = first_page->GetPrevPageId();
+	first_page->SetPrevPageId(INVALID_PAGE_ID);
+	buffer_pool_manager_->UnpinPage(first_page_id_, true);
+	while (fsm_page_id != INVALID_PAGE_ID) {
+		Page *page = buffer_pool_manager_->FetchPage(fsm_page_id);
+		if (page == nullptr) break;
+		page_id_t next_page_id = reinterpret_cast<FreeSpaceMapPage *>(page->GetData())->GetNextPageId();
+		buffer_pool_manager_->UnpinPage(fsm_page_id, false);
+		buffer_pool_manager_->DeletePage(fsm_page_id);
+		fsm_page_id = next_page_id;
+	}
+	ResetFreeSpaceMapCache();
+}
+
+TableFormat TableHeap::GetFormat() {
+	auto first_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
+	if (first_page == nullptr) return TableFormat::kRowFormat;
+	first_page->RLatch();
+	TableFormat format = first_page->GetFormat();
+	first_page->RUnlatch();
+	buffer_pool_manager_->UnpinPage(first_page_id_, false);
+	return format;
+}
+
 bool TableHeap::MarkDelete(const RowId &rid, Txn *txn) {
   // Find the page which contains the tuple.
   auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
@@ -71,29 +558,47 @@ bool TableHeap::MarkDelete(const RowId &rid, Txn *txn) {
  * TODO: Student Implement
  */
 bool TableHeap::UpdateTuple(Row &row, const RowId &rid, Txn *txn) {
+	// 新的行太长时，和插入一样先把长的char值放到overflow page里
+	Row stored_row;
+	Row *new_row = &row;
+	if (row.GetSerializedSize(schema_) > ROW_INLINE_SIZE) {
+		if (!MoveToOverflow(row, &stored_row)) return false;
+		new_row = &stored_row;
+	}
 	// 获得待更新的tuple所在的page
 	auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
   if (page == nullptr) {
+		FreeOverflow(stored_row);
     return false;
   }
-	Row *old_row = new Row(rid);
-	this->GetTuple(old_row, txn);
+	// page会把旧的行读到old_row里，旧的char值在overflow page里时只带着overflow page
+	Row old_row(rid);
   page->WLatch();
-	int state = page->UpdateTuple(row, old_row, schema_, txn, lock_manager_, log_manager_);
+	int state = page->UpdateTuple(*new_row, &old_row, schema_, txn, lock_manager_, log_manager_);
+	uint32_t free_space = page->GetFreeSpaceForRow();
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
-	delete old_row;
-	if (state == 2) return false;
+	if (state == 2) {
+		FreeOverflow(stored_row);
+		return false;
+	}
 	else if (state == 0) {
+		UpdateFreeSpace(rid.GetPageId(), free_space);
+		// 旧的值已经被替换掉了，它们的overflow page也不再需要
+		FreeOverflow(old_row);
 		row.SetRowId(rid);
 		return true;
 	}
 	else { // 当前page存不下
 		ApplyDelete(rid, txn); // 先delete
-    InsertTuple(row, txn); // 再insert
+		// 再insert，overflow page已经写好了
+		if (!InsertStoredTuple(*new_row, new_row->GetSerializedSize(schema_), txn)) {
+			FreeOverflow(stored_row);
+			return false;
+		}
+		row.SetRowId(new_row->GetRowId());
 		return true;
 	}
-
 }
 
 /**
@@ -105,10 +610,15 @@ void TableHeap::ApplyDelete(const RowId &rid, Txn *txn) {
 	auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
   assert(page != nullptr);
   page->WLatch();
+	// 行放在overflow page里的值和行一起删掉
+	FreeTupleOverflow(page, rid);
   page->ApplyDelete(rid, txn, log_manager_);
+	uint32_t free_space = page->GetFreeSpaceForRow();
   page->WUnlatch();
 	// 修改page，是脏页
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+	// 删掉的tuple腾出了空间
+  UpdateFreeSpace(rid.GetPageId(), free_space);
 }
 
 void TableHeap::RollbackDelete(const RowId &rid, Txn *txn) {
@@ -136,37 +646,55 @@ bool TableHeap::GetTuple(Row *row, Txn *txn) {
   bool is_success = page->GetTuple(row, schema_, txn, lock_manager_);
 	page->RUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), false);
+	// 放在overflow page里的值读回来，返回完整的行
+	if (is_success) ReadOverflow(row);
   return is_success;
 }
 
 void TableHeap::DeleteTable(page_id_t page_id) {
   if (page_id != INVALID_PAGE_ID) {
     auto temp_table_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));  // 删除table_heap
+    FreePageOverflow(temp_table_page);  // 行放在overflow page里的值也删掉
     if (temp_table_page->GetNextPageId() != INVALID_PAGE_ID)
       DeleteTable(temp_table_page->GetNextPageId());
     buffer_pool_manager_->UnpinPage(page_id, false);
     buffer_pool_manager_->DeletePage(page_id);
   } else {
+    DeleteFreeSpaceMap();
     DeleteTable(first_page_id_);
+    buffer_pool_manager_->ReleasePageRun(&page_run_);
   }
 }
 
 /**
  * 获得这个堆表中的第一个tuple的迭代器
  */
-TableIterator TableHeap::Begin(Txn *txn) { 
-	if (first_page_id_ != INVALID_PAGE_ID) {
-		TablePage *page = reinterpret_cast<TablePage*>(buffer_pool_manager_->FetchPage(first_page_id_));
-		if (page == nullptr) return End(); // 如果page无效，就返回一个无效迭代器
-		RowId *first_row_id = new RowId();
-		buffer_pool_manager_->UnpinPage(first_page_id_, false);
-		if (page->GetFirstTupleRid(first_row_id)) {
-			return TableIterator(this, *first_row_id, txn);
-		} else {
-			return End(); // 如果获得失败，就返回一个无效迭代器
-		}
-	}
-	return End(); // 如果first_page_id无效，就返回一个无效迭代器
+TableIterator TableHeap::Begin(Txn *txn, std::shared_ptr<BufferAccessStrategy> strategy) {
+  // 第一页可能是空的（tuple都被删掉了），需要沿着链表找到第一个有效的tuple
+  page_id_t page_id = first_page_id_;
+  RowId first_row_id;
+  while (page_id != INVALID_PAGE_ID) {
+    TablePage *page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id, strategy.get()));
+    if (page == nullptr) return End();  // 如果page无效，就返回一个无效迭代器
+    page->RLatch();
+    bool found = page->GetFirstTupleRid(&first_row_id);
+    page_id_t next_page_id = page->GetNextPageId();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    if (found) {
+      ReadAhead(next_page_id, strategy);
+      return TableIterator(this, first_row_id, txn, strategy);
+    }
+    page_id = next_page_id;
+  }
+  return End();  // 如果获得失败，就返回一个无效迭代器
+}
+
+void TableHeap::ReadAhead(page_id_t page_id, std::shared_ptr<BufferAccessStrategy> strategy) {
+  if (page_id == INVALID_PAGE_ID) return;
+  buffer_pool_manager_->PrefetchPageChain(
+      page_id, TABLE_READ_AHEAD_PAGES, [](Page *page) { return reinterpret_cast<TablePage *>(page)->GetNextPageId(); },
+      std::move(strategy));
 }
 
 /**
@@ -12,7 +12,8 @@ TableIterator是什么 : 堆表的迭代器
 /**
  * TODO: Student Implement
  */
-TableIterator::TableIterator(TableHeap *table_heap, RowId rid, Txn *txn) {
+TableIterator::TableIterator(TableHeap *table_heap, RowId rid, Txn *txn, std::shared_ptr<BufferAccessStrategy> strategy)
+    : strategy(std::move(strategy)) {
 	this->table_heap = table_heap;
   if (rid.GetPageId() != INVALID_PAGE_ID) {
     this->row=new Row(rid);
@@ -21,6 +22,7 @@ TableIterator::TableIterator(TableHeap *table_heap, RowId rid, Txn *txn) {
 		this->row=new Row(INVALID_ROWID);
 	} 
 	this->txn = txn;
+	this->read_ahead_countdown = TABLE_READ_AHEAD_PAGES / 2;
 }
 
 // 构造函数，参数是另一个迭代器
@@ -28,6 +30,8 @@ TableIterator::TableIterator(const TableIterator &other) {
 	this->row = new Row(*(other.row)); // deep copy
 	this->table_heap = other.table_heap;
 	this->txn = other.txn;
+	this->read_ahead_countdown = other.read_ahead_countdown;
+	this->strategy = other.strategy;
 }
 
 TableIterator::~TableIterator() {
@@ -56,9 +60,13 @@ Row *TableIterator::operator->() {
 
 TableIterator &TableIterator::operator=(const TableIterator &itr) noexcept {
 //  ASSERT(false, "Not implemented yet.");
+  if (this == &itr) return *this;
   this->table_heap = itr.table_heap;
+  delete this->row;
   this->row= new Row(*itr.row);
 	this->txn = itr.txn;
+	this->read_ahead_countdown = itr.read_ahead_countdown;
+	this->strategy = itr.strategy;
 	return *this;
 }
 
@@ -67,29 +75,41 @@ TableIterator &TableIterator::operator=(const TableIterator &itr) noexcept {
 TableIterator &TableIterator::operator++() {
 	// ++iter：iter变成下一个，并返回下一个
 	BufferPoolManager* buffer_pool_manager = this->table_heap->buffer_pool_manager_;
-	TablePage* page = reinterpret_cast<TablePage*>(buffer_pool_manager->FetchPage(this->row->GetRowId().GetPageId()));
-	RowId *next_row_id = new RowId();
+	page_id_t page_id = this->row->GetRowId().GetPageId();
+	TablePage* page = reinterpret_cast<TablePage*>(buffer_pool_manager->FetchPage(page_id, strategy.get()));
+	RowId next_row_id;
 	// 尝试从当前page获得下一个tuple的id
-	bool flag = page->GetNextTupleRid(row->GetRowId(), next_row_id);
-	delete row; // 即时释放不需要的空间
-  if (flag) { // 下一个tuple就在当前page
-    this->row = new Row(*next_row_id);
-    page->GetTuple(this->row, this->table_heap->schema_, this->txn, this->table_heap->lock_manager_);
-  } else { // 当前page没有下一个tuple
-		// 如果不在当前page，就在下一个page
-    page_id_t next_page_id = page->GetNextPageId();
-    page = reinterpret_cast<TablePage *>(buffer_pool_manager->FetchPage(next_page_id));
+	page->RLatch();
+	bool flag = page->GetNextTupleRid(row->GetRowId(), &next_row_id);
+	while (!flag) {
+		// 当前page没有下一个tuple，就去下一个page找，空的page直接跳过
+		page_id_t next_page_id = page->GetNextPageId();
+		page->RUnlatch();
+		buffer_pool_manager->UnpinPage(page_id, false);
+		page = next_page_id == INVALID_PAGE_ID
+		           ? nullptr
+		           : reinterpret_cast<TablePage *>(buffer_pool_manager->FetchPage(next_page_id, strategy.get()));
 		if (page == nullptr) {
-			next_row_id->Set(INVALID_PAGE_ID, 0);
-			this->row = new Row(*next_row_id);
+			// 已经到了堆表的末尾，变成End()
+			delete row;
+			this->row = new Row(INVALID_ROWID);
 			this->table_heap = nullptr;
-		} else {
-			page->GetFirstTupleRid(next_row_id);
-			this->row = new Row(*next_row_id);
-			page->GetTuple(this->row, this->table_heap->schema_, this->txn, this->table_heap->lock_manager_);
+			return *this;
+		}
+		page_id = next_page_id;
+		page->RLatch();
+		flag = page->GetFirstTupleRid(&next_row_id);
+		// 进入了新的page，预读已经用掉一半时继续向后预读
+		if (--read_ahead_countdown == 0) {
+			read_ahead_countdown = TABLE_READ_AHEAD_PAGES / 2;
+			this->table_heap->ReadAhead(page->GetNextPageId(), strategy);
 		}
-  }
-	delete next_row_id;
+	}
+	delete row; // 即时释放不需要的空间
+	this->row = new Row(next_row_id);
+	page->GetTuple(this->row, this->table_heap->schema_, this->txn, this->table_heap->lock_manager_);
+	page->RUnlatch();
+	buffer_pool_manager->UnpinPage(page_id, false);
   return *this;
 }
 
@@ -100,5 +120,5 @@ TableIterator TableIterator::operator++(int) {
 	RowId row_id = this->row->GetRowId();
 	TableHeap* tmp_table_heap = this->table_heap;
 	++(*this);
-	return TableIterator(tmp_table_heap, row_id, this->txn); 
+	return TableIterator(tmp_table_heap, row_id, this->txn, strategy);
 }
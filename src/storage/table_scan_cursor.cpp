@@ -0,0 +1,76 @@
+#include "storage/table_scan_cursor.h"
+
+#include "storage/table_heap.h"
+
+TableScanCursor::TableScanCursor(TableHeap *table_heap, Txn *txn, std::shared_ptr<BufferAccessStrategy> strategy)
+    : TableScanCursor(table_heap, txn, table_heap->GetFirstPageId(), INVALID_PAGE_ID, std::move(strategy)) {}
+
+TableScanCursor::TableScanCursor(TableHeap *table_heap, Txn *txn, page_id_t first_page_id, page_id_t end_page_id,
+                                 std::shared_ptr<BufferAccessStrategy> strategy)
+    : table_heap_(table_heap),
+      txn_(txn),
+      strategy_(std::move(strategy)),
+      first_page_id_(first_page_id),
+      end_page_id_(end_page_id),
+      read_ahead_countdown_(TABLE_READ_AHEAD_PAGES / 2) {}
+
+TableScanCursor::~TableScanCursor() { MoveToPage(INVALID_PAGE_ID); }
+
+bool TableScanCursor::MoveToPage(page_id_t page_id) {
+  BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
+  Release();
+  if (page_ != nullptr) {
+    buffer_pool_manager->UnpinPage(page_->GetTablePageId(), false);
+    page_ = nullptr;
+  }
+  // 走到范围的末尾就停下
+  if (page_id != INVALID_PAGE_ID && page_id != end_page_id_) {
+    page_ = reinterpret_cast<TablePage *>(buffer_pool_manager->FetchPage(page_id, strategy_.get()));
+  }
+  finished_ = page_ == nullptr;
+  return !finished_;
+}
+
+void TableScanCursor::Release() {
+  if (!latched_) return;
+  page_->RUnlatch();
+  latched_ = false;
+}
+
+bool TableScanCursor::Next() {
+  if (finished_) return false;
+  RowId next_rid;
+  bool found;
+  if (!started_) {
+    started_ = true;
+    if (!MoveToPage(first_page_id_)) return false;
+    page_->RLatch();
+    latched_ = true;
+    found = page_->GetFirstTupleRid(&next_rid);
+    table_heap_->ReadAhead(page_->GetNextPageId(), strategy_);
+  } else {
+    // 上一行返回之后latch一直没有放开的话，直接接着找
+    if (!latched_) {
+      page_->RLatch();
+      latched_ = true;
+    }
+    found = page_->GetNextTupleRid(row_.GetRowId(), &next_rid);
+  }
+  // 当前page没有下一个tuple，就去下一个page找，空的page直接跳过
+  while (!found) {
+    page_id_t next_page_id = page_->GetNextPageId();
+    if (!MoveToPage(next_page_id)) return false;
+    page_->RLatch();
+    latched_ = true;
+    found = page_->GetFirstTupleRid(&next_rid);
+    // 进入了新的page，预读已经用掉一半时继续向后预读
+    if (--read_ahead_countdown_ == 0) {
+      read_ahead_countdown_ = TABLE_READ_AHEAD_PAGES / 2;
+      table_heap_->ReadAhead(page_->GetNextPageId(), strategy_);
+    }
+  }
+  row_ = page_->GetRowView(next_rid, table_heap_->schema_);
+  row_.SetTableHeap(table_heap_);
+  // 调用者读RowView的时候还持有latch，写者不会把这一行移走或者改写
+  return true;
+}
@@ -1,8 +1,12 @@
 #include "buffer/buffer_pool_manager.h"
 
+#include <chrono>
 #include <cstdio>
 #include <random>
+#include <set>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -71,4 +75,434 @@ TEST(BufferPoolManagerTest, BinaryDataTest) {
 
   delete bpm;
   delete disk_manager;
-}
\ No newline at end of file
+}
+
+TEST(BufferPoolManagerTest, ConcurrentFetchTest) {
+  const std::string db_name = "bpm_concurrent_test.db";
+  const size_t buffer_pool_size = 256;
+  const size_t num_instances = 8;
+  const int num_pages = 512;  // twice the pool size, so every thread also triggers evictions
+  const int ops_per_thread = 20000;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, num_instances);
+
+  // Scenario: every page remembers its own page id, so a thread can detect frames that were mixed up.
+  for (int i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    ASSERT_EQ(i, page_id);
+    memcpy(page->GetData(), &page_id, sizeof(page_id_t));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: fetch, verify and unpin random pages from more and more threads.
+  for (int num_threads = 1; num_threads <= 8; num_threads *= 2) {
+    std::vector<std::thread> threads;
+    std::vector<int> errors(num_threads, 0);
+    for (int t = 0; t < num_threads; t++) {
+      threads.emplace_back([&, t] {
+        std::default_random_engine rng(t);
+        std::uniform_int_distribution<page_id_t> page_dist(0, num_pages - 1);
+        for (int i = 0; i < ops_per_thread; i++) {
+          page_id_t page_id = page_dist(rng);
+          auto *page = bpm->FetchPage(page_id);
+          if (page == nullptr) {
+            errors[t]++;
+            continue;
+          }
+          page->RLatch();
+          if (*reinterpret_cast<page_id_t *>(page->GetData()) != page_id) errors[t]++;
+          page->RUnlatch();
+          if (!bpm->UnpinPage(page_id, false)) errors[t]++;
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    for (int t = 0; t < num_threads; t++) {
+      EXPECT_EQ(0, errors[t]);
+    }
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  // Scenario: the page contents survive the evictions and write-backs done by the threads.
+  for (page_id_t i = 0; i < num_pages; i++) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, *reinterpret_cast<page_id_t *>(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+
+  delete bpm;
+  disk_manager->Close();
+  remove(db_name.c_str());
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerTest, PageCleanerTest) {
+  const std::string db_name = "bpm_cleaner_test.db";
+  const size_t buffer_pool_size = 64;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Scenario: fill the pool with dirty, unpinned pages.
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    memcpy(page->GetData(), &page_id, sizeof(page_id_t));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: the cleaner writes all of them back on its own.
+  bpm->StartPageCleaner(1.0);
+  for (int i = 0; i < 200 && bpm->GetPageCleanerStats().pages_written_ < buffer_pool_size; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  bpm->StopPageCleaner();
+  EXPECT_EQ(buffer_pool_size, bpm->GetPageCleanerStats().pages_written_);
+
+  // Scenario: new pages now evict clean victims, so no eviction writes in the foreground.
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    memcpy(page->GetData(), &page_id, sizeof(page_id_t));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  PageCleanerStats stats = bpm->GetPageCleanerStats();
+  EXPECT_EQ(buffer_pool_size, stats.stalls_avoided_);
+  EXPECT_EQ(0, stats.sync_writes_);
+
+  // Scenario: keep dirtying pages while the cleaner runs; nothing may be lost or written out of order.
+  bpm->StartPageCleaner(0.5);
+  for (int round = 0; round < 20; round++) {
+    for (page_id_t i = 0; i < static_cast<page_id_t>(2 * buffer_pool_size); i++) {
+      auto *page = bpm->FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      int32_t value = i + round * 1000;
+      memcpy(page->GetData(), &value, sizeof(int32_t));
+      ASSERT_TRUE(bpm->UnpinPage(i, true));
+    }
+  }
+  bpm->StopPageCleaner();
+  for (page_id_t i = 0; i < static_cast<page_id_t>(2 * buffer_pool_size); i++) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i + 19 * 1000, *reinterpret_cast<int32_t *>(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+
+  delete bpm;
+  disk_manager->Close();
+  remove(db_name.c_str());
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerTest, FrameAlignmentTest) {
+  const std::string db_name = "bpm_alignment_test.db";
+  const size_t buffer_pool_size = 1024;  // large enough for the shard arenas to use huge pages
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 2);
+
+  // Scenario: every frame is PAGE_SIZE aligned, so it can be read and written with O_DIRECT.
+  std::set<char *> frames;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(page->GetData()) % PAGE_SIZE);
+    EXPECT_TRUE(frames.insert(page->GetData()).second);
+    memcpy(page->GetData() + PAGE_SIZE - sizeof(page_id_t), &page_id, sizeof(page_id_t));
+  }
+  for (page_id_t i = 0; i < static_cast<page_id_t>(buffer_pool_size); i++) {
+    EXPECT_TRUE(bpm->UnpinPage(i, true));
+  }
+
+  // Scenario: frames do not overlap, the last bytes of every page survive.
+  for (page_id_t i = 0; i < static_cast<page_id_t>(buffer_pool_size); i++) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, *reinterpret_cast<page_id_t *>(page->GetData() + PAGE_SIZE - sizeof(page_id_t)));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+
+  delete bpm;
+  disk_manager->Close();
+  remove(db_name.c_str());
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerTest, StatsTest) {
+  const std::string db_name = "bpm_stats_test.db";
+  const size_t buffer_pool_size = 4;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Scenario: fill the pool, every new page is pinned.
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(page_id));
+  }
+  BufferPoolStats stats = bpm->GetStats();
+  EXPECT_EQ(buffer_pool_size, stats.new_pages_);
+  EXPECT_EQ(buffer_pool_size, stats.pinned_frames_);
+
+  // Scenario: the pool is full of pinned pages, a new page has to wait.
+  page_id_t page_id;
+  EXPECT_EQ(nullptr, bpm->NewPage(page_id));
+  EXPECT_EQ(1, bpm->GetStats().pin_waits_);
+
+  // Scenario: fetching a resident page is a hit, pinning it twice keeps one pinned frame.
+  ASSERT_NE(nullptr, bpm->FetchPage(0));
+  stats = bpm->GetStats();
+  EXPECT_EQ(1, stats.fetch_hits_);
+  EXPECT_EQ(buffer_pool_size, stats.pinned_frames_);
+  for (page_id_t i = 0; i < static_cast<page_id_t>(buffer_pool_size); i++) {
+    EXPECT_TRUE(bpm->UnpinPage(i, true));
+  }
+  EXPECT_TRUE(bpm->UnpinPage(0, false));
+  EXPECT_EQ(0, bpm->GetStats().pinned_frames_);
+
+  // Scenario: a new page evicts a dirty page, fetching it back is a miss that evicts another one.
+  ASSERT_NE(nullptr, bpm->NewPage(page_id));
+  EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  ASSERT_NE(nullptr, bpm->FetchPage(1));
+  EXPECT_TRUE(bpm->UnpinPage(1, false));
+  stats = bpm->GetStats();
+  EXPECT_EQ(1, stats.fetch_misses_);
+  EXPECT_EQ(2, stats.evictions_);
+  EXPECT_EQ(2, stats.dirty_writebacks_);
+  EXPECT_DOUBLE_EQ(0.5, stats.HitRatio());
+
+  delete bpm;
+  disk_manager->Close();
+  remove(db_name.c_str());
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerTest, AccessStrategyTest) {
+  const std::string db_name = "bpm_strategy_test.db";
+  const size_t buffer_pool_size = 64;
+  const int num_hot_pages = 32;
+  const int num_scan_pages = 256;
+  const size_t ring_size = 8;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 2);
+  for (int i = 0; i < num_hot_pages + num_scan_pages; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    memcpy(page->GetData(), &page_id, sizeof(page_id_t));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  auto touch_hot_pages = [&] {
+    for (page_id_t i = 0; i < num_hot_pages; i++) {
+      ASSERT_NE(nullptr, bpm->FetchPage(i));
+      ASSERT_TRUE(bpm->UnpinPage(i, false));
+    }
+  };
+  auto scan = [&](BufferAccessStrategy *strategy) {
+    for (page_id_t i = num_hot_pages; i < num_hot_pages + num_scan_pages; i++) {
+      auto *page = bpm->FetchPage(i, strategy);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(i, *reinterpret_cast<page_id_t *>(page->GetData()));
+      ASSERT_TRUE(bpm->UnpinPage(i, false));
+    }
+  };
+
+  // Scenario: a scan through a ring recycles its own frames, the hot pages stay resident.
+  touch_hot_pages();
+  auto strategy = bpm->GetAccessStrategy(ring_size);
+  scan(strategy.get());
+  size_t misses = bpm->GetStats().fetch_misses_;
+  touch_hot_pages();
+  EXPECT_EQ(misses, bpm->GetStats().fetch_misses_);
+
+  // Scenario: the same scan without a ring flushes the hot pages out of the pool.
+  scan(nullptr);
+  misses = bpm->GetStats().fetch_misses_;
+  touch_hot_pages();
+  EXPECT_EQ(misses + num_hot_pages, bpm->GetStats().fetch_misses_);
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  disk_manager->Close();
+  remove(db_name.c_str());
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerTest, WarmUpTest) {
+  const std::string db_name = "bpm_warm_up_test.db";
+  const std::string warm_up_file = "bpm_warm_up_test.warmup";
+  const size_t buffer_pool_size = 16;
+  const int num_pages = 64;
+
+  remove(db_name.c_str());
+  remove(warm_up_file.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 2);
+  for (int i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  // Scenario: pages 48..63 stay resident, 50..57 are the hottest of them.
+  for (int round = 0; round < 3; round++) {
+    for (page_id_t page_id = 50; page_id < 58; page_id++) {
+      ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+      EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+  }
+  ASSERT_TRUE(bpm->SaveWarmUpFile(warm_up_file));
+  delete bpm;
+
+  // Scenario: a pool half as large restores the hottest pages only, without a single foreground miss.
+  bpm = new BufferPoolManager(buffer_pool_size / 2, disk_manager, 2);
+  bpm->StartWarmUp(warm_up_file);
+  while (!bpm->GetWarmUpStats().finished_) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  WarmUpStats warm_up = bpm->GetWarmUpStats();
+  EXPECT_EQ(buffer_pool_size, warm_up.pages_listed_);
+  EXPECT_EQ(buffer_pool_size / 2, warm_up.pages_restored_);
+  EXPECT_DOUBLE_EQ(0.5, warm_up.RestoredRatio());
+  for (page_id_t page_id = 50; page_id < 58; page_id++) {
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  BufferPoolStats stats = bpm->GetStats();
+  EXPECT_EQ(8, stats.fetch_hits_);
+  EXPECT_EQ(0, stats.fetch_misses_);
+  delete bpm;
+
+  // Scenario: without a warm-up file the warm-up finishes right away.
+  remove(warm_up_file.c_str());
+  bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 2);
+  bpm->StartWarmUp(warm_up_file);
+  while (!bpm->GetWarmUpStats().finished_) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(0, bpm->GetWarmUpStats().pages_listed_);
+  delete bpm;
+
+  disk_manager->Close();
+  remove(db_name.c_str());
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerTest, ResizeTest) {
+  const std::string db_name = "bpm_resize_test.db";
+  const size_t buffer_pool_size = 16;
+  const size_t grown_size = 2 * BUFFER_POOL_CHUNK_SIZE + 100;  // the shards need a second chunk
+  const int num_pages = 64;
+
+  for (auto replacer_type : {ReplacerType::kLRU, ReplacerType::kLRUK, ReplacerType::kClock}) {
+    remove(db_name.c_str());
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 2, replacer_type);
+
+    // Scenario: after growing, more pages than the original size can be pinned at once.
+    ASSERT_TRUE(bpm->Resize(grown_size));
+    EXPECT_EQ(grown_size, bpm->GetPoolSize());
+    for (int i = 0; i < num_pages; i++) {
+      page_id_t page_id;
+      Page *page = bpm->NewPage(page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    }
+
+    // Scenario: shrinking fails while the frames to drop are pinned, and leaves the pool as it was.
+    EXPECT_FALSE(bpm->Resize(buffer_pool_size));
+    EXPECT_EQ(grown_size, bpm->GetPoolSize());
+    for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+      EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+    }
+
+    // Scenario: once unpinned, the dirty pages are written back on shrink and can be read again.
+    ASSERT_TRUE(bpm->Resize(buffer_pool_size / 2));
+    EXPECT_EQ(buffer_pool_size / 2, bpm->GetPoolSize());
+    for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+      Page *page = bpm->FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+      EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+    // the pool really is smaller: only 8 pages can be pinned at once
+    for (page_id_t page_id = 0; page_id < 8; page_id++) {
+      ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    }
+    EXPECT_EQ(nullptr, bpm->FetchPage(8));
+    for (page_id_t page_id = 0; page_id < 8; page_id++) {
+      EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+    EXPECT_FALSE(bpm->Resize(1));
+    EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+    delete bpm;
+    disk_manager->Close();
+    remove(db_name.c_str());
+    delete disk_manager;
+  }
+}
+
+TEST(BufferPoolManagerTest, ReadOnlyMappingTest) {
+  const std::string db_name = "bpm_read_only_test.db";
+  const int num_pages = 100;
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(16, disk_manager, 2);
+  for (int i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  delete bpm;
+  disk_manager->Close();
+  delete disk_manager;
+
+  disk_manager = new DiskManager(db_name, false, true);
+  bpm = new BufferPoolManager(16, disk_manager, 2);
+  ASSERT_TRUE(bpm->IsReadOnly());
+  // Scenario: pages are served straight from the mapping, more than the pool could hold, without pinning.
+  for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(disk_manager->GetMappedPage(page_id), page->GetData());
+    EXPECT_EQ(page, bpm->FetchPage(page_id));
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_FALSE(bpm->IsPageFree(page_id));
+  }
+  EXPECT_TRUE(bpm->UnpinPage(0, true));
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  // Scenario: nothing can be allocated, deleted or written back.
+  page_id_t page_id;
+  EXPECT_EQ(nullptr, bpm->NewPage(page_id));
+  EXPECT_FALSE(bpm->DeletePage(0));
+  EXPECT_FALSE(bpm->FlushPage(0));
+  EXPECT_EQ(nullptr, bpm->FetchPage(static_cast<page_id_t>(disk_manager->GetMappedPageCount())));
+
+  delete bpm;
+  disk_manager->Close();
+  delete disk_manager;
+  remove(db_name.c_str());
+}
@@ -0,0 +1,139 @@
+#include "buffer/lru_k_replacer.h"
+
+#include <list>
+#include <random>
+#include <unordered_map>
+
+#include "buffer/lru_replacer.h"
+#include "gtest/gtest.h"
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer lru_k_replacer(7, 2, 0);
+
+  // Scenario: frames 1~5 are referenced once, frame 6 twice.
+  for (frame_id_t i = 1; i <= 6; i++) {
+    lru_k_replacer.Pin(i);
+  }
+  lru_k_replacer.Pin(6);
+  for (frame_id_t i = 1; i <= 6; i++) {
+    lru_k_replacer.Unpin(i);
+  }
+  EXPECT_EQ(6, lru_k_replacer.Size());
+
+  // Scenario: frames with less than K references go first, least recently used first.
+  int value;
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+
+  // Scenario: a second reference to 3 gives it a finite K-distance, which is older than the one of 6.
+  lru_k_replacer.Pin(3);
+  lru_k_replacer.Unpin(3);
+  lru_k_replacer.Pin(4);
+  EXPECT_EQ(3, lru_k_replacer.Size());
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(5, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(6, value);
+  EXPECT_FALSE(lru_k_replacer.Victim(&value));
+
+  // Scenario: a removed frame loses its history.
+  lru_k_replacer.Unpin(4);
+  lru_k_replacer.Remove(4);
+  EXPECT_EQ(0, lru_k_replacer.Size());
+}
+
+TEST(LRUKReplacerTest, CorrelatedReferenceTest) {
+  LRUKReplacer lru_k_replacer(4, 2, 3);
+
+  // Scenario: frame 0 is read many times in a row (like a scan walking its tuples), frame 1 twice far apart.
+  lru_k_replacer.Pin(1);
+  lru_k_replacer.Unpin(1);
+  for (int i = 0; i < 10; i++) {
+    lru_k_replacer.Pin(0);
+    lru_k_replacer.Unpin(0);
+  }
+  lru_k_replacer.Pin(1);
+  lru_k_replacer.Unpin(1);
+
+  // The burst on frame 0 only counts as one reference, so 0 is evicted before 1.
+  int value;
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+}
+
+/**
+ * Replays a page reference string against a replacer the way one buffer pool shard does, and reports the hit ratio
+ * of the index pages.
+ */
+static double IndexHitRatioUnderScan(Replacer *replacer, size_t num_frames) {
+  const int num_index_pages = 48;
+  const int num_scan_pages = 2000;
+  const int tuples_per_page = 16;
+  std::unordered_map<page_id_t, frame_id_t> page_table;
+  std::unordered_map<frame_id_t, page_id_t> frame_owner;
+  std::list<frame_id_t> free_list;
+  for (size_t i = 0; i < num_frames; i++) {
+    free_list.push_back(i);
+  }
+  auto access = [&](page_id_t page_id) {
+    auto iter = page_table.find(page_id);
+    bool hit = iter != page_table.end();
+    frame_id_t frame_id;
+    if (hit) {
+      frame_id = iter->second;
+    } else {
+      if (!free_list.empty()) {
+        frame_id = free_list.front();
+        free_list.pop_front();
+      } else {
+        EXPECT_TRUE(replacer->Victim(&frame_id));
+        page_table.erase(frame_owner[frame_id]);
+      }
+      page_table[page_id] = frame_id;
+      frame_owner[frame_id] = page_id;
+    }
+    replacer->Pin(frame_id);
+    replacer->Unpin(frame_id);
+    return hit;
+  };
+
+  std::default_random_engine rng(0);
+  std::uniform_int_distribution<page_id_t> index_dist(0, num_index_pages - 1);
+  // Warm up the index working set.
+  for (int round = 0; round < 2; round++) {
+    for (page_id_t i = 0; i < num_index_pages; i++) {
+      access(i);
+    }
+  }
+  // A full scan walks every tuple of every heap page while index lookups keep running.
+  int index_hits = 0, index_refs = 0;
+  for (page_id_t scan_page = 0; scan_page < num_scan_pages; scan_page++) {
+    for (int i = 0; i < tuples_per_page; i++) {
+      access(num_index_pages + scan_page);
+    }
+    for (int i = 0; i < 2; i++) {
+      index_hits += access(index_dist(rng)) ? 1 : 0;
+      index_refs++;
+    }
+  }
+  return static_cast<double>(index_hits) / index_refs;
+}
+
+TEST(LRUKReplacerTest, ScanResistanceTest) {
+  const size_t num_frames = 64;
+  LRUReplacer lru_replacer(num_frames);
+  LRUKReplacer lru_k_replacer(num_frames);
+
+  double lru_ratio = IndexHitRatioUnderScan(&lru_replacer, num_frames);
+  double lru_k_ratio = IndexHitRatioUnderScan(&lru_k_replacer, num_frames);
+
+  // Scenario: the scan pages are only referenced in correlated bursts, so LRU-K never evicts the index pages for them.
+  EXPECT_GT(lru_k_ratio, 0.99);
+  EXPECT_GT(lru_k_ratio, lru_ratio);
+}
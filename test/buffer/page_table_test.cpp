@@ -0,0 +1,116 @@
+#include "buffer/page_table.h"
+
+#include <atomic>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+TEST(PageTableTest, SampleTest) {
+  PageTable page_table(4);
+  EXPECT_EQ(8, page_table.Capacity());
+
+  // Scenario: page ids of one shard share a stride, they must still be found.
+  for (page_id_t i = 0; i < 4; i++) {
+    page_table.Insert(i * 8, i);
+  }
+  EXPECT_EQ(4, page_table.Size());
+  frame_id_t frame_id;
+  for (page_id_t i = 0; i < 4; i++) {
+    ASSERT_TRUE(page_table.Find(i * 8, &frame_id));
+    EXPECT_EQ(i, frame_id);
+  }
+  EXPECT_FALSE(page_table.Find(1, &frame_id));
+
+  // Scenario: inserting an existing page id replaces its frame.
+  page_table.Insert(8, 3);
+  EXPECT_EQ(4, page_table.Size());
+  ASSERT_TRUE(page_table.Find(8, &frame_id));
+  EXPECT_EQ(3, frame_id);
+
+  // Scenario: erasing keeps the other entries reachable.
+  EXPECT_TRUE(page_table.Erase(0));
+  EXPECT_FALSE(page_table.Erase(0));
+  EXPECT_FALSE(page_table.Find(0, &frame_id));
+  for (page_id_t i = 1; i < 4; i++) {
+    EXPECT_TRUE(page_table.Find(i * 8, &frame_id));
+  }
+  EXPECT_EQ(3, page_table.Size());
+}
+
+TEST(PageTableTest, RandomOperationTest) {
+  const size_t num_frames = 100;
+  PageTable page_table(num_frames);
+  std::unordered_map<page_id_t, frame_id_t> expected;
+  std::default_random_engine rng(0);
+  std::uniform_int_distribution<page_id_t> page_dist(0, 1000);
+  std::uniform_int_distribution<frame_id_t> frame_dist(0, num_frames - 1);
+
+  // Scenario: the table behaves like unordered_map through a long run of inserts and erases.
+  for (int i = 0; i < 100000; i++) {
+    page_id_t page_id = page_dist(rng);
+    if (expected.size() < num_frames && (i % 3 != 0 || expected.empty())) {
+      frame_id_t frame_id = frame_dist(rng);
+      page_table.Insert(page_id, frame_id);
+      expected[page_id] = frame_id;
+    } else {
+      EXPECT_EQ(expected.erase(page_id) > 0, page_table.Erase(page_id));
+    }
+    ASSERT_EQ(expected.size(), page_table.Size());
+  }
+  for (page_id_t page_id = 0; page_id <= 1000; page_id++) {
+    frame_id_t frame_id;
+    auto iter = expected.find(page_id);
+    ASSERT_EQ(iter != expected.end(), page_table.Find(page_id, &frame_id));
+    if (iter != expected.end()) {
+      EXPECT_EQ(iter->second, frame_id);
+    }
+  }
+}
+
+TEST(PageTableTest, ConcurrentFindTest) {
+  const size_t num_frames = 64;
+  const int num_readers = 4;
+  PageTable page_table(num_frames);
+
+  // Scenario: page p is always mapped to frame p % num_frames, while the writer keeps replacing pages.
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> readers;
+  std::vector<int> errors(num_readers, 0);
+  for (int t = 0; t < num_readers; t++) {
+    readers.emplace_back([&, t] {
+      std::default_random_engine rng(t);
+      std::uniform_int_distribution<page_id_t> page_dist(0, 4 * num_frames - 1);
+      while (!stop.load()) {
+        page_id_t page_id = page_dist(rng);
+        frame_id_t frame_id;
+        if (page_table.Find(page_id, &frame_id) && frame_id != static_cast<frame_id_t>(page_id % num_frames)) {
+          errors[t]++;
+        }
+      }
+    });
+  }
+  std::default_random_engine rng(num_readers);
+  std::uniform_int_distribution<page_id_t> page_dist(0, 3);
+  std::vector<page_id_t> resident(num_frames);
+  for (size_t i = 0; i < num_frames; i++) {
+    resident[i] = i;
+    page_table.Insert(i, i);
+  }
+  for (int i = 0; i < 200000; i++) {
+    size_t frame_id = i % num_frames;
+    page_table.Erase(resident[frame_id]);
+    resident[frame_id] = page_dist(rng) * num_frames + frame_id;
+    page_table.Insert(resident[frame_id], frame_id);
+  }
+  stop.store(true);
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  for (int t = 0; t < num_readers; t++) {
+    EXPECT_EQ(0, errors[t]);
+  }
+  EXPECT_EQ(num_frames, page_table.Size());
+}
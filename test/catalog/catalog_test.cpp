@@ -126,4 +126,55 @@ TEST(CatalogTest, CatalogIndexTest) {
     ASSERT_EQ(rid.Get(), ret_02[i].Get());
   }
   delete db_02;
-}
\ No newline at end of file
+}
+TEST(CatalogTest, CatalogCompressedTableTest) {
+  // Scenario: whether a table is stored compressed is part of its metadata. After the catalog is loaded again the
+  // pages the table grows into are still allocated compressed, whatever its last page turned out to be stored as.
+  auto db_01 = new DBStorageEngine(db_file_name, true);
+  auto &catalog_01 = db_01->catalog_mgr_;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  Txn txn;
+  TableInfo *compressed_info = nullptr;
+  TableInfo *plain_info = nullptr;
+  ASSERT_EQ(DB_SUCCESS, catalog_01->CreateTable("table-c", schema.get(), &txn, compressed_info,
+                                                TableFormat::kRowFormat, true));
+  ASSERT_EQ(DB_SUCCESS, catalog_01->CreateTable("table-r", schema.get(), &txn, plain_info));
+  ASSERT_TRUE(compressed_info->GetTableHeap()->IsCompressed());
+  ASSERT_FALSE(plain_info->GetTableHeap()->IsCompressed());
+  // 随机的字符压缩不了，最后一页按原样写回
+  char name[64];
+  auto insert_rows = [&](TableHeap *table_heap, int num_rows) {
+    for (int i = 0; i < num_rows; i++) {
+      RandomUtils::RandomString(name, sizeof(name));
+      std::vector<Field> fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, name, sizeof(name), true)};
+      Row row(fields);
+      ASSERT_TRUE(table_heap->InsertTuple(row, &txn));
+    }
+  };
+  insert_rows(compressed_info->GetTableHeap(), 10);
+  insert_rows(plain_info->GetTableHeap(), 10);
+  delete db_01;
+
+  auto db_02 = new DBStorageEngine(db_file_name, false);
+  auto &catalog_02 = db_02->catalog_mgr_;
+  for (const char *table_name : {"table-c", "table-r"}) {
+    TableInfo *table_info = nullptr;
+    ASSERT_EQ(DB_SUCCESS, catalog_02->GetTable(table_name, table_info));
+    bool compressed = strcmp(table_name, "table-c") == 0;
+    auto *table_heap = table_info->GetTableHeap();
+    ASSERT_EQ(compressed, table_heap->IsCompressed());
+    // 一直插入到表长出新的一页
+    std::vector<page_id_t> page_ids;
+    ASSERT_TRUE(table_heap->GetPageIds(&page_ids));
+    size_t num_pages = page_ids.size();
+    while (page_ids.size() == num_pages) {
+      insert_rows(table_heap, 10);
+      page_ids.clear();
+      ASSERT_TRUE(table_heap->GetPageIds(&page_ids));
+    }
+    EXPECT_EQ(compressed, db_02->bpm_->IsPageCompressed(page_ids.back()));
+  }
+  delete db_02;
+}
@@ -0,0 +1,91 @@
+#include "common/hybrid_latch.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+TEST(HybridLatchTest, SampleTest) {
+  const int num_threads = 4;
+  const int num_rounds = 20000;
+  HybridLatch latch;
+  int64_t first = 0, second = 0;  // always equal outside of the write latch
+  std::atomic<int> torn_reads{0};
+
+  // Scenario: writers and readers mixed, readers never see a half done update.
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < num_rounds; i++) {
+        if ((i + t) % 4 == 0) {
+          latch.WLock();
+          first++;
+          second++;
+          latch.WUnlock();
+        } else {
+          latch.RLock();
+          if (first != second) torn_reads++;
+          latch.RUnlock();
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, torn_reads.load());
+  EXPECT_EQ(num_threads * num_rounds / 4, first);
+  EXPECT_EQ(first, second);
+}
+
+TEST(HybridLatchTest, OptimisticReadTest) {
+  HybridLatch latch;
+  uint32_t version;
+
+  // Scenario: an optimistic read fails while a writer holds the latch, and after it has left.
+  ASSERT_TRUE(latch.TryOptimisticRead(&version));
+  EXPECT_TRUE(latch.ValidateOptimisticRead(version));
+  latch.WLock();
+  EXPECT_FALSE(latch.ValidateOptimisticRead(version));
+  uint32_t locked_version;
+  EXPECT_FALSE(latch.TryOptimisticRead(&locked_version));
+  latch.WUnlock();
+  EXPECT_FALSE(latch.ValidateOptimisticRead(version));
+
+  // Scenario: shared holders do not invalidate optimistic readers.
+  ASSERT_TRUE(latch.TryOptimisticRead(&version));
+  latch.RLock();
+  latch.RUnlock();
+  EXPECT_TRUE(latch.ValidateOptimisticRead(version));
+
+  // Scenario: a validated optimistic read is never torn, however busy the writer is.
+  std::atomic<int64_t> first{0}, second{0};
+  std::atomic<bool> stop{false};
+  std::thread writer([&] {
+    while (!stop.load()) {
+      latch.WLock();
+      first.store(first.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      second.store(second.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      latch.WUnlock();
+    }
+  });
+  int validated = 0, torn = 0;
+  for (int i = 0; i < 200000; i++) {
+    if (!latch.TryOptimisticRead(&version)) continue;
+    int64_t a = first.load(std::memory_order_relaxed);
+    int64_t b = second.load(std::memory_order_relaxed);
+    if (!latch.ValidateOptimisticRead(version)) continue;
+    validated++;
+    if (a != b) torn++;
+  }
+  stop.store(true);
+  writer.join();
+  EXPECT_EQ(0, torn);
+  EXPECT_GT(validated, 0);
+}
+
+TEST(HybridLatchTest, SizeTest) {
+  // Scenario: the latch fits in one 8-byte word, so it can sit in every Page descriptor.
+  EXPECT_EQ(8u, sizeof(HybridLatch));
+}
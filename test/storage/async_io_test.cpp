@@ -0,0 +1,89 @@
+#include "storage/async_io.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+/**
+ * Writes num_blocks blocks of PAGE_SIZE with one request each, reads them back the same way, and checks the contents.
+ */
+static void RoundTrip(AsyncIO *engine, int num_blocks) {
+  std::vector<std::vector<char>> blocks(num_blocks, std::vector<char>(PAGE_SIZE));
+  std::atomic<int> written{0};
+  for (int i = 0; i < num_blocks; i++) {
+    memset(blocks[i].data(), 'a' + i % 26, PAGE_SIZE);
+    iovec iov{blocks[i].data(), PAGE_SIZE};
+    engine->Submit(true, &iov, 1, static_cast<off_t>(i) * PAGE_SIZE, [&written](ssize_t result) {
+      EXPECT_EQ(PAGE_SIZE, result);
+      written++;
+    });
+  }
+  // 析构之前所有请求都要完成，这里用计数等待
+  while (written.load() < num_blocks) {
+    std::this_thread::yield();
+  }
+
+  std::atomic<int> read{0};
+  for (int i = 0; i < num_blocks; i++) {
+    memset(blocks[i].data(), 0, PAGE_SIZE);
+    iovec iov{blocks[i].data(), PAGE_SIZE};
+    engine->Submit(false, &iov, 1, static_cast<off_t>(i) * PAGE_SIZE, [&read](ssize_t result) {
+      EXPECT_EQ(PAGE_SIZE, result);
+      read++;
+    });
+  }
+  while (read.load() < num_blocks) {
+    std::this_thread::yield();
+  }
+  for (int i = 0; i < num_blocks; i++) {
+    EXPECT_EQ(std::string(PAGE_SIZE, 'a' + i % 26), std::string(blocks[i].data(), PAGE_SIZE));
+  }
+
+  // Scenario: a read past the end of the file completes with a short result instead of failing.
+  std::vector<char> tail(2 * PAGE_SIZE);
+  iovec iov[2] = {{tail.data(), PAGE_SIZE}, {tail.data() + PAGE_SIZE, PAGE_SIZE}};
+  std::atomic<ssize_t> tail_result{-1};
+  engine->Submit(false, iov, 2, static_cast<off_t>(num_blocks - 1) * PAGE_SIZE,
+                 [&tail_result](ssize_t result) { tail_result = result; });
+  while (tail_result.load() < 0) {
+    std::this_thread::yield();
+  }
+  EXPECT_EQ(PAGE_SIZE, tail_result.load());
+}
+
+TEST(AsyncIOTest, ThreadPoolTest) {
+  const char *file_name = "async_io_pool_test.db";
+  int fd = open(file_name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  ASSERT_GE(fd, 0);
+  {
+    ThreadPoolAsyncIO engine(fd, 8, 3);
+    RoundTrip(&engine, 100);
+  }
+  close(fd);
+  remove(file_name);
+}
+
+TEST(AsyncIOTest, UringTest) {
+  const char *file_name = "async_io_uring_test.db";
+  int fd = open(file_name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  ASSERT_GE(fd, 0);
+  // io_uring可能被内核或沙箱禁用，这时只检查回退路径
+  std::unique_ptr<UringAsyncIO> engine = UringAsyncIO::Create(fd, 8);
+  if (engine != nullptr) {
+    RoundTrip(engine.get(), 100);
+    engine.reset();
+    ASSERT_EQ(0, ftruncate(fd, 0));
+  }
+  std::unique_ptr<AsyncIO> any_engine = AsyncIO::Create(fd, 8);
+  ASSERT_NE(nullptr, any_engine);
+  RoundTrip(any_engine.get(), 10);
+  any_engine.reset();
+  close(fd);
+  remove(file_name);
+}
@@ -1,8 +1,12 @@
 #include "storage/disk_manager.h"
 
+#include <fstream>
+#include <string>
 #include <unordered_set>
+#include <vector>
 
 #include "gtest/gtest.h"
+#include "storage/page_compressor.h"
 
 TEST(DiskManagerTest, BitMapPageTest) {
   const size_t size = 512;
@@ -56,4 +60,292 @@ TEST(DiskManagerTest, FreePageAllocationTest) {
   EXPECT_EQ(DiskManager::BITMAP_SIZE - 2, meta_page->GetExtentUsedPage(0));
   EXPECT_EQ(DiskManager::BITMAP_SIZE - 3, meta_page->GetExtentUsedPage(1));
   remove(db_name.c_str());
-}
\ No newline at end of file
+}
+
+TEST(DiskManagerTest, PageIOTest) {
+  std::string db_name = "disk_io_test.db";
+  remove(db_name.c_str());
+  alignas(PAGE_SIZE) char data[PAGE_SIZE];
+  alignas(PAGE_SIZE) char buf[PAGE_SIZE];
+
+  for (bool direct_io : {false, true}) {
+    auto *disk_mgr = new DiskManager(db_name, direct_io);
+    // Scenario: a page past the end of the file reads as zeros.
+    memset(buf, 1, PAGE_SIZE);
+    disk_mgr->ReadPage(100, buf);
+    for (int i = 0; i < PAGE_SIZE; i++) {
+      ASSERT_EQ(0, buf[i]);
+    }
+
+    // Scenario: single pages and batches survive a restart, whether or not the buffers are aligned.
+    for (page_id_t page_id = 0; page_id < 4; page_id++) {
+      memset(data, 'a' + page_id, PAGE_SIZE);
+      disk_mgr->WritePage(page_id, data);
+    }
+    // the batch crosses the first bitmap page, so it is split into two runs
+    std::vector<page_id_t> page_ids = {static_cast<page_id_t>(DiskManager::BITMAP_SIZE), 5, 4,
+                                       static_cast<page_id_t>(DiskManager::BITMAP_SIZE - 1)};
+    std::vector<std::vector<char>> unaligned(page_ids.size(), std::vector<char>(PAGE_SIZE + 1));
+    std::vector<const char *> write_data;
+    for (size_t i = 0; i < page_ids.size(); i++) {
+      memset(unaligned[i].data() + 1, 'A' + i, PAGE_SIZE);
+      write_data.push_back(unaligned[i].data() + 1);
+    }
+    disk_mgr->WritePages(page_ids, write_data);
+    disk_mgr->Sync();
+    disk_mgr->Close();
+    delete disk_mgr;
+
+    disk_mgr = new DiskManager(db_name, direct_io);
+    for (page_id_t page_id = 0; page_id < 4; page_id++) {
+      disk_mgr->ReadPage(page_id, buf);
+      EXPECT_EQ(std::string(PAGE_SIZE, 'a' + page_id), std::string(buf, PAGE_SIZE));
+    }
+    std::vector<char *> read_data;
+    for (size_t i = 0; i < page_ids.size(); i++) {
+      memset(unaligned[i].data() + 1, 0, PAGE_SIZE);
+      read_data.push_back(unaligned[i].data() + 1);
+    }
+    disk_mgr->ReadPages(page_ids, read_data);
+    for (size_t i = 0; i < page_ids.size(); i++) {
+      EXPECT_EQ(std::string(PAGE_SIZE, 'A' + i), std::string(read_data[i], PAGE_SIZE));
+    }
+    disk_mgr->Close();
+    delete disk_mgr;
+    remove(db_name.c_str());
+  }
+}
+
+TEST(DiskManagerTest, AsyncPageIOTest) {
+  std::string db_name = "disk_async_io_test.db";
+  remove(db_name.c_str());
+  const int num_pages = 64;
+
+  for (bool direct_io : {false, true}) {
+    auto *disk_mgr = new DiskManager(db_name, direct_io);
+    std::vector<char *> pages;
+    for (int i = 0; i < num_pages; i++) {
+      pages.push_back(static_cast<char *>(operator new[](PAGE_SIZE, std::align_val_t(PAGE_SIZE))));
+    }
+    // Scenario: many writes in flight at once all land on disk.
+    std::vector<std::future<void>> pending;
+    for (int i = 0; i < num_pages; i++) {
+      memset(pages[i], 'a' + i % 26, PAGE_SIZE);
+      pending.push_back(disk_mgr->WritePageAsync(i, pages[i]));
+    }
+    for (auto &finished : pending) {
+      finished.wait();
+    }
+    pending.clear();
+
+    // Scenario: asynchronous reads see them, and a page past the end of the file reads as zeros.
+    for (int i = 0; i < num_pages; i++) {
+      memset(pages[i], 0, PAGE_SIZE);
+      pending.push_back(disk_mgr->ReadPageAsync(i, pages[i]));
+    }
+    for (auto &finished : pending) {
+      finished.wait();
+    }
+    for (int i = 0; i < num_pages; i++) {
+      EXPECT_EQ(std::string(PAGE_SIZE, 'a' + i % 26), std::string(pages[i], PAGE_SIZE));
+    }
+    memset(pages[0], 1, PAGE_SIZE);
+    disk_mgr->ReadPageAsync(1000, pages[0]).wait();
+    EXPECT_EQ(std::string(PAGE_SIZE, 0), std::string(pages[0], PAGE_SIZE));
+    disk_mgr->Close();
+    delete disk_mgr;
+
+    // Scenario: a write that fails is reported to the caller instead of completing normally.
+    {
+      DiskManager read_only(db_name, direct_io, true);
+      EXPECT_THROW(read_only.WritePageAsync(0, pages[0]).get(), std::runtime_error);
+      EXPECT_FALSE(read_only.WritePages({0, 1}, {pages[0], pages[1]}));
+      read_only.Close();
+    }
+
+    for (auto page : pages) {
+      operator delete[](page, std::align_val_t(PAGE_SIZE));
+    }
+    remove(db_name.c_str());
+  }
+}
+
+TEST(DiskManagerTest, BitmapCacheTest) {
+  std::string db_name = "disk_bitmap_cache_test.db";
+  remove(db_name.c_str());
+  auto *disk_mgr = new DiskManager(db_name);
+  const uint32_t num_pages = DiskManager::BITMAP_SIZE + 100;
+  for (uint32_t i = 0; i < num_pages; i++) {
+    ASSERT_EQ(static_cast<page_id_t>(i), disk_mgr->AllocatePage());
+  }
+  // Scenario: freed pages are handed out again lowest first, even in an extent that was full.
+  disk_mgr->DeAllocatePage(DiskManager::BITMAP_SIZE + 50);
+  disk_mgr->DeAllocatePage(70);
+  disk_mgr->DeAllocatePage(3);
+  EXPECT_TRUE(disk_mgr->IsPageFree(3));
+  EXPECT_FALSE(disk_mgr->IsPageFree(4));
+  EXPECT_EQ(3, disk_mgr->AllocatePage());
+  EXPECT_EQ(70, disk_mgr->AllocatePage());
+  EXPECT_EQ(static_cast<page_id_t>(DiskManager::BITMAP_SIZE + 50), disk_mgr->AllocatePage());
+  EXPECT_EQ(static_cast<page_id_t>(num_pages), disk_mgr->AllocatePage());
+
+  // Scenario: the cached bitmaps are written back on close and read again after a restart.
+  disk_mgr->DeAllocatePage(10);
+  disk_mgr->Close();
+  delete disk_mgr;
+  disk_mgr = new DiskManager(db_name);
+  EXPECT_TRUE(disk_mgr->IsPageFree(10));
+  EXPECT_FALSE(disk_mgr->IsPageFree(11));
+  EXPECT_FALSE(disk_mgr->IsPageFree(num_pages));
+  EXPECT_EQ(10, disk_mgr->AllocatePage());
+  EXPECT_EQ(static_cast<page_id_t>(num_pages + 1), disk_mgr->AllocatePage());
+  disk_mgr->Close();
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, PageRunTest) {
+  std::string db_name = "disk_page_run_test.db";
+  remove(db_name.c_str());
+  DiskManager disk_mgr(db_name);
+  const auto run_size = static_cast<page_id_t>(DiskManager::PAGE_RUN_SIZE);
+  ASSERT_EQ(0, disk_mgr.AllocatePage());
+  // Scenario: two segments growing at the same time take their pages from separate runs.
+  PageRun run_a, run_b;
+  std::vector<page_id_t> pages_a, pages_b;
+  for (page_id_t i = 0; i < 2 * run_size; i++) {
+    pages_a.push_back(disk_mgr.AllocatePage(&run_a));
+    pages_b.push_back(disk_mgr.AllocatePage(&run_b));
+  }
+  for (page_id_t i = 0; i < run_size; i++) {
+    EXPECT_EQ(run_size + i, pages_a[i]);
+    EXPECT_EQ(2 * run_size + i, pages_b[i]);
+    EXPECT_EQ(3 * run_size + i, pages_a[run_size + i]);
+    EXPECT_EQ(4 * run_size + i, pages_b[run_size + i]);
+  }
+
+  // Scenario: a segment growing alone stays contiguous across runs.
+  PageRun run_c;
+  for (page_id_t i = 0; i < 2 * run_size; i++) {
+    EXPECT_EQ(5 * run_size + i, disk_mgr.AllocatePage(&run_c));
+  }
+
+  // Scenario: allocations without a run skip the pages reserved by a run.
+  disk_mgr.DeAllocatePage(5 * run_size);
+  disk_mgr.DeAllocatePage(6 * run_size + 10);
+  for (page_id_t i = 1; i < run_size; i++) {
+    ASSERT_EQ(i, disk_mgr.AllocatePage());
+  }
+  EXPECT_EQ(5 * run_size, disk_mgr.AllocatePage());
+  EXPECT_EQ(7 * run_size, disk_mgr.AllocatePage());
+  disk_mgr.ReleasePageRun(&run_c);
+  EXPECT_EQ(6 * run_size + 10, disk_mgr.AllocatePage());
+  disk_mgr.Close();
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, PageSizeTest) {
+  std::string db_name = "disk_page_size_test.db";
+  remove(db_name.c_str());
+  // Scenario: a new file records the page size of this build and keeps it across a restart.
+  auto *disk_mgr = new DiskManager(db_name);
+  ASSERT_EQ(0, disk_mgr->AllocatePage());
+  disk_mgr->Close();
+  delete disk_mgr;
+  disk_mgr = new DiskManager(db_name);
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr->GetMetaData());
+  EXPECT_TRUE(meta_page->HasMagicNum());
+  EXPECT_EQ(static_cast<uint32_t>(PAGE_SIZE), meta_page->GetPageSize());
+  EXPECT_EQ(1u, meta_page->GetAllocatedPages());
+  disk_mgr->Close();
+  delete disk_mgr;
+
+  // Scenario: a file created with another page size is refused.
+  {
+    std::fstream file(db_name, std::ios::in | std::ios::out | std::ios::binary);
+    uint32_t other_size = PAGE_SIZE == 4096 ? 8192 : 4096;
+    file.seekp(sizeof(uint32_t));
+    file.write(reinterpret_cast<const char *>(&other_size), sizeof(other_size));
+  }
+  EXPECT_THROW(DiskManager disk_mgr_other(db_name), std::runtime_error);
+
+  // Scenario: a legacy file without the page size is upgraded if it has 4 KB pages, refused otherwise.
+  {
+    std::fstream file(db_name, std::ios::in | std::ios::out | std::ios::binary);
+    std::vector<uint32_t> legacy_meta(PAGE_SIZE / sizeof(uint32_t), 0);
+    legacy_meta[0] = legacy_meta[1] = legacy_meta[2] = 1;  // one page allocated in one extent
+    file.seekp(0);
+    file.write(reinterpret_cast<const char *>(legacy_meta.data()), PAGE_SIZE);
+  }
+  if (PAGE_SIZE == 4096) {
+    disk_mgr = new DiskManager(db_name);
+    meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr->GetMetaData());
+    EXPECT_TRUE(meta_page->HasMagicNum());
+    EXPECT_EQ(1u, meta_page->GetAllocatedPages());
+    EXPECT_EQ(1u, meta_page->GetExtentNums());
+    EXPECT_EQ(1u, meta_page->GetExtentUsedPage(0));
+    EXPECT_FALSE(disk_mgr->IsPageFree(0));
+    EXPECT_EQ(1, disk_mgr->AllocatePage());
+    disk_mgr->Close();
+    delete disk_mgr;
+  } else {
+    EXPECT_THROW(DiskManager disk_mgr_legacy(db_name), std::runtime_error);
+  }
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, CompressionTest) {
+  std::string db_name = "disk_compression_test.db";
+  remove(db_name.c_str());
+  // Scenario: the codec round-trips repetitive and random pages, and gives up on data it cannot shrink.
+  std::vector<char> repetitive(PAGE_SIZE), random(PAGE_SIZE), packed(2 * PAGE_SIZE), unpacked(PAGE_SIZE);
+  for (size_t i = 0; i < PAGE_SIZE; i++) {
+    repetitive[i] = "minisql"[i % 7] + static_cast<char>(i / 512);
+    random[i] = static_cast<char>(std::rand());
+  }
+  size_t packed_size = PageCompressor::Compress(repetitive.data(), PAGE_SIZE, packed.data(), PAGE_SIZE);
+  ASSERT_GT(packed_size, 0u);
+  EXPECT_LT(packed_size, static_cast<size_t>(PAGE_SIZE) / 8);
+  ASSERT_TRUE(PageCompressor::Decompress(packed.data(), packed_size, unpacked.data(), PAGE_SIZE));
+  EXPECT_EQ(repetitive, unpacked);
+  EXPECT_EQ(0u, PageCompressor::Compress(random.data(), PAGE_SIZE, packed.data(), PAGE_SIZE / 2));
+  packed_size = PageCompressor::Compress(random.data(), PAGE_SIZE, packed.data(), packed.size());
+  ASSERT_TRUE(PageCompressor::Decompress(packed.data(), packed_size, unpacked.data(), PAGE_SIZE));
+  EXPECT_EQ(random, unpacked);
+  EXPECT_FALSE(PageCompressor::Decompress(packed.data(), packed_size - 1, unpacked.data(), PAGE_SIZE));
+
+  // Scenario: pages of a compressed run are stored compressed, other pages as is, and all of them read back.
+  auto *disk_mgr = new DiskManager(db_name);
+  PageRun run;
+  run.compress_ = true;
+  page_id_t plain_page = disk_mgr->AllocatePage();
+  page_id_t compressed_page = disk_mgr->AllocatePage(&run);
+  page_id_t incompressible_page = disk_mgr->AllocatePage(&run);
+  EXPECT_FALSE(disk_mgr->IsPageCompressed(plain_page));
+  EXPECT_TRUE(disk_mgr->IsPageCompressed(compressed_page));
+  disk_mgr->WritePage(plain_page, repetitive.data());
+  disk_mgr->WritePage(compressed_page, repetitive.data());
+  disk_mgr->WritePages({incompressible_page}, {random.data()});
+  disk_mgr->Close();
+  delete disk_mgr;
+
+  // Scenario: after a restart compressed pages are recognized when read, and a mapped page is decompressed.
+  disk_mgr = new DiskManager(db_name);
+  EXPECT_FALSE(disk_mgr->IsPageCompressed(compressed_page));
+  disk_mgr->ReadPage(compressed_page, unpacked.data());
+  EXPECT_EQ(repetitive, unpacked);
+  EXPECT_TRUE(disk_mgr->IsPageCompressed(compressed_page));
+  std::vector<char> other(PAGE_SIZE);
+  disk_mgr->ReadPages({plain_page, incompressible_page}, {unpacked.data(), other.data()});
+  EXPECT_EQ(repetitive, unpacked);
+  EXPECT_EQ(random, other);
+  EXPECT_FALSE(disk_mgr->IsPageCompressed(plain_page));
+  disk_mgr->Close();
+  delete disk_mgr;
+  DiskManager mapped(db_name, false, true);
+  EXPECT_FALSE(mapped.DecompressPage(plain_page, mapped.GetMappedPage(plain_page), unpacked.data()));
+  ASSERT_TRUE(mapped.DecompressPage(compressed_page, mapped.GetMappedPage(compressed_page), unpacked.data()));
+  EXPECT_EQ(repetitive, unpacked);
+  mapped.Close();
+  remove(db_name.c_str());
+}
@@ -1,12 +1,18 @@
 #include "storage/table_heap.h"
 
+#include <atomic>
+#include <chrono>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "common/instance.h"
 #include "gtest/gtest.h"
 #include "record/field.h"
 #include "record/schema.h"
+#include "storage/parallel_table_scan.h"
+#include "storage/table_scan_cursor.h"
 #include "utils/utils.h"
 
 static string db_file_name = "table_heap_test.db";
@@ -60,3 +66,659 @@ TEST(TableHeapTest, TableHeapSampleTest) {
   }
   ASSERT_EQ(size, 0);
 }
+
+TEST(TableHeapTest, ColdScanReadAheadTest) {
+  const std::string scan_db_file_name = "table_heap_scan_test.db";
+  const int row_nums = 5000;
+  remove(scan_db_file_name.c_str());
+  auto disk_mgr = new DiskManager(scan_db_file_name);
+  auto bpm = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm, schema.get(), nullptr, nullptr, nullptr);
+  char characters[64];
+  for (int i = 0; i < row_nums; i++) {
+    RandomUtils::RandomString(characters, 64);
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 64, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  }
+  page_id_t first_page_id = table_heap->GetFirstPageId();
+  delete table_heap;
+  delete bpm;
+
+  // Scenario: scan the table through a small, cold buffer pool; read-ahead loads the page chain in the background.
+  bpm = new BufferPoolManager(64, disk_mgr, 4);
+  table_heap = TableHeap::Create(bpm, first_page_id, schema.get(), nullptr, nullptr);
+  int row_count = 0;
+  for (auto iter = table_heap->Begin(nullptr); iter != table_heap->End(); iter++) {
+    // rows of a fresh heap come back in insertion order
+    ASSERT_EQ(CmpBool::kTrue, iter->GetField(0)->CompareEquals(Field(TypeId::kTypeInt, row_count)));
+    row_count++;
+  }
+  ASSERT_EQ(row_nums, row_count);
+  // Scenario: the iterator releases every page it visited.
+  ASSERT_TRUE(bpm->CheckAllUnpinned());
+
+  delete table_heap;
+  delete bpm;
+  disk_mgr->Close();
+  delete disk_mgr;
+  remove(scan_db_file_name.c_str());
+}
+
+TEST(TableHeapTest, FreeSpaceMapTest) {
+  const std::string fsm_db_file_name = "table_heap_fsm_test.db";
+  remove(fsm_db_file_name.c_str());
+  auto disk_mgr = new DiskManager(fsm_db_file_name);
+  auto bpm = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm, schema.get(), nullptr, nullptr, nullptr);
+  char characters[64];
+  memset(characters, 'x', sizeof(characters));
+  auto insert_row = [&](TableHeap *heap, int id) {
+    Fields fields{Field(TypeId::kTypeInt, id), Field(TypeId::kTypeChar, characters, 64, true)};
+    Row row(fields);
+    EXPECT_TRUE(heap->InsertTuple(row, nullptr));
+    return row.GetRowId();
+  };
+  auto fetches = [&] {
+    BufferPoolStats stats = bpm->GetStats();
+    return stats.fetch_hits_ + stats.fetch_misses_;
+  };
+  std::vector<RowId> rids;
+  for (int i = 0; i < 20000; i++) {
+    rids.push_back(insert_row(table_heap, i));
+  }
+  // Scenario: an insert into a long heap goes straight to the last page instead of walking the chain.
+  size_t before = fetches();
+  RowId tail_rid = insert_row(table_heap, -1);
+  EXPECT_LE(fetches() - before, 4u);
+  EXPECT_EQ(rids.back().GetPageId(), tail_rid.GetPageId());
+
+  // Scenario: space freed on an early page is found and reused by the next insert.
+  table_heap->ApplyDelete(rids[100], nullptr);
+  table_heap->ApplyDelete(rids[101], nullptr);
+  EXPECT_EQ(rids[100].GetPageId(), insert_row(table_heap, -2).GetPageId());
+
+  // Scenario: the map survives reopening the heap, and a heap without a map gets one built from its page chain.
+  page_id_t first_page_id = table_heap->GetFirstPageId();
+  delete table_heap;
+  table_heap = TableHeap::Create(bpm, first_page_id, schema.get(), nullptr, nullptr);
+  EXPECT_EQ(rids[101].GetPageId(), insert_row(table_heap, -3).GetPageId());
+  table_heap->ApplyDelete(rids[5000], nullptr);
+  delete table_heap;
+  auto first_page = reinterpret_cast<TablePage *>(bpm->FetchPage(first_page_id));
+  page_id_t old_fsm_page_id = first_page->GetPrevPageId();
+  first_page->SetPrevPageId(INVALID_PAGE_ID);
+  bpm->UnpinPage(first_page_id, true);
+  table_heap = TableHeap::Create(bpm, first_page_id, schema.get(), nullptr, nullptr);
+  EXPECT_EQ(rids[5000].GetPageId(), insert_row(table_heap, -4).GetPageId());
+  first_page = reinterpret_cast<TablePage *>(bpm->FetchPage(first_page_id));
+  EXPECT_NE(INVALID_PAGE_ID, first_page->GetPrevPageId());
+  EXPECT_NE(old_fsm_page_id, first_page->GetPrevPageId());
+  bpm->UnpinPage(first_page_id, false);
+
+  // Scenario: every row is still there.
+  size_t row_count = 0;
+  for (auto iter = table_heap->Begin(nullptr); iter != table_heap->End(); iter++) {
+    row_count++;
+  }
+  EXPECT_EQ(rids.size() - 3 + 4, row_count);
+  ASSERT_TRUE(bpm->CheckAllUnpinned());
+  delete table_heap;
+  delete bpm;
+  disk_mgr->Close();
+  delete disk_mgr;
+  remove(fsm_db_file_name.c_str());
+}
+
+TEST(TableHeapTest, InsertTuplesTest) {
+  const std::string batch_db_file_name = "table_heap_batch_test.db";
+  const int row_nums = 10000;
+  remove(batch_db_file_name.c_str());
+  auto disk_mgr = new DiskManager(batch_db_file_name);
+  auto bpm = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm, schema.get(), nullptr, nullptr, nullptr);
+  char characters[64];
+  auto make_rows = [&](int first, int count) {
+    std::vector<Row> rows;
+    for (int i = first; i < first + count; i++) {
+      int32_t len = RandomUtils::RandomInt(1, 64);
+      RandomUtils::RandomString(characters, len);
+      Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, len, true)};
+      rows.emplace_back(fields);
+    }
+    return rows;
+  };
+  // Scenario: a batch fills pages one after the other, every row gets its own rid and reads back.
+  std::vector<Row> rows = make_rows(0, row_nums);
+  ASSERT_TRUE(table_heap->InsertTuples(rows, nullptr));
+  std::unordered_set<int64_t> rids;
+  for (int i = 0; i < row_nums; i++) {
+    ASSERT_TRUE(rids.insert(rows[i].GetRowId().Get()).second);
+    if (i > 0) {
+      ASSERT_GE(rows[i].GetRowId().GetPageId(), rows[i - 1].GetRowId().GetPageId());
+    }
+    Row row(rows[i].GetRowId());
+    ASSERT_TRUE(table_heap->GetTuple(&row, nullptr));
+    ASSERT_EQ(CmpBool::kTrue, row.GetField(0)->CompareEquals(Field(TypeId::kTypeInt, i)));
+    ASSERT_EQ(CmpBool::kTrue, row.GetField(1)->CompareEquals(*rows[i].GetField(1)));
+  }
+
+  // Scenario: a second batch continues on the last page, and a scan returns both batches in order.
+  std::vector<Row> more_rows = make_rows(row_nums, 10);
+  ASSERT_TRUE(table_heap->InsertTuples(more_rows, nullptr));
+  EXPECT_EQ(rows.back().GetRowId().GetPageId(), more_rows.front().GetRowId().GetPageId());
+  int row_count = 0;
+  for (auto iter = table_heap->Begin(nullptr); iter != table_heap->End(); iter++) {
+    ASSERT_EQ(CmpBool::kTrue, iter->GetField(0)->CompareEquals(Field(TypeId::kTypeInt, row_count)));
+    row_count++;
+  }
+  EXPECT_EQ(row_nums + 10, row_count);
+
+  // Scenario: a batch with a row that is too large even with its char values in overflow pages inserts nothing, and
+  // leaves no overflow pages behind.
+  std::vector<Column *> wide_columns = {new Column("doc", TypeId::kTypeChar, 4 * PAGE_SIZE, 0, true, false)};
+  const uint32_t int_count = PAGE_SIZE / sizeof(int32_t);
+  for (uint32_t i = 0; i < int_count; i++) {
+    wide_columns.push_back(new Column("i" + std::to_string(i), TypeId::kTypeInt, i + 1, true, false));
+  }
+  auto wide_schema = std::make_shared<Schema>(wide_columns);
+  TableHeap *wide_heap = TableHeap::Create(bpm, wide_schema.get(), nullptr, nullptr, nullptr);
+  std::vector<char> wide(4 * PAGE_SIZE, 'w');
+  std::vector<Row> wide_rows;
+  Fields small_fields{Field(TypeId::kTypeChar, wide.data(), 1, true)};
+  Fields wide_fields{Field(TypeId::kTypeChar, wide.data(), wide.size(), true)};
+  for (uint32_t i = 0; i < int_count; i++) {
+    small_fields.emplace_back(TypeId::kTypeInt);
+    wide_fields.emplace_back(TypeId::kTypeInt, static_cast<int32_t>(i));
+  }
+  wide_rows.emplace_back(small_fields);
+  wide_rows.emplace_back(wide_fields);
+  page_id_t next_page_id = INVALID_PAGE_ID;
+  bpm->NewPage(next_page_id);
+  bpm->UnpinPage(next_page_id, false);
+  bpm->DeletePage(next_page_id);
+  EXPECT_FALSE(wide_heap->InsertTuples(wide_rows, nullptr));
+  EXPECT_TRUE(wide_heap->Begin(nullptr) == wide_heap->End());
+  EXPECT_TRUE(bpm->IsPageFree(next_page_id));
+  ASSERT_TRUE(bpm->CheckAllUnpinned());
+
+  delete wide_heap;
+  delete table_heap;
+  delete bpm;
+  disk_mgr->Close();
+  delete disk_mgr;
+  remove(batch_db_file_name.c_str());
+}
+
+TEST(TableHeapTest, ScanCursorTest) {
+  const std::string cursor_db_file_name = "table_heap_cursor_test.db";
+  const int row_nums = 5000;
+  remove(cursor_db_file_name.c_str());
+  auto disk_mgr = new DiskManager(cursor_db_file_name);
+  auto bpm = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false),
+                                   new Column("account", TypeId::kTypeFloat, 2, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm, schema.get(), nullptr, nullptr, nullptr);
+  char characters[64];
+  std::vector<RowId> rids;
+  for (int i = 0; i < row_nums; i++) {
+    int32_t len = RandomUtils::RandomInt(1, 64);
+    RandomUtils::RandomString(characters, len);
+    // 每隔几行放一个null，检查null之后的field位置
+    Fields fields{Field(TypeId::kTypeInt, i),
+                  i % 3 == 0 ? Field(TypeId::kTypeChar) : Field(TypeId::kTypeChar, characters, len, true),
+                  i % 5 == 0 ? Field(TypeId::kTypeFloat) : Field(TypeId::kTypeFloat, static_cast<float>(i))};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    rids.push_back(row.GetRowId());
+  }
+  for (int i = 0; i < row_nums; i += 7) {
+    table_heap->ApplyDelete(rids[i], nullptr);
+  }
+
+  // Scenario: the cursor returns the same rows as the iterator, fields read in place match the deserialized ones.
+  {
+    TableScanCursor cursor(table_heap, nullptr);
+    auto iter = table_heap->Begin(nullptr);
+    int row_count = 0;
+    while (cursor.Next()) {
+      ASSERT_TRUE(iter != table_heap->End());
+      const RowView &view = cursor.GetRow();
+      ASSERT_EQ(iter->GetRowId(), view.GetRowId());
+      ASSERT_EQ(3u, view.GetFieldCount());
+      for (uint32_t i = 0; i < 3; i++) {
+        Field field = view.GetField(i);
+        ASSERT_EQ(iter->GetField(i)->IsNull(), field.IsNull());
+        if (!field.IsNull()) {
+          ASSERT_EQ(CmpBool::kTrue, field.CompareEquals(*iter->GetField(i)));
+        }
+      }
+      // Scenario: a projection only deserializes the columns asked for, in their order.
+      Row projected;
+      view.ToRow({2, 0}, &projected);
+      ASSERT_EQ(2u, projected.GetFieldCount());
+      ASSERT_EQ(view.GetRowId(), projected.GetRowId());
+      ASSERT_EQ(CmpBool::kTrue, projected.GetField(1)->CompareEquals(*iter->GetField(0)));
+      ASSERT_EQ(iter->GetField(2)->IsNull(), projected.GetField(0)->IsNull());
+      iter++;
+      row_count++;
+    }
+    EXPECT_TRUE(iter == table_heap->End());
+    EXPECT_EQ(row_nums - (row_nums + 6) / 7, row_count);
+    EXPECT_FALSE(cursor.Next());
+  }
+  // Scenario: the cursor unpins its page once it is destroyed, also when it stops halfway.
+  {
+    TableScanCursor cursor(table_heap, nullptr);
+    ASSERT_TRUE(cursor.Next());
+    Row row;
+    cursor.GetRow().ToRow(&row);
+    ASSERT_EQ(CmpBool::kTrue, row.GetField(0)->CompareEquals(Field(TypeId::kTypeInt, 1)));
+  }
+  // Scenario: a writer to the page waits until the cursor is done with the row it returned.
+  {
+    TableScanCursor cursor(table_heap, nullptr);
+    ASSERT_TRUE(cursor.Next());
+    RowId rid = cursor.GetRow().GetRowId();
+    std::atomic<bool> deleted{false};
+    std::thread writer([&] {
+      table_heap->ApplyDelete(rid, nullptr);
+      deleted.store(true);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(deleted.load());
+    Row row;
+    cursor.GetRow().ToRow(&row);
+    EXPECT_EQ(CmpBool::kTrue, row.GetField(0)->CompareEquals(Field(TypeId::kTypeInt, 1)));
+    cursor.Release();
+    writer.join();
+    EXPECT_TRUE(deleted.load());
+  }
+  ASSERT_TRUE(bpm->CheckAllUnpinned());
+
+  delete table_heap;
+  delete bpm;
+  disk_mgr->Close();
+  delete disk_mgr;
+  remove(cursor_db_file_name.c_str());
+}
+
+TEST(TableHeapTest, ParallelScanTest) {
+  const std::string parallel_db_file_name = "table_heap_parallel_test.db";
+  const int row_nums = 20000;
+  remove(parallel_db_file_name.c_str());
+  auto disk_mgr = new DiskManager(parallel_db_file_name);
+  auto bpm = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm, schema.get(), nullptr, nullptr, nullptr);
+  char characters[64];
+  for (int i = 0; i < row_nums; i++) {
+    int32_t len = RandomUtils::RandomInt(1, 64);
+    RandomUtils::RandomString(characters, len);
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, len, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  }
+  std::vector<page_id_t> page_ids;
+  table_heap->GetPageIds(&page_ids);
+  ASSERT_GE(page_ids.size(), static_cast<size_t>(4 * PARALLEL_SCAN_MORSEL_PAGES));
+  EXPECT_EQ(table_heap->GetFirstPageId(), page_ids.front());
+  // Scenario: workers scan morsels out of order, the rows still come back in page chain order.
+  for (size_t num_threads : {1, 4}) {
+    ParallelTableScan scan(table_heap, nullptr, nullptr, {}, num_threads);
+    TableScanCursor cursor(table_heap, nullptr);
+    Row row;
+    int row_count = 0;
+    while (scan.Next(&row)) {
+      ASSERT_TRUE(cursor.Next());
+      ASSERT_EQ(cursor.GetRow().GetRowId(), row.GetRowId());
+      ASSERT_EQ(CmpBool::kTrue, row.GetField(0)->CompareEquals(cursor.GetRow().GetField(0)));
+      ASSERT_EQ(CmpBool::kTrue, row.GetField(1)->CompareEquals(cursor.GetRow().GetField(1)));
+      row_count++;
+    }
+    EXPECT_FALSE(cursor.Next());
+    EXPECT_EQ(row_nums, row_count);
+  }
+
+  // Scenario: the workers filter the rows in place and return only the columns asked for.
+  {
+    Field half(TypeId::kTypeInt, row_nums / 2);
+    ParallelTableScan scan(
+        table_heap, nullptr,
+        [&half](const RowView &row) { return row.GetField(0).CompareGreaterThanEquals(half) == CmpBool::kTrue; },
+        {1, 0}, 4);
+    Row row;
+    std::unordered_set<int64_t> rids;
+    while (scan.Next(&row)) {
+      ASSERT_EQ(2u, row.GetFieldCount());
+      ASSERT_EQ(TypeId::kTypeChar, row.GetField(0)->GetTypeId());
+      ASSERT_EQ(CmpBool::kTrue, row.GetField(1)->CompareGreaterThanEquals(half));
+      ASSERT_TRUE(rids.insert(row.GetRowId().Get()).second);
+    }
+    EXPECT_EQ(static_cast<size_t>(row_nums / 2), rids.size());
+  }
+
+  // Scenario: a scan stopped halfway stops its workers and leaves no page pinned.
+  {
+    ParallelTableScan scan(table_heap, nullptr, nullptr, {}, 4);
+    Row row;
+    ASSERT_TRUE(scan.Next(&row));
+  }
+  ASSERT_TRUE(bpm->CheckAllUnpinned());
+
+  delete table_heap;
+  delete bpm;
+  disk_mgr->Close();
+  delete disk_mgr;
+  remove(parallel_db_file_name.c_str());
+}
+
+TEST(TableHeapTest, PaxFormatTest) {
+  const std::string pax_db_file_name = "table_heap_pax_test.db";
+  const int row_nums = 3000;
+  remove(pax_db_file_name.c_str());
+  auto disk_mgr = new DiskManager(pax_db_file_name);
+  auto bpm = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false),
+                                   new Column("account", TypeId::kTypeFloat, 2, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap =
+      TableHeap::Create(bpm, schema.get(), nullptr, nullptr, nullptr, TableFormat::kPaxFormat);
+  EXPECT_EQ(TableFormat::kPaxFormat, table_heap->GetFormat());
+  char characters[64];
+  std::unordered_map<int64_t, Fields> row_values;
+  auto make_fields = [&](int i) {
+    int32_t len = RandomUtils::RandomInt(0, 64);
+    RandomUtils::RandomString(characters, len);
+    return Fields{Field(TypeId::kTypeInt, i),
+                  i % 3 == 0 ? Field(TypeId::kTypeChar) : Field(TypeId::kTypeChar, characters, len, true),
+                  i % 5 == 0 ? Field(TypeId::kTypeFloat) : Field(TypeId::kTypeFloat, static_cast<float>(i))};
+  };
+  auto check_row = [&](const Row &row, const Fields &fields) {
+    for (uint32_t i = 0; i < fields.size(); i++) {
+      ASSERT_EQ(fields[i].IsNull(), row.GetField(i)->IsNull());
+      if (!fields[i].IsNull()) {
+        ASSERT_EQ(CmpBool::kTrue, row.GetField(i)->CompareEquals(fields[i]));
+      }
+    }
+  };
+
+  // Scenario: rows, nulls included, read back the same from a PAX table spread over many pages.
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields = make_fields(i);
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    row_values.emplace(row.GetRowId().Get(), fields);
+  }
+  std::vector<page_id_t> page_ids;
+  table_heap->GetPageIds(&page_ids);
+  ASSERT_GT(page_ids.size(), 1u);
+  for (auto &row_value : row_values) {
+    Row row(RowId(row_value.first));
+    ASSERT_TRUE(table_heap->GetTuple(&row, nullptr));
+    check_row(row, row_value.second);
+  }
+
+  // Scenario: updates grow and shrink the char values in place, deletes free their slots for new rows.
+  int next_id = row_nums;
+  std::vector<int64_t> rids;
+  for (auto &row_value : row_values) {
+    rids.push_back(row_value.first);
+  }
+  for (size_t i = 0; i < rids.size(); i++) {
+    if (i % 4 == 0) {
+      Fields fields = make_fields(next_id++);
+      Row row(fields);
+      ASSERT_TRUE(table_heap->UpdateTuple(row, RowId(rids[i]), nullptr));
+      row_values.erase(rids[i]);
+      row_values.emplace(row.GetRowId().Get(), fields);
+    } else if (i % 4 == 1) {
+      ASSERT_TRUE(table_heap->MarkDelete(RowId(rids[i]), nullptr));
+      table_heap->ApplyDelete(RowId(rids[i]), nullptr);
+      row_values.erase(rids[i]);
+    }
+  }
+  for (int i = 0; i < row_nums / 4; i++) {
+    Fields fields = make_fields(next_id++);
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    ASSERT_TRUE(row_values.emplace(row.GetRowId().Get(), fields).second);
+  }
+  std::vector<page_id_t> new_page_ids;
+  table_heap->GetPageIds(&new_page_ids);
+  EXPECT_EQ(page_ids.size(), new_page_ids.size());
+
+  // Scenario: the iterator and the cursor see exactly the live rows, the cursor reads single columns in place.
+  size_t row_count = 0;
+  for (auto iter = table_heap->Begin(nullptr); iter != table_heap->End(); iter++) {
+    ASSERT_TRUE(row_values.find(iter->GetRowId().Get()) != row_values.end());
+    check_row(*iter, row_values[iter->GetRowId().Get()]);
+    row_count++;
+  }
+  EXPECT_EQ(row_values.size(), row_count);
+  {
+    TableScanCursor cursor(table_heap, nullptr);
+    row_count = 0;
+    while (cursor.Next()) {
+      const RowView &view = cursor.GetRow();
+      Fields &fields = row_values[view.GetRowId().Get()];
+      ASSERT_EQ(fields[1].IsNull(), view.IsNull(1));
+      if (!fields[1].IsNull()) {
+        ASSERT_EQ(CmpBool::kTrue, view.GetField(1).CompareEquals(fields[1]));
+      }
+      Row projected;
+      view.ToRow({2, 0}, &projected);
+      ASSERT_EQ(CmpBool::kTrue, projected.GetField(1)->CompareEquals(fields[0]));
+      row_count++;
+    }
+    EXPECT_EQ(row_values.size(), row_count);
+  }
+
+  // Scenario: a PAX table without char columns reuses the slots its deletes free, it does not grow.
+  std::vector<Column *> int_columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                       new Column("account", TypeId::kTypeFloat, 1, true, false)};
+  auto int_schema = std::make_shared<Schema>(int_columns);
+  TableHeap *int_heap = TableHeap::Create(bpm, int_schema.get(), nullptr, nullptr, nullptr, TableFormat::kPaxFormat);
+  std::vector<RowId> int_rids;
+  for (int i = 0; i < row_nums * 2; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeFloat, static_cast<float>(i))};
+    Row row(fields);
+    ASSERT_TRUE(int_heap->InsertTuple(row, nullptr));
+    int_rids.push_back(row.GetRowId());
+  }
+  std::vector<page_id_t> int_page_ids;
+  int_heap->GetPageIds(&int_page_ids);
+  ASSERT_GT(int_page_ids.size(), 1u);
+  for (size_t i = 0; i < int_rids.size(); i += 2) {
+    int_heap->ApplyDelete(int_rids[i], nullptr);
+  }
+  for (size_t i = 0; i < int_rids.size(); i += 2) {
+    Fields fields{Field(TypeId::kTypeInt, -1), Field(TypeId::kTypeFloat, -1.0f)};
+    Row row(fields);
+    ASSERT_TRUE(int_heap->InsertTuple(row, nullptr));
+  }
+  std::vector<page_id_t> new_int_page_ids;
+  int_heap->GetPageIds(&new_int_page_ids);
+  EXPECT_EQ(int_page_ids.size(), new_int_page_ids.size());
+  ASSERT_TRUE(bpm->CheckAllUnpinned());
+
+  delete int_heap;
+  delete table_heap;
+  delete bpm;
+  disk_mgr->Close();
+  delete disk_mgr;
+  remove(pax_db_file_name.c_str());
+}
+
+TEST(TableHeapTest, OverflowTest) {
+  const std::string overflow_db_file_name = "table_heap_overflow_test.db";
+  const int row_nums = 60;
+  remove(overflow_db_file_name.c_str());
+  auto disk_mgr = new DiskManager(overflow_db_file_name);
+  auto bpm = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 16, 1, true, false),
+                                   new Column("doc", TypeId::kTypeChar, 8 * PAGE_SIZE, 2, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  // 每三行一行带着几页长的doc，一行短的，一行为null
+  auto make_doc = [](int id) {
+    if (id % 3 == 2) return std::string();
+    return std::string(id % 3 == 0 ? 3 * PAGE_SIZE + id : 16, static_cast<char>('a' + id % 26));
+  };
+  auto make_fields = [](int id, std::string &name, std::string &doc) {
+    Fields fields{Field(TypeId::kTypeInt, id), Field(TypeId::kTypeChar, name.data(), name.size(), true)};
+    if (doc.empty()) {
+      fields.emplace_back(TypeId::kTypeChar);
+    } else {
+      fields.emplace_back(TypeId::kTypeChar, doc.data(), doc.size(), true);
+    }
+    return fields;
+  };
+  auto fetches = [&] {
+    BufferPoolStats stats = bpm->GetStats();
+    return stats.fetch_hits_ + stats.fetch_misses_;
+  };
+  for (auto format : {TableFormat::kRowFormat, TableFormat::kPaxFormat}) {
+    TableHeap *table_heap = TableHeap::Create(bpm, schema.get(), nullptr, nullptr, nullptr, format);
+    std::vector<RowId> rids;
+    std::unordered_map<int64_t, int> ids;
+    std::vector<std::string> names;
+    std::vector<std::string> docs;
+    auto check_row = [&](const Row &row, int id) {
+      ASSERT_EQ(CmpBool::kTrue, row.GetField(0)->CompareEquals(Field(TypeId::kTypeInt, id)));
+      ASSERT_EQ(CmpBool::kTrue,
+                row.GetField(1)->CompareEquals(Field(TypeId::kTypeChar, names[id].data(), names[id].size(), false)));
+      ASSERT_EQ(docs[id].empty(), row.GetField(2)->IsNull());
+      ASSERT_FALSE(row.GetField(2)->IsOverflow());
+      if (!docs[id].empty()) {
+        ASSERT_EQ(CmpBool::kTrue,
+                  row.GetField(2)->CompareEquals(Field(TypeId::kTypeChar, docs[id].data(), docs[id].size(), false)));
+      }
+    };
+    // 行里存的doc字段，不读overflow page
+    auto stored_doc = [&](const RowId &rid) {
+      auto page = reinterpret_cast<TablePage *>(bpm->FetchPage(rid.GetPageId()));
+      Field field = page->GetRowView(rid, schema.get()).GetField(2);
+      bpm->UnpinPage(rid.GetPageId(), false);
+      return field.GetOverflowPageId();
+    };
+
+    // Scenario: rows with a value several pages long are inserted and read back whole, only their long values go to
+    // overflow pages.
+    for (int i = 0; i < row_nums; i++) {
+      names.push_back("name" + std::to_string(i));
+      docs.push_back(make_doc(i));
+      Fields fields = make_fields(i, names[i], docs[i]);
+      Row row(fields);
+      ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+      rids.push_back(row.GetRowId());
+      ids[row.GetRowId().Get()] = i;
+      EXPECT_EQ(i % 3 == 0, stored_doc(row.GetRowId()) != INVALID_PAGE_ID);
+    }
+    for (int i = 0; i < row_nums; i++) {
+      Row row(rids[i]);
+      ASSERT_TRUE(table_heap->GetTuple(&row, nullptr));
+      check_row(row, i);
+    }
+
+    // Scenario: a cursor reads the overflow pages of a value only if the column is asked for.
+    size_t before = fetches();
+    {
+      TableScanCursor cursor(table_heap, nullptr);
+      int row_count = 0;
+      while (cursor.Next()) {
+        Row projected;
+        cursor.GetRow().ToRow({0, 1}, &projected);
+        row_count++;
+      }
+      EXPECT_EQ(row_nums, row_count);
+    }
+    EXPECT_LT(fetches() - before, static_cast<size_t>(row_nums / 3));
+    {
+      TableScanCursor cursor(table_heap, nullptr);
+      while (cursor.Next()) {
+        Row row;
+        cursor.GetRow().ToRow(&row);
+        check_row(row, ids[row.GetRowId().Get()]);
+      }
+    }
+
+    // Scenario: updates and deletes free the overflow pages of the values they replace.
+    page_id_t old_doc = stored_doc(rids[0]);
+    docs[0] = "short";
+    Fields short_fields = make_fields(0, names[0], docs[0]);
+    Row short_row(short_fields);
+    ASSERT_TRUE(table_heap->UpdateTuple(short_row, rids[0], nullptr));
+    rids[0] = short_row.GetRowId();
+    EXPECT_TRUE(bpm->IsPageFree(old_doc));
+    docs[1] = std::string(5 * PAGE_SIZE, 'z');
+    Fields long_fields = make_fields(1, names[1], docs[1]);
+    Row long_row(long_fields);
+    ASSERT_TRUE(table_heap->UpdateTuple(long_row, rids[1], nullptr));
+    rids[1] = long_row.GetRowId();
+    EXPECT_NE(INVALID_PAGE_ID, stored_doc(rids[1]));
+    for (int i : {0, 1}) {
+      Row row(rids[i]);
+      ASSERT_TRUE(table_heap->GetTuple(&row, nullptr));
+      check_row(row, i);
+    }
+    old_doc = stored_doc(rids[3]);
+    ASSERT_TRUE(table_heap->MarkDelete(rids[3], nullptr));
+    EXPECT_FALSE(bpm->IsPageFree(old_doc));
+    table_heap->ApplyDelete(rids[3], nullptr);
+    EXPECT_TRUE(bpm->IsPageFree(old_doc));
+
+    // Scenario: dropping the table frees the overflow pages of its rows.
+    old_doc = stored_doc(rids[6]);
+    ASSERT_TRUE(bpm->CheckAllUnpinned());
+    table_heap->DeleteTable();
+    EXPECT_TRUE(bpm->IsPageFree(old_doc));
+    ASSERT_TRUE(bpm->CheckAllUnpinned());
+    delete table_heap;
+  }
+
+  delete bpm;
+  disk_mgr->Close();
+  delete disk_mgr;
+  remove(overflow_db_file_name.c_str());
+}
+
+TEST(TableHeapTest, PageRunTest) {
+  const std::string run_db_file_name = "table_heap_run_test.db";
+  remove(run_db_file_name.c_str());
+  auto disk_mgr = new DiskManager(run_db_file_name);
+  auto bpm = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  // Scenario: while the heap is open, the rest of its run is kept from other allocations.
+  TableHeap *table_heap = TableHeap::Create(bpm, schema.get(), nullptr, nullptr, nullptr);
+  page_id_t first_page_id = table_heap->GetFirstPageId();
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(page_id));
+  EXPECT_NE(first_page_id + 1, page_id);
+  ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  ASSERT_TRUE(bpm->DeletePage(page_id));
+  // Scenario: closing the heap without dropping it gives the unused part of the run back.
+  delete table_heap;
+  ASSERT_NE(nullptr, bpm->NewPage(page_id));
+  EXPECT_EQ(first_page_id + 1, page_id);
+  ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  delete bpm;
+  disk_mgr->Close();
+  delete disk_mgr;
+  remove(run_db_file_name.c_str());
+}